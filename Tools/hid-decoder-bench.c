@@ -0,0 +1,201 @@
+//
+//  hid-decoder-bench.c
+//  Touch Up
+//
+//  Created by Touch Up contributors on 16.10.26.
+//
+//  Times HIDReportDecoderDecodeBatch against reading X, Y, tip, valid and contact ID of every touch collection field by field
+//  with HIDReportFieldRead, for reports with 1, 2 (hybrid ELAN), 4, 5, 10 and 20 touch collections. Both paths are checked to
+//  agree before timing.
+//  Which batch path runs depends on the target: SSE2 on x86-64, NEON on arm64, scalar otherwise.
+//
+//  Build:  cc -std=c11 -O2 -I TouchUpCore -o hid-decoder-bench Tools/hid-decoder-bench.c TouchUpCore/HIDReportDecoder.c
+//  Usage:  ./hid-decoder-bench [reports]
+//
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include "HIDReportDecoder.h"
+
+
+#define kReportID       0x01
+#define kNumReports     64          // distinct reports cycled through, so the branch predictor cannot learn one
+
+
+/*
+ One finger collection of 6 bytes: tip, valid, 6 bit padding, contact ID, X and Y with 16 bits.
+ */
+static const uint8_t kFingerCollection[] = {
+    0x05, 0x0D, 0x09, 0x22, 0xA1, 0x02,     // Usage Page (Digitizer), Usage (Finger), Collection (Logical)
+    0x15, 0x00, 0x25, 0x01, 0x75, 0x01,     //   Logical Minimum (0), Maximum (1), Report Size (1)
+    0x95, 0x01, 0x09, 0x42, 0x81, 0x02,     //   Report Count (1), Usage (Tip Switch), Input (Var)
+    0x09, 0x47, 0x81, 0x02,                 //   Usage (Touch Valid), Input (Var)
+    0x95, 0x06, 0x81, 0x03,                 //   Report Count (6), Input (Const)
+    0x25, 0x3F, 0x75, 0x08, 0x95, 0x01,     //   Logical Maximum (63), Report Size (8), Count (1)
+    0x09, 0x51, 0x81, 0x02,                 //   Usage (Contact ID), Input (Var)
+    0x05, 0x01, 0x26, 0xFF, 0x0F, 0x75, 0x10,   // Usage Page (Generic Desktop), Logical Maximum (4095), Report Size (16)
+    0x09, 0x30, 0x81, 0x02,                 //   Usage (X), Input (Var)
+    0x09, 0x31, 0x81, 0x02,                 //   Usage (Y), Input (Var)
+    0xC0,                                   // End Collection
+};
+
+static const uint8_t kDescriptorHead[] = {
+    0x05, 0x0D, 0x09, 0x04, 0xA1, 0x01,     // Usage Page (Digitizer), Usage (Touch Screen), Collection (Application)
+    0x85, kReportID,                        //   Report ID
+};
+
+static const uint8_t kDescriptorTail[] = {
+    0x05, 0x0D, 0x27, 0xFF, 0xFF, 0x00, 0x00,   // Usage Page (Digitizer), Logical Maximum (65535)
+    0x75, 0x10, 0x95, 0x01,                 //   Report Size (16), Count (1)
+    0x09, 0x56, 0x81, 0x02,                 //   Usage (Scan Time), Input (Var)
+    0x25, 0x7F, 0x75, 0x08,                 //   Logical Maximum (127), Report Size (8)
+    0x09, 0x54, 0x81, 0x02,                 //   Usage (Contact Count), Input (Var)
+    0xC0,                                   // End Collection
+};
+
+
+static size_t MakeDescriptor(uint8_t *descriptor, int numCollections) {
+    size_t length = 0;
+
+    memcpy(descriptor + length, kDescriptorHead, sizeof(kDescriptorHead));
+    length += sizeof(kDescriptorHead);
+    for (int i = 0; i < numCollections; i++) {
+        memcpy(descriptor + length, kFingerCollection, sizeof(kFingerCollection));
+        length += sizeof(kFingerCollection);
+    }
+    memcpy(descriptor + length, kDescriptorTail, sizeof(kDescriptorTail));
+    length += sizeof(kDescriptorTail);
+
+    return length;
+}
+
+
+
+static double Now(void) {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec + time.tv_nsec * 1e-9;
+}
+
+
+static volatile float gSink;
+
+
+/**
+ The per element path the batch replaced: every field of every collection read on its own, X and Y normalized afterwards.
+ */
+static void DecodeFieldByField(const HIDTouchReportLayout *layout, const uint8_t *report, size_t length, HIDContactBatch *batch) {
+    batch->count = layout->numCollections;
+
+    for (uint8_t i = 0; i < layout->numCollections; i++) {
+        const HIDReportField *fields = layout->collections[i].fields;
+
+        const HIDReportField *x = &fields[HIDTouchFieldX];
+        const HIDReportField *y = &fields[HIDTouchFieldY];
+        batch->x[i] = (float)HIDReportFieldRead(x, report, length) * x->scale + x->offset;
+        batch->y[i] = (float)HIDReportFieldRead(y, report, length) * y->scale + y->offset;
+
+        batch->contactID[i] = HIDReportFieldRead(&fields[HIDTouchFieldContactID], report, length);
+        batch->tipSwitch[i] = (uint8_t)HIDReportFieldRead(&fields[HIDTouchFieldTip], report, length);
+        batch->isValid[i]   = (uint8_t)HIDReportFieldRead(&fields[HIDTouchFieldValid], report, length);
+    }
+}
+
+
+static bool BatchesAgree(const HIDContactBatch *a, const HIDContactBatch *b) {
+    if (a->count != b->count) {
+        return false;
+    }
+    for (uint8_t i = 0; i < a->count; i++) {
+        if (a->x[i] != b->x[i] || a->y[i] != b->y[i] || a->contactID[i] != b->contactID[i]
+            || a->tipSwitch[i] != b->tipSwitch[i] || a->isValid[i] != b->isValid[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+
+typedef void (*DecodeFunction)(const HIDTouchReportLayout *layout, const uint8_t *report, size_t length, HIDContactBatch *batch);
+
+static double Run(DecodeFunction decode, const HIDTouchReportLayout *layout, uint8_t reports[][256], size_t length, int numReports) {
+    HIDContactBatch batch;
+    float sum = 0;
+
+    double start = Now();
+    for (int r = 0; r < numReports; r++) {
+        decode(layout, reports[r % kNumReports], length, &batch);
+        sum += batch.x[0] + batch.y[batch.count - 1] + batch.tipSwitch[0];
+    }
+    double elapsed = Now() - start;
+
+    gSink = sum;
+    return elapsed * 1e9 / numReports;
+}
+
+
+
+int main(int argc, const char *argv[]) {
+    int numReports = argc > 1 ? atoi(argv[1]) : 2000000;
+    if (numReports <= 0) {
+        fprintf(stderr, "usage: %s [reports]\n", argv[0]);
+        return 1;
+    }
+
+#if defined(__SSE2__)
+    const char *batchPath = "SSE2";
+#elif defined(__ARM_NEON)
+    const char *batchPath = "NEON";
+#else
+    const char *batchPath = "scalar";
+#endif
+
+    static const int kContactCounts[] = { 1, 2, 4, 5, 10, 20 };
+    static uint8_t descriptor[4096];
+    static uint8_t reports[kNumReports][256];
+
+    printf("%-10s %16s %16s %10s\n", "contacts", batchPath, "field by field", "speedup");
+    for (size_t i = 0; i < sizeof(kContactCounts) / sizeof(*kContactCounts); i++) {
+        int numCollections = kContactCounts[i];
+
+        HIDReportDecoder decoder;
+        size_t descriptorLength = MakeDescriptor(descriptor, numCollections);
+        if (!HIDReportDecoderCompile(&decoder, descriptor, descriptorLength)) {
+            fprintf(stderr, "descriptor with %d collections not compiled\n", numCollections);
+            return 1;
+        }
+
+        const HIDTouchReportLayout *layout = &decoder.reports[0];
+        size_t length = layout->byteLength;
+
+        srand(numCollections);
+        for (int r = 0; r < kNumReports; r++) {
+            for (size_t b = 0; b < length; b++) {
+                reports[r][b] = (uint8_t)rand();
+            }
+            reports[r][0] = kReportID;
+
+            HIDContactBatch batch, reference;
+            HIDReportDecoderDecodeBatch(layout, reports[r], length, &batch);
+            DecodeFieldByField(layout, reports[r], length, &reference);
+            if (!BatchesAgree(&batch, &reference)) {
+                fprintf(stderr, "batch and field by field decoding differ at %d collections\n", numCollections);
+                return 1;
+            }
+        }
+
+        // untimed round for warm caches
+        Run(HIDReportDecoderDecodeBatch, layout, reports, length, numReports / 10 + 1);
+        Run(DecodeFieldByField, layout, reports, length, numReports / 10 + 1);
+
+        double batch = Run(HIDReportDecoderDecodeBatch, layout, reports, length, numReports);
+        double single = Run(DecodeFieldByField, layout, reports, length, numReports);
+        printf("%-10d %13.1f ns %13.1f ns %9.1fx\n", numCollections, batch, single, single / batch);
+    }
+    return 0;
+}
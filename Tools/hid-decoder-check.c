@@ -0,0 +1,262 @@
+//
+//  hid-decoder-check.c
+//  Touch Up
+//
+//  Created by Touch Up contributors on 16.10.26.
+//
+//  Compiles the report descriptor of an ELAN touch screen with HIDReportDecoderCompile and decodes a few reports whose
+//  content is known, field by field. Prints every mismatch, exits with 1 if there was one.
+//
+//  Build:  cc -std=c11 -O2 -I TouchUpCore -o hid-decoder-check Tools/hid-decoder-check.c TouchUpCore/HIDReportDecoder.c -lm
+//  Usage:  ./hid-decoder-check
+//
+
+#include <math.h>
+#include <stdio.h>
+#include <string.h>
+
+#include "HIDReportDecoder.h"
+
+
+/*
+ Layout of the ELAN 04F3 screens: report ID 1, five finger collections of 8 bytes each
+ (tip, in range, 6 bit padding, contact ID, X, Y, width, height), then scan time and contact count.
+ Report ID 2 is the Contact Count Maximum feature report, it must not produce a layout.
+ */
+#define FINGER_COLLECTION                                                                       \
+    0x05, 0x0D,                     /* Usage Page (Digitizer)                   */              \
+    0x09, 0x22,                     /* Usage (Finger)                           */              \
+    0xA1, 0x02,                     /* Collection (Logical)                     */              \
+    0x15, 0x00, 0x25, 0x01,         /*   Logical Minimum (0), Maximum (1)       */              \
+    0x75, 0x01, 0x95, 0x01,         /*   Report Size (1), Count (1)             */              \
+    0x09, 0x42, 0x81, 0x02,         /*   Usage (Tip Switch), Input (Var)        */              \
+    0x09, 0x32, 0x81, 0x02,         /*   Usage (In Range), Input (Var)          */              \
+    0x95, 0x06, 0x81, 0x03,         /*   Report Count (6), Input (Const)        */              \
+    0x25, 0x1F, 0x75, 0x08,         /*   Logical Maximum (31), Report Size (8)  */              \
+    0x95, 0x01,                     /*   Report Count (1)                       */              \
+    0x09, 0x51, 0x81, 0x02,         /*   Usage (Contact ID), Input (Var)        */              \
+    0x05, 0x01,                     /*   Usage Page (Generic Desktop)           */              \
+    0x75, 0x10, 0x55, 0x0E,         /*   Report Size (16), Unit Exponent (-2)   */              \
+    0x65, 0x11,                     /*   Unit (cm)                              */              \
+    0x26, 0x40, 0x0B,               /*   Logical Maximum (2880)                 */              \
+    0x35, 0x00, 0x46, 0x5C, 0x0D,   /*   Physical Minimum (0), Maximum (3420)   */              \
+    0x09, 0x30, 0x81, 0x02,         /*   Usage (X), Input (Var)                 */              \
+    0x26, 0x50, 0x06,               /*   Logical Maximum (1616)                 */              \
+    0x46, 0x89, 0x07,               /*   Physical Maximum (1929)                */              \
+    0x09, 0x31, 0x81, 0x02,         /*   Usage (Y), Input (Var)                 */              \
+    0x05, 0x0D,                     /*   Usage Page (Digitizer)                 */              \
+    0x75, 0x08, 0x26, 0xFF, 0x00,   /*   Report Size (8), Logical Maximum (255) */              \
+    0x09, 0x48, 0x81, 0x02,         /*   Usage (Width), Input (Var)             */              \
+    0x09, 0x49, 0x81, 0x02,         /*   Usage (Height), Input (Var)            */              \
+    0xC0                            /* End Collection                           */
+
+static const uint8_t kELANDescriptor[] = {
+    0x05, 0x0D,                     // Usage Page (Digitizer)
+    0x09, 0x04,                     // Usage (Touch Screen)
+    0xA1, 0x01,                     // Collection (Application)
+    0x85, 0x01,                     //   Report ID (1)
+    FINGER_COLLECTION,
+    FINGER_COLLECTION,
+    FINGER_COLLECTION,
+    FINGER_COLLECTION,
+    FINGER_COLLECTION,
+    0x05, 0x0D,                     //   Usage Page (Digitizer)
+    0x55, 0x0C, 0x66, 0x01, 0x10,   //   Unit Exponent (-4), Unit (s)
+    0x47, 0xFF, 0xFF, 0x00, 0x00,   //   Physical Maximum (65535)
+    0x27, 0xFF, 0xFF, 0x00, 0x00,   //   Logical Maximum (65535)
+    0x75, 0x10, 0x95, 0x01,         //   Report Size (16), Count (1)
+    0x09, 0x56, 0x81, 0x02,         //   Usage (Scan Time), Input (Var)
+    0x25, 0x7F, 0x75, 0x08,         //   Logical Maximum (127), Report Size (8)
+    0x09, 0x54, 0x81, 0x02,         //   Usage (Contact Count), Input (Var)
+    0x85, 0x02,                     //   Report ID (2)
+    0x25, 0x0A,                     //   Logical Maximum (10)
+    0x09, 0x55, 0xB1, 0x02,         //   Usage (Contact Count Maximum), Feature (Var)
+    0xC0,                           // End Collection
+};
+
+#define kReportLength   44          // report ID, 5 × 8 bytes, scan time, contact count
+
+
+
+typedef struct {
+    int contactID;
+    int tip;
+    int x, y;
+    int width, height;
+} Finger;
+
+
+/**
+ Writes a report the way the screen sends it.
+ */
+static void MakeReport(uint8_t report[kReportLength], const Finger *fingers, int numFingers, int scanTime, int contactCount) {
+    memset(report, 0, kReportLength);
+    report[0] = 0x01;
+
+    for (int i = 0; i < numFingers; i++) {
+        uint8_t *slot = report + 1 + i * 8;
+        slot[0] = (uint8_t)(fingers[i].tip | fingers[i].tip << 1);
+        slot[1] = (uint8_t)fingers[i].contactID;
+        slot[2] = (uint8_t)fingers[i].x;
+        slot[3] = (uint8_t)(fingers[i].x >> 8);
+        slot[4] = (uint8_t)fingers[i].y;
+        slot[5] = (uint8_t)(fingers[i].y >> 8);
+        slot[6] = (uint8_t)fingers[i].width;
+        slot[7] = (uint8_t)fingers[i].height;
+    }
+
+    report[41] = (uint8_t)scanTime;
+    report[42] = (uint8_t)(scanTime >> 8);
+    report[43] = (uint8_t)contactCount;
+}
+
+
+
+static int gNumFailures;
+
+static void ExpectInt(const char *what, long long actual, long long expected) {
+    if (actual != expected) {
+        printf("FAIL  %s: %lld, expected %lld\n", what, actual, expected);
+        gNumFailures++;
+    }
+}
+
+static void ExpectFloat(const char *what, double actual, double expected) {
+    if (fabs(actual - expected) > 1e-5) {
+        printf("FAIL  %s: %f, expected %f\n", what, actual, expected);
+        gNumFailures++;
+    }
+}
+
+
+
+static void CheckLayout(const HIDReportDecoder *decoder) {
+    ExpectInt("reports with touch data", decoder->numReports, 1);
+    ExpectInt("uses report IDs", decoder->usesReportIDs, 1);
+
+    const HIDTouchReportLayout *layout = &decoder->reports[0];
+    ExpectInt("report ID", layout->reportID, 1);
+    ExpectInt("report length", layout->byteLength, kReportLength);
+    ExpectInt("touch collections", layout->numCollections, 5);
+
+    ExpectInt("scan time offset", layout->scanTime.bitOffset, 41 * 8);
+    ExpectInt("scan time size", layout->scanTime.bitSize, 16);
+    ExpectInt("contact count offset", layout->contactCount.bitOffset, 43 * 8);
+
+    const HIDReportField *fields = layout->collections[1].fields;
+    ExpectInt("tip offset of finger 2", fields[HIDTouchFieldTip].bitOffset, 9 * 8);
+    ExpectInt("contact ID offset of finger 2", fields[HIDTouchFieldContactID].bitOffset, 10 * 8);
+    ExpectInt("X offset of finger 2", fields[HIDTouchFieldX].bitOffset, 11 * 8);
+    ExpectInt("X logical maximum", fields[HIDTouchFieldX].logicalMax, 2880);
+    ExpectInt("Y logical maximum", fields[HIDTouchFieldY].logicalMax, 1616);
+    ExpectInt("width logical maximum", fields[HIDTouchFieldWidth].logicalMax, 255);
+    ExpectInt("valid field", fields[HIDTouchFieldValid].bitSize, 0);
+
+    // the collections repeat every 8 bytes, so the batch path must not fall back to single fields
+    for (int f = 0; f < HID_BATCH_FIELD_COUNT; f++) {
+        if (f == HIDTouchFieldValid) {
+            continue;
+        }
+        char what[64];
+        snprintf(what, sizeof(what), "batch field %d uniform", f);
+        ExpectInt(what, layout->batchFields[f].isUniform, 1);
+        snprintf(what, sizeof(what), "batch field %d stride", f);
+        ExpectInt(what, layout->batchFields[f].strideBytes, 8);
+    }
+}
+
+
+static void CheckReport(const HIDReportDecoder *decoder, const char *name, const Finger *fingers, int numFingers,
+                        int scanTime, int contactCount) {
+    uint8_t report[kReportLength];
+    MakeReport(report, fingers, numFingers, scanTime, contactCount);
+
+    HIDDecodedReport decoded;
+    if (!HIDReportDecoderDecode(decoder, report, sizeof(report), &decoded)) {
+        printf("FAIL  %s: not decoded\n", name);
+        gNumFailures++;
+        return;
+    }
+
+    char what[128];
+    snprintf(what, sizeof(what), "%s: scan time", name);
+    ExpectInt(what, decoded.scanTime, scanTime);
+    snprintf(what, sizeof(what), "%s: contact count", name);
+    ExpectInt(what, decoded.contactCount, contactCount);
+    snprintf(what, sizeof(what), "%s: contacts", name);
+    ExpectInt(what, decoded.numContacts, 5);
+
+    for (int i = 0; i < 5; i++) {
+        Finger expected = i < numFingers ? fingers[i] : (Finger){ 0 };
+        const HIDDecodedContact *contact = &decoded.contacts[i];
+
+        snprintf(what, sizeof(what), "%s: finger %d contact ID", name, i + 1);
+        ExpectInt(what, contact->contactID, expected.contactID);
+        snprintf(what, sizeof(what), "%s: finger %d tip", name, i + 1);
+        ExpectInt(what, contact->tipSwitch, expected.tip);
+        snprintf(what, sizeof(what), "%s: finger %d valid", name, i + 1);
+        ExpectInt(what, contact->isValid, 0);
+        snprintf(what, sizeof(what), "%s: finger %d x", name, i + 1);
+        ExpectFloat(what, contact->x, expected.x / 2880.0);
+        snprintf(what, sizeof(what), "%s: finger %d y", name, i + 1);
+        ExpectFloat(what, contact->y, expected.y / 1616.0);
+        snprintf(what, sizeof(what), "%s: finger %d width", name, i + 1);
+        ExpectInt(what, contact->width, expected.width);
+        snprintf(what, sizeof(what), "%s: finger %d height", name, i + 1);
+        ExpectInt(what, contact->height, expected.height);
+        snprintf(what, sizeof(what), "%s: finger %d relative width", name, i + 1);
+        ExpectFloat(what, contact->relativeWidth, expected.width / 255.0);
+        snprintf(what, sizeof(what), "%s: finger %d azimuth", name, i + 1);
+        ExpectInt(what, contact->azimuth, kHIDDecoderValueAbsent);
+    }
+}
+
+
+
+int main(void) {
+    HIDReportDecoder decoder;
+    if (!HIDReportDecoderCompile(&decoder, kELANDescriptor, sizeof(kELANDescriptor))) {
+        printf("FAIL  descriptor not compiled\n");
+        return 1;
+    }
+    CheckLayout(&decoder);
+
+    Finger one[] = {
+        { 3, 1, 1440, 404, 12, 14 },
+    };
+    CheckReport(&decoder, "one finger", one, 1, 0x1234, 1);
+
+    Finger five[] = {
+        { 0, 1,    0,    0,   1,   2 },
+        { 1, 1, 2880, 1616, 255, 255 },
+        { 2, 1,  720, 1212,  40,  38 },
+        { 30, 1, 2879,   1,   7,   9 },
+        { 31, 0,  100,  200,   0,   0 },    // lifted: tip cleared, position still reported
+    };
+    CheckReport(&decoder, "five fingers", five, 5, 0xFFFF, 5);
+
+    // hybrid mode: the second report of a frame carries no contact count
+    Finger continuation[] = {
+        { 9, 1, 1000, 1000, 20, 20 },
+    };
+    CheckReport(&decoder, "continuation", continuation, 1, 0x1234, 0);
+
+    // reports that must be rejected
+    uint8_t report[kReportLength];
+    MakeReport(report, one, 1, 0, 1);
+    HIDDecodedReport decoded;
+    ExpectInt("short report decoded", HIDReportDecoderDecode(&decoder, report, kReportLength - 1, &decoded), 0);
+    report[0] = 0x02;
+    ExpectInt("feature report ID decoded", HIDReportDecoderDecode(&decoder, report, kReportLength, &decoded), 0);
+
+    // a descriptor cut off in the middle of an item
+    HIDReportDecoder truncated;
+    ExpectInt("truncated descriptor compiled", HIDReportDecoderCompile(&truncated, kELANDescriptor, 27), 0);
+
+    if (gNumFailures > 0) {
+        printf("%d checks failed\n", gNumFailures);
+        return 1;
+    }
+    printf("all checks passed\n");
+    return 0;
+}
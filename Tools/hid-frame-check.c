@@ -0,0 +1,217 @@
+//
+//  hid-frame-check.c
+//  Touch Up
+//
+//  Created by Touch Up contributors on 16.10.26.
+//
+//  Feeds sequences of decoded reports in hybrid mode (two contacts per report, like the ELAN screens) through
+//  HIDFrameAssembler and checks the frames it emits: complete frames, the empty frame when all fingers lift, a lost first
+//  partial with and without scan time, a lost later partial and late partials after a timeout.
+//  Prints every mismatch, exits with 1 if there was one.
+//
+//  Build:  cc -std=c11 -O2 -I TouchUpCore -o hid-frame-check Tools/hid-frame-check.c TouchUpCore/HIDFrameAssembler.c
+//  Usage:  ./hid-frame-check
+//
+
+#include <stdio.h>
+
+#include "HIDFrameAssembler.h"
+
+
+#define kContactsPerReport  2
+#define kMaxFrames          16
+#define kMs                 1000000ull
+
+
+typedef struct {
+    int numFrames;
+    HIDTouchFrame frames[kMaxFrames];
+} Emitted;
+
+
+static void CollectFrame(const HIDTouchFrame *frame, void *context) {
+    Emitted *emitted = context;
+    if (emitted->numFrames < kMaxFrames) {
+        emitted->frames[emitted->numFrames] = *frame;
+    }
+    emitted->numFrames++;
+}
+
+
+/**
+ Adds one partial report: `numTouching` contacts starting at `firstID`, the rest of the report are empty slots.
+ Pass kHIDDecoderValueAbsent as scan time for screens without one.
+ */
+static void AddReport(HIDFrameAssembler *assembler, Emitted *emitted, int32_t scanTime, int32_t contactCount,
+                      int firstID, int numTouching, uint64_t now) {
+    HIDDecodedReport report = { .reportID = 1, .contactCount = contactCount, .scanTime = scanTime,
+                                .numContacts = kContactsPerReport };
+
+    for (int i = 0; i < numTouching; i++) {
+        report.contacts[i] = (HIDDecodedContact){ .contactID = firstID + i, .x = 0.5f, .y = 0.5f, .tipSwitch = 1, .isValid = 1 };
+    }
+
+    HIDFrameAssemblerAddReport(assembler, &report, now, CollectFrame, emitted);
+}
+
+
+/**
+ Adds the reports of a frame of `numFingers`, leaving out the partial with index `lostPartial` (-1 for none).
+ */
+static void AddFrame(HIDFrameAssembler *assembler, Emitted *emitted, int32_t scanTime, int numFingers, int lostPartial, uint64_t now) {
+    for (int first = 0, partial = 0; first < numFingers; first += kContactsPerReport, partial++) {
+        int numTouching = numFingers - first < kContactsPerReport ? numFingers - first : kContactsPerReport;
+        if (partial != lostPartial) {
+            AddReport(assembler, emitted, scanTime, partial == 0 ? numFingers : 0, first, numTouching, now);
+        }
+    }
+}
+
+
+
+static int gNumFailures;
+
+static void ExpectInt(const char *what, long long actual, long long expected) {
+    if (actual != expected) {
+        printf("FAIL  %s: %lld, expected %lld\n", what, actual, expected);
+        gNumFailures++;
+    }
+}
+
+
+static void ExpectFrames(const char *name, const Emitted *emitted, int numFrames) {
+    char what[128];
+    snprintf(what, sizeof(what), "%s: frames", name);
+    ExpectInt(what, emitted->numFrames, numFrames);
+}
+
+
+static void ExpectFrame(const char *name, const Emitted *emitted, int index, bool isComplete, uint32_t numContacts) {
+    char what[128];
+    if (index >= emitted->numFrames) {
+        printf("FAIL  %s: frame %d not emitted\n", name, index + 1);
+        gNumFailures++;
+        return;
+    }
+    const HIDTouchFrame *frame = &emitted->frames[index];
+
+    snprintf(what, sizeof(what), "%s: frame %d complete", name, index + 1);
+    ExpectInt(what, frame->isComplete, isComplete);
+    snprintf(what, sizeof(what), "%s: frame %d contacts", name, index + 1);
+    ExpectInt(what, frame->numContacts, numContacts);
+}
+
+
+
+static void CheckCompleteFrames(int32_t scanTime) {
+    const char *name = scanTime == kHIDDecoderValueAbsent ? "complete, no scan time" : "complete";
+    HIDFrameAssembler assembler;
+    Emitted emitted = { 0 };
+    HIDFrameAssemblerInit(&assembler, kHIDFrameAssemblerDefaultTimeout);
+
+    AddFrame(&assembler, &emitted, scanTime, 4, -1, 0);
+    AddFrame(&assembler, &emitted, scanTime == kHIDDecoderValueAbsent ? scanTime : scanTime + 100, 5, -1, 8 * kMs);
+
+    ExpectFrames(name, &emitted, 2);
+    ExpectFrame(name, &emitted, 0, true, 4);
+    ExpectFrame(name, &emitted, 1, true, 5);
+}
+
+
+static void CheckLift(int32_t scanTime) {
+    const char *name = scanTime == kHIDDecoderValueAbsent ? "lift, no scan time" : "lift";
+    HIDFrameAssembler assembler;
+    Emitted emitted = { 0 };
+    HIDFrameAssemblerInit(&assembler, kHIDFrameAssemblerDefaultTimeout);
+
+    AddFrame(&assembler, &emitted, scanTime, 4, -1, 0);
+    AddReport(&assembler, &emitted, scanTime == kHIDDecoderValueAbsent ? scanTime : scanTime + 100, 0, 0, 0, 8 * kMs);
+
+    // the lift is an empty complete frame right away, it does not wait for the timeout
+    ExpectFrames(name, &emitted, 2);
+    ExpectFrame(name, &emitted, 1, true, 0);
+}
+
+
+/*
+ The first partial of the second frame is lost: its continuations have a Contact Count of 0 but touching contacts. They must
+ not become an empty complete frame, that would end every touch. They are dropped, the next frame is complete again.
+ */
+static void CheckLostFirstPartial(int32_t scanTime) {
+    const char *name = scanTime == kHIDDecoderValueAbsent ? "lost first partial, no scan time" : "lost first partial";
+    bool hasScanTime = scanTime != kHIDDecoderValueAbsent;
+    HIDFrameAssembler assembler;
+    Emitted emitted = { 0 };
+    HIDFrameAssemblerInit(&assembler, kHIDFrameAssemblerDefaultTimeout);
+
+    AddFrame(&assembler, &emitted, scanTime, 4, -1, 0);
+    AddFrame(&assembler, &emitted, hasScanTime ? scanTime + 100 : scanTime, 4, 0, 8 * kMs);
+
+    ExpectFrames(name, &emitted, 1);
+    ExpectFrame(name, &emitted, 0, true, 4);
+
+    char what[128];
+    snprintf(what, sizeof(what), "%s: dropped reports", name);
+    ExpectInt(what, assembler.numDroppedReports, 1);
+    ExpectInt("deadline without frame in progress", HIDFrameAssemblerDeadline(&assembler), 0);
+
+    AddFrame(&assembler, &emitted, hasScanTime ? scanTime + 200 : scanTime, 4, -1, 16 * kMs);
+    ExpectFrames(name, &emitted, 2);
+    ExpectFrame(name, &emitted, 1, true, 4);
+}
+
+
+static void CheckLostLaterPartial(void) {
+    const char *name = "lost later partial";
+    HIDFrameAssembler assembler;
+    Emitted emitted = { 0 };
+    HIDFrameAssemblerInit(&assembler, kHIDFrameAssemblerDefaultTimeout);
+
+    // the new scan time of the next frame ends the frame as incomplete
+    AddFrame(&assembler, &emitted, 100, 5, 1, 0);
+    AddFrame(&assembler, &emitted, 200, 5, -1, 8 * kMs);
+
+    ExpectFrames(name, &emitted, 2);
+    // 2 + the last report: its touching contact and its empty slot, the frame was still 1 short of 5
+    ExpectFrame(name, &emitted, 0, false, 4);
+    ExpectFrame(name, &emitted, 1, true, 5);
+}
+
+
+static void CheckTimeout(void) {
+    const char *name = "timeout";
+    HIDFrameAssembler assembler;
+    Emitted emitted = { 0 };
+    HIDFrameAssemblerInit(&assembler, kHIDFrameAssemblerDefaultTimeout);
+
+    AddReport(&assembler, &emitted, 100, 4, 0, 2, 0);
+    ExpectInt("timeout before the deadline", HIDFrameAssemblerCheckTimeout(&assembler, 10 * kMs, CollectFrame, &emitted), 0);
+    ExpectInt("timeout at the deadline", HIDFrameAssemblerCheckTimeout(&assembler, 25 * kMs, CollectFrame, &emitted), 1);
+
+    // the late partial of the timed out frame is dropped
+    AddReport(&assembler, &emitted, 100, 0, 2, 2, 30 * kMs);
+
+    ExpectFrames(name, &emitted, 1);
+    ExpectFrame(name, &emitted, 0, false, 2);
+    ExpectInt("timeout: dropped reports", assembler.numDroppedReports, 1);
+}
+
+
+
+int main(void) {
+    CheckCompleteFrames(100);
+    CheckCompleteFrames(kHIDDecoderValueAbsent);
+    CheckLift(100);
+    CheckLift(kHIDDecoderValueAbsent);
+    CheckLostFirstPartial(100);
+    CheckLostFirstPartial(kHIDDecoderValueAbsent);
+    CheckLostLaterPartial();
+    CheckTimeout();
+
+    if (gNumFailures > 0) {
+        printf("%d checks failed\n", gNumFailures);
+        return 1;
+    }
+    printf("all checks passed\n");
+    return 0;
+}
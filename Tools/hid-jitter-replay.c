@@ -0,0 +1,141 @@
+//
+//  hid-jitter-replay.c
+//  Touch Up
+//
+//  Created by Touch Up contributors on 16.10.26.
+//
+//  Replays a resting finger and drags of increasing speed, with sensor noise, through HIDJitterFilter with the default and the
+//  ELAN profile. Reports how many move events the filter avoids (samples held at the previously reported position, compared
+//  with the raw samples, of which every one moves), how far the reported position is from the true one, and how much the
+//  filter makes a moving finger lag behind.
+//
+//  Build:  cc -std=c11 -O2 -I TouchUpCore -o hid-jitter-replay Tools/hid-jitter-replay.c TouchUpCore/HIDJitterFilter.c -lm
+//  Usage:  ./hid-jitter-replay [report rate in Hz]
+//
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "HIDJitterFilter.h"
+
+
+#define kPanelWidth     344.0           // mm, 15.6" panel, only to print the errors in mm
+#define kNoise          0.0006          // normalized, peak, about 2.5 logical units of 4095
+
+
+// copied from HIDInterpreter.c
+#define kELANJitterFilterProfile ((HIDJitterFilterProfile){ \
+    .minCutoff = 1.5f, .beta = 20.0f, .derivativeCutoff = 1.0f, .deadband = 0.0008f })
+
+
+typedef struct {
+    const char *name;
+    double speed;                       // screen widths per second, along x
+    double duration;                    // s
+} Path;
+
+static const Path kPaths[] = {
+    { "resting",    0.0,  2.0 },
+    { "slow drag",  0.02, 2.0 },
+    { "drag",       0.2,  2.0 },
+    { "swipe",      1.0,  0.5 },
+};
+
+typedef struct {
+    const char *name;
+    HIDJitterFilterProfile profile;
+} Profile;
+
+
+
+static double Noise(void) {
+    return kNoise * (2.0 * rand() / RAND_MAX - 1.0);
+}
+
+
+typedef struct {
+    int numSamples;
+    int numRawMoves;                    // raw samples that differ from the one before
+    int numFilteredMoves;               // reported positions that differ from the one before
+    double rawError;                    // mean distance to the true position, normalized
+    double filteredError;
+    double lag;                         // s, mean distance behind the true position along the path over the speed
+} ReplayResult;
+
+
+static ReplayResult Replay(const Path *path, HIDJitterFilterProfile profile, double rate) {
+    HIDJitterFilter filter;
+    HIDJitterFilterInit(&filter, profile);
+    srand(1);
+
+    ReplayResult result = { 0 };
+    double behind = 0;
+    float lastRawX = -1, lastRawY = -1, lastX = -1, lastY = -1;
+    int numSamples = (int)(path->duration * rate);
+
+    for (int i = 0; i < numSamples; i++) {
+        double time = i / rate;
+        double trueX = 0.3 + path->speed * time;
+        double trueY = 0.5;
+
+        float rawX = (float)(trueX + Noise());
+        float rawY = (float)(trueY + Noise());
+        float x = rawX, y = rawY;
+        HIDJitterFilterApply(&filter, 0, time, &x, &y);
+
+        // the first sample passes unfiltered and starts the touch, it is no move
+        if (i > 0) {
+            result.numSamples++;
+            result.numRawMoves += rawX != lastRawX || rawY != lastRawY;
+            result.numFilteredMoves += x != lastX || y != lastY;
+            result.rawError += hypot(rawX - trueX, rawY - trueY);
+            result.filteredError += hypot(x - trueX, y - trueY);
+            behind += trueX - x;
+        }
+        lastRawX = rawX;
+        lastRawY = rawY;
+        lastX = x;
+        lastY = y;
+    }
+
+    result.rawError /= result.numSamples;
+    result.filteredError /= result.numSamples;
+    result.lag = path->speed > 0 ? behind / result.numSamples / path->speed : 0;
+    return result;
+}
+
+
+
+int main(int argc, const char *argv[]) {
+    double rate = argc > 1 ? atof(argv[1]) : 100;
+    if (rate <= 0) {
+        fprintf(stderr, "usage: %s [report rate in Hz]\n", argv[0]);
+        return 1;
+    }
+
+    const Profile profiles[] = {
+        { "default", kHIDJitterFilterDefaultProfile },
+        { "ELAN",    kELANJitterFilterProfile },
+    };
+
+    printf("%.0f Hz, errors in mm on a %.0f mm wide panel\n\n", rate, kPanelWidth);
+    printf("%-8s %-10s %8s %8s %8s %10s %10s %8s\n", "profile", "path", "raw", "moves", "avoided", "raw error", "error", "lag");
+
+    for (size_t p = 0; p < sizeof(profiles) / sizeof(*profiles); p++) {
+        for (size_t i = 0; i < sizeof(kPaths) / sizeof(*kPaths); i++) {
+            ReplayResult result = Replay(&kPaths[i], profiles[p].profile, rate);
+
+            printf("%-8s %-10s %8d %8d %7.1f%% %10.2f %10.2f", i == 0 ? profiles[p].name : "", kPaths[i].name,
+                   result.numRawMoves, result.numFilteredMoves,
+                   100.0 * (result.numRawMoves - result.numFilteredMoves) / result.numRawMoves,
+                   result.rawError * kPanelWidth, result.filteredError * kPanelWidth);
+            if (kPaths[i].speed > 0) {
+                printf(" %5.1f ms\n", result.lag * 1000);
+            } else {
+                printf(" %8s\n", "-");
+            }
+        }
+    }
+    return 0;
+}
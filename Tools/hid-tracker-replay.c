@@ -0,0 +1,342 @@
+//
+//  hid-tracker-replay.c
+//  Touch Up
+//
+//  Created by Touch Up contributors on 16.10.26.
+//
+//  Replays synthetic finger trajectories through HIDContactTracker and through the former greedy mapping (first active touch
+//  within 5%, contact by contact) and reports how often a finger changed its ID while it stayed on the surface, and the time
+//  per frame. The contacts of a frame arrive in a random order, like the partial reports of hybrid mode, and carry a little
+//  sensor noise.
+//
+//  Build:  cc -std=c11 -O2 -I TouchUpCore -o hid-tracker-replay Tools/hid-tracker-replay.c TouchUpCore/HIDContactTracker.c -lm
+//  Usage:  ./hid-tracker-replay [repetitions]
+//
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "HIDContactTracker.h"
+
+
+#define kMaxFingers         5
+#define kNoise              0.001f      // normalized, about 0.3 mm on a 15" panel
+
+
+typedef struct {
+    const char *name;
+    int numFingers;
+    int numFrames;
+    void (*position)(int finger, int frame, float *x, float *y);
+} Scenario;
+
+
+/*
+ Two fingers sliding past each other on nearly the same line, 2% apart at the closest point.
+ */
+static void Crossing(int finger, int frame, float *x, float *y) {
+    float t = frame * 0.01f;
+    *x = finger == 0 ? 0.3f + t : 0.7f - t;
+    *y = finger == 0 ? 0.50f : 0.52f;
+}
+
+/*
+ Two fingers 4% apart swiping at 3% per frame, almost the gate per frame.
+ */
+static void FastSwipe(int finger, int frame, float *x, float *y) {
+    *x = 0.1f + frame * 0.03f;
+    *y = 0.4f + finger * 0.04f;
+}
+
+/*
+ Pinch: two fingers close from 30% to 2% apart and open again.
+ */
+static void Pinch(int finger, int frame, float *x, float *y) {
+    float distance = 0.02f + 0.28f * fabsf(1.0f - frame / 20.0f);
+    *x = 0.5f + (finger == 0 ? -0.5f : 0.5f) * distance;
+    *y = 0.5f + (finger == 0 ? -0.2f : 0.2f) * distance;
+}
+
+/*
+ Five fingers 3% apart dragging diagonally at 2% per frame.
+ */
+static void FiveFingerDrag(int finger, int frame, float *x, float *y) {
+    *x = 0.2f + finger * 0.03f + frame * 0.02f;
+    *y = 0.2f + frame * 0.015f + (finger % 2) * 0.01f;
+}
+
+static const Scenario kScenarios[] = {
+    { "crossing",       2, 41, Crossing },
+    { "fast swipe",     2, 28, FastSwipe },
+    { "pinch",          2, 41, Pinch },
+    { "5 finger drag",  5, 30, FiveFingerDrag },
+};
+
+
+
+static double Now(void) {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec + time.tv_nsec * 1e-9;
+}
+
+
+static float Noise(void) {
+    return kNoise * (2.0f * rand() / (float)RAND_MAX - 1.0f);
+}
+
+
+
+#pragma mark - Greedy Mapping
+
+/*
+ The mapping HIDContactTracker replaced, with its reuse of ended IDs and the reset once all touches ended.
+ */
+
+#define kGreedyThreshold 0.05f
+
+typedef struct {
+    int32_t id;
+    float x, y;
+    bool isActive;
+} GreedySlot;
+
+typedef struct {
+    GreedySlot slots[HID_TRACKER_MAX_SLOTS];
+    int32_t nextID;
+} GreedyMapper;
+
+
+static void GreedyReset(GreedyMapper *mapper) {
+    for (int i = 0; i < HID_TRACKER_MAX_SLOTS; i++) {
+        mapper->slots[i] = (GreedySlot){ .id = -1, .x = -1, .y = -1 };
+    }
+    mapper->nextID = 0;
+}
+
+
+static int32_t GreedyMap(GreedyMapper *mapper, int32_t hardwareID, float x, float y) {
+    if (x < 0 || y < 0 || x > 1 || y > 1) {
+        return hardwareID;
+    }
+
+    bool isAnyActive = false;
+    for (int i = 0; i < HID_TRACKER_MAX_SLOTS; i++) {
+        isAnyActive |= mapper->slots[i].isActive;
+    }
+    if (!isAnyActive) {
+        GreedyReset(mapper);
+    }
+
+    for (int i = 0; i < HID_TRACKER_MAX_SLOTS; i++) {
+        GreedySlot *slot = &mapper->slots[i];
+        if (slot->isActive && sqrtf((slot->x - x) * (slot->x - x) + (slot->y - y) * (slot->y - y)) < kGreedyThreshold) {
+            slot->x = x;
+            slot->y = y;
+            return slot->id;
+        }
+    }
+
+    for (int i = 0; i < HID_TRACKER_MAX_SLOTS; i++) {
+        GreedySlot *slot = &mapper->slots[i];
+        if (!slot->isActive && slot->id != -1) {
+            *slot = (GreedySlot){ slot->id, x, y, true };
+            return slot->id;
+        }
+    }
+
+    int32_t id = mapper->nextID++;
+    for (int i = 0; i < HID_TRACKER_MAX_SLOTS; i++) {
+        GreedySlot *slot = &mapper->slots[i];
+        if (!slot->isActive) {
+            *slot = (GreedySlot){ id, x, y, true };
+            return id;
+        }
+    }
+    return hardwareID;
+}
+
+
+static void GreedyRelease(GreedyMapper *mapper, int32_t id) {
+    for (int i = 0; i < HID_TRACKER_MAX_SLOTS; i++) {
+        if (mapper->slots[i].id == id && mapper->slots[i].isActive) {
+            mapper->slots[i].isActive = false;
+            return;
+        }
+    }
+}
+
+
+
+#pragma mark - Replay
+
+/*
+ All frames of all repetitions are generated up front, the replays only assign IDs and are timed as a whole. The switches are
+ counted afterwards.
+ */
+typedef struct {
+    int numFrames;                  // all repetitions
+    int numFingers;
+    HIDDecodedContact *contacts;    // numFingers per frame, in report order
+    int *fingerOfContact;           // maps the contacts back to the fingers
+    int32_t *ids;                   // numFingers per frame, filled in by a replay
+} Replay;
+
+
+static void MakeReplay(const Scenario *scenario, int repetitions, Replay *replay) {
+    int n = scenario->numFingers;
+    replay->numFrames = repetitions * scenario->numFrames;
+    replay->numFingers = n;
+    replay->contacts = malloc(sizeof(HIDDecodedContact) * n * replay->numFrames);
+    replay->fingerOfContact = malloc(sizeof(int) * n * replay->numFrames);
+    replay->ids = malloc(sizeof(int32_t) * n * replay->numFrames);
+
+    for (int f = 0; f < replay->numFrames; f++) {
+        int frame = f % scenario->numFrames;
+        bool isLift = frame == scenario->numFrames - 1;
+        HIDDecodedContact *contacts = &replay->contacts[f * n];
+        int *fingerOfContact = &replay->fingerOfContact[f * n];
+
+        for (int i = 0; i < n; i++) {
+            fingerOfContact[i] = i;
+        }
+        for (int i = n - 1; i > 0; i--) {
+            int j = rand() % (i + 1);
+            int swap = fingerOfContact[i];
+            fingerOfContact[i] = fingerOfContact[j];
+            fingerOfContact[j] = swap;
+        }
+
+        for (int i = 0; i < n; i++) {
+            float x, y;
+            scenario->position(fingerOfContact[i], isLift ? frame - 1 : frame, &x, &y);
+            contacts[i] = (HIDDecodedContact){
+                .contactID = i,         // hybrid mode: the hardware ID says nothing about the finger
+                .x = x + Noise(),
+                .y = y + Noise(),
+                .tipSwitch = !isLift,
+                .isValid = 1,
+            };
+        }
+    }
+}
+
+
+static void FreeReplay(Replay *replay) {
+    free(replay->contacts);
+    free(replay->fingerOfContact);
+    free(replay->ids);
+}
+
+
+/**
+ Share of finger-frames whose ID differs from the frame before, while the finger stays on the surface.
+ */
+static double SwitchRate(const Replay *replay) {
+    int n = replay->numFingers;
+    int32_t lastID[kMaxFingers];
+    uint64_t numSamples = 0, numSwitches = 0;
+
+    for (int i = 0; i < n; i++) {
+        lastID[i] = kHIDContactTrackerNoID;
+    }
+
+    for (int f = 0; f < replay->numFrames; f++) {
+        for (int i = 0; i < n; i++) {
+            int finger = replay->fingerOfContact[f * n + i];
+            int32_t id = replay->ids[f * n + i];
+
+            if (!replay->contacts[f * n + i].tipSwitch) {
+                lastID[finger] = kHIDContactTrackerNoID;
+                continue;
+            }
+            if (lastID[finger] != kHIDContactTrackerNoID) {
+                numSamples++;
+                numSwitches += id != lastID[finger];
+            }
+            lastID[finger] = id;
+        }
+    }
+    return numSamples ? (double)numSwitches / numSamples : 0;
+}
+
+
+/**
+ Returns ns per frame. Contacts lifting off release their touch, like the HID interpreter does.
+ */
+static double ReplayTracker(Replay *replay) {
+    HIDContactTracker tracker;
+    HIDContactTrackerInit(&tracker, kHIDContactTrackerDefaultGate);
+    int n = replay->numFingers;
+
+    double start = Now();
+    for (int f = 0; f < replay->numFrames; f++) {
+        const HIDDecodedContact *contacts = &replay->contacts[f * n];
+        int32_t *ids = &replay->ids[f * n];
+
+        HIDContactTrackerAssign(&tracker, contacts, n, ids);
+        for (int i = 0; i < n; i++) {
+            if (!contacts[i].tipSwitch && ids[i] != kHIDContactTrackerNoID) {
+                HIDContactTrackerRelease(&tracker, ids[i]);
+            }
+        }
+    }
+    return (Now() - start) * 1e9 / replay->numFrames;
+}
+
+
+static double ReplayGreedy(Replay *replay) {
+    GreedyMapper mapper;
+    GreedyReset(&mapper);
+    int n = replay->numFingers;
+
+    double start = Now();
+    for (int f = 0; f < replay->numFrames; f++) {
+        const HIDDecodedContact *contacts = &replay->contacts[f * n];
+        int32_t *ids = &replay->ids[f * n];
+
+        for (int i = 0; i < n; i++) {
+            ids[i] = GreedyMap(&mapper, contacts[i].contactID, contacts[i].x, contacts[i].y);
+            if (!contacts[i].tipSwitch) {
+                GreedyRelease(&mapper, ids[i]);
+            }
+        }
+    }
+    return (Now() - start) * 1e9 / replay->numFrames;
+}
+
+
+
+int main(int argc, const char *argv[]) {
+    int repetitions = argc > 1 ? atoi(argv[1]) : 2000;
+    if (repetitions <= 0) {
+        fprintf(stderr, "usage: %s [repetitions]\n", argv[0]);
+        return 1;
+    }
+
+    printf("%-15s %22s %22s\n", "", "tracker", "greedy");
+    printf("%-15s %11s %10s %11s %10s\n", "scenario", "ID switches", "ns/frame", "ID switches", "ns/frame");
+
+    for (size_t i = 0; i < sizeof(kScenarios) / sizeof(*kScenarios); i++) {
+        Replay replay;
+        srand((unsigned)i + 1);
+        MakeReplay(&kScenarios[i], repetitions, &replay);
+
+        // the greedy mapping runs first and once untimed, so neither profits from warmer caches
+        ReplayGreedy(&replay);
+        double greedyTime = ReplayGreedy(&replay);
+        double greedyRate = SwitchRate(&replay);
+
+        double trackerTime = ReplayTracker(&replay);
+        double trackerRate = SwitchRate(&replay);
+
+        printf("%-15s %10.2f%% %10.1f %10.2f%% %10.1f\n", kScenarios[i].name,
+               100.0 * trackerRate, trackerTime, 100.0 * greedyRate, greedyTime);
+        FreeReplay(&replay);
+    }
+    return 0;
+}
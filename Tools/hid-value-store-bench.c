@@ -0,0 +1,237 @@
+//
+//  hid-value-store-bench.c
+//  Touch Up
+//
+//  Created by Touch Up contributors on 16.10.26.
+//
+//  Times the queue path of one report at 1, 5 and 10 contacts: every value of the report is stored by cookie, then each touch
+//  collection is read back for dispatch. HIDValueStore is compared with a stand-in for the former gStoredInputValues:
+//  a hash table whose key and value are boxed on the heap for every store, and whose key is boxed again for every lookup,
+//  like the CFNumbers of the CFMutableDictionary.
+//
+//  Build:  cc -std=c11 -O2 -I TouchUpCore -o hid-value-store-bench Tools/hid-value-store-bench.c TouchUpCore/HIDValueStore.c
+//  Usage:  ./hid-value-store-bench [reports]
+//
+
+#define _POSIX_C_SOURCE 199309L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+
+#include "HIDValueStore.h"
+
+
+#define kFieldsPerCollection    7           // X, Y, tip, valid, contact ID, width, height
+#define kCookiesPerCollection   9           // the finger collection and padding have cookies too
+#define kFirstCollectionCookie  16
+#define kContactCountCookie     3
+#define kScanTimeCookie         4
+
+static const HIDTouchField kFields[kFieldsPerCollection] = {
+    HIDTouchFieldX, HIDTouchFieldY, HIDTouchFieldTip, HIDTouchFieldValid, HIDTouchFieldContactID, HIDTouchFieldWidth, HIDTouchFieldHeight
+};
+
+
+static uint32_t CookieOf(int collection, int field) {
+    return kFirstCollectionCookie + collection * kCookiesPerCollection + field;
+}
+
+
+static double Now(void) {
+    struct timespec time;
+    clock_gettime(CLOCK_MONOTONIC, &time);
+    return time.tv_sec + time.tv_nsec * 1e-9;
+}
+
+
+static volatile float gSink;
+
+
+
+#pragma mark - Boxed Store
+
+#define kBuckets 64
+
+typedef struct Entry {
+    int64_t *key;
+    int64_t *value;
+    struct Entry *next;
+} Entry;
+
+typedef struct {
+    Entry *buckets[kBuckets];
+} BoxedStore;
+
+
+static int64_t *Box(int64_t value) {
+    int64_t *box = malloc(sizeof(int64_t));
+    *box = value;
+    return box;
+}
+
+
+static void BoxedStoreSet(BoxedStore *store, uint32_t cookie, int64_t value) {
+    int64_t *key = Box(cookie);
+    Entry **bucket = &store->buckets[cookie % kBuckets];
+
+    for (Entry *entry = *bucket; entry; entry = entry->next) {
+        if (*entry->key == *key) {
+            free(entry->key);
+            free(entry->value);
+            entry->key = key;
+            entry->value = Box(value);
+            return;
+        }
+    }
+
+    Entry *entry = malloc(sizeof(Entry));
+    *entry = (Entry){ key, Box(value), *bucket };
+    *bucket = entry;
+}
+
+
+static bool BoxedStoreGet(const BoxedStore *store, uint32_t cookie, int64_t *value) {
+    int64_t *key = Box(cookie);
+    bool found = false;
+
+    for (Entry *entry = store->buckets[cookie % kBuckets]; entry; entry = entry->next) {
+        if (*entry->key == *key) {
+            *value = *entry->value;
+            found = true;
+            break;
+        }
+    }
+
+    free(key);
+    return found;
+}
+
+
+static void BoxedStoreDestroy(BoxedStore *store) {
+    for (int i = 0; i < kBuckets; i++) {
+        Entry *entry = store->buckets[i];
+        while (entry) {
+            Entry *next = entry->next;
+            free(entry->key);
+            free(entry->value);
+            free(entry);
+            entry = next;
+        }
+    }
+}
+
+
+
+#pragma mark - Benchmark
+
+static int64_t ValueOf(int report, int collection, int field) {
+    return (report * 7 + collection * 131 + field * 17) & 0x7FF;
+}
+
+
+static double RunValueStore(int numContacts, int numReports) {
+    HIDValueStore store = { 0 };
+    HIDValueStoreCreate(&store, CookieOf(numContacts, 0));
+
+    HIDTouchCollectionMap maps[HID_DECODER_MAX_COLLECTIONS];
+    for (int c = 0; c < numContacts; c++) {
+        HIDTouchCollectionMapInit(&maps[c]);
+        for (int f = 0; f < kFieldsPerCollection; f++) {
+            maps[c].slots[kFields[f]] = CookieOf(c, f);
+        }
+        HIDTouchCollectionMapSetRange(&maps[c], HIDTouchFieldX, 0, 2047);
+        HIDTouchCollectionMapSetRange(&maps[c], HIDTouchFieldY, 0, 2047);
+        HIDTouchCollectionMapSetRange(&maps[c], HIDTouchFieldWidth, 0, 255);
+        HIDTouchCollectionMapSetRange(&maps[c], HIDTouchFieldHeight, 0, 255);
+    }
+
+    double start = Now();
+    float sum = 0;
+
+    for (int r = 0; r < numReports; r++) {
+        HIDValueStoreSet(&store, kContactCountCookie, numContacts);
+        HIDValueStoreSet(&store, kScanTimeCookie, r);
+        for (int c = 0; c < numContacts; c++) {
+            for (int f = 0; f < kFieldsPerCollection; f++) {
+                HIDValueStoreSet(&store, CookieOf(c, f), ValueOf(r, c, f));
+            }
+        }
+
+        int64_t value = 0;
+        HIDValueStoreGet(&store, kContactCountCookie, &value);
+        sum += value;
+        for (int c = 0; c < numContacts; c++) {
+            HIDDecodedContact contact;
+            HIDValueStoreReadContact(&store, &maps[c], &contact);
+            sum += contact.x + contact.y + contact.contactID;
+        }
+        HIDValueStoreBeginFrame(&store);
+    }
+
+    double elapsed = Now() - start;
+    gSink = sum;
+    HIDValueStoreDestroy(&store);
+    return elapsed * 1e9 / numReports;
+}
+
+
+static double RunBoxedStore(int numContacts, int numReports) {
+    BoxedStore store = { 0 };
+
+    double start = Now();
+    float sum = 0;
+
+    for (int r = 0; r < numReports; r++) {
+        BoxedStoreSet(&store, kContactCountCookie, numContacts);
+        BoxedStoreSet(&store, kScanTimeCookie, r);
+        for (int c = 0; c < numContacts; c++) {
+            for (int f = 0; f < kFieldsPerCollection; f++) {
+                BoxedStoreSet(&store, CookieOf(c, f), ValueOf(r, c, f));
+            }
+        }
+
+        int64_t value = 0;
+        BoxedStoreGet(&store, kContactCountCookie, &value);
+        sum += value;
+        for (int c = 0; c < numContacts; c++) {
+            // the former dispatch looked up every field of the collection, converting X and Y like ReadContact
+            int64_t fields[kFieldsPerCollection];
+            for (int f = 0; f < kFieldsPerCollection; f++) {
+                fields[f] = BoxedStoreGet(&store, CookieOf(c, f), &value) ? value : 0;
+            }
+            sum += fields[0] / 2047.0f + fields[1] / 2047.0f + fields[4];
+        }
+    }
+
+    double elapsed = Now() - start;
+    gSink = sum;
+    BoxedStoreDestroy(&store);
+    return elapsed * 1e9 / numReports;
+}
+
+
+
+int main(int argc, const char *argv[]) {
+    int numReports = argc > 1 ? atoi(argv[1]) : 200000;
+    if (numReports <= 0) {
+        fprintf(stderr, "usage: %s [reports]\n", argv[0]);
+        return 1;
+    }
+
+    static const int kContactCounts[] = { 1, 5, 10 };
+
+    printf("%-10s %16s %16s %10s\n", "contacts", "value store", "boxed store", "speedup");
+    for (size_t i = 0; i < sizeof(kContactCounts) / sizeof(*kContactCounts); i++) {
+        int numContacts = kContactCounts[i];
+
+        // one untimed round each, so both start with warm caches and a grown heap
+        RunValueStore(numContacts, numReports / 10 + 1);
+        RunBoxedStore(numContacts, numReports / 10 + 1);
+
+        double store = RunValueStore(numContacts, numReports);
+        double boxed = RunBoxedStore(numContacts, numReports);
+        printf("%-10d %13.1f ns %13.1f ns %9.1fx\n", numContacts, store, boxed, boxed / store);
+    }
+    return 0;
+}
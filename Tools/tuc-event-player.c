@@ -0,0 +1,395 @@
+//
+//  tuc-event-player.c
+//  Touch Up
+//
+//  Created by Touch Up contributors on 16.10.26.
+//
+//  Reads a recording of TUCFileEventSink and prints its events, or on Linux plays them back in real time through a uinput
+//  device: moves and drags as absolute pointer positions, left and right button, scrolls as (high resolution) wheel steps.
+//  Magnifications have no uinput counterpart and are skipped. The recorded positions are macOS screen coordinates, the size of
+//  the recorded screen maps them onto the absolute axes (by default the largest recorded position).
+//
+//  Build:  cc -std=c11 -O2 -I TouchUpCore -o tuc-event-player Tools/tuc-event-player.c
+//  Usage:  ./tuc-event-player recording.tuce                 prints the events
+//          ./tuc-event-player -p [-s 1920x1080] recording.tuce   plays them through /dev/uinput (Linux, needs write access)
+//
+
+#define _POSIX_C_SOURCE 200112L
+
+#include <errno.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef __linux__
+#include <fcntl.h>
+#include <linux/uinput.h>
+#include <sys/ioctl.h>
+#include <unistd.h>
+#endif
+
+
+/*
+ The recording format of TUCEventSink.h, which is Objective-C: header of three uint32_t, then the records.
+ */
+#define kTUCEventRecordingMagic     0x45435554  // "TUCE"
+#define kTUCEventRecordingVersion   1
+#define kTUCOutputEventMagnify      29
+
+typedef struct {
+    uint64_t timestamp;             // ns on the mach_absolute_time timeline
+    uint32_t type;                  // CGEventType, kCGEventScrollWheel or kTUCOutputEventMagnify
+    int32_t value;                  // click state of a mouse event, NSTouchPhase of a magnification
+    double x, y;                    // location in screen coordinates, translation of a scroll
+    double magnification;
+} TUCOutputEvent;
+
+// CGEventType
+enum {
+    kLeftMouseDown      = 1,
+    kLeftMouseUp        = 2,
+    kRightMouseDown     = 3,
+    kRightMouseUp       = 4,
+    kMouseMoved         = 5,
+    kLeftMouseDragged   = 6,
+    kRightMouseDragged  = 7,
+    kScrollWheel        = 22,
+};
+
+
+static const char *TypeName(uint32_t type) {
+    switch (type) {
+        case kLeftMouseDown:        return "left down";
+        case kLeftMouseUp:          return "left up";
+        case kRightMouseDown:       return "right down";
+        case kRightMouseUp:         return "right up";
+        case kMouseMoved:           return "move";
+        case kLeftMouseDragged:     return "left drag";
+        case kRightMouseDragged:    return "right drag";
+        case kScrollWheel:          return "scroll";
+        case kTUCOutputEventMagnify: return "magnify";
+        default:                    return "unknown";
+    }
+}
+
+
+static bool IsPointerEvent(uint32_t type) {
+    return type != kScrollWheel && type != kTUCOutputEventMagnify;
+}
+
+
+
+/**
+ Reads all records, returns NULL after printing why not.
+ */
+static TUCOutputEvent *ReadRecording(const char *path, size_t *count) {
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        fprintf(stderr, "%s: %s\n", path, strerror(errno));
+        return NULL;
+    }
+
+    uint32_t header[3];
+    if (fread(header, sizeof(header), 1, file) != 1 || header[0] != kTUCEventRecordingMagic) {
+        fprintf(stderr, "%s: no event recording%s\n", path,
+                header[0] == __builtin_bswap32(kTUCEventRecordingMagic) ? " of this byte order" : "");
+        fclose(file);
+        return NULL;
+    }
+    if (header[1] != kTUCEventRecordingVersion || header[2] != sizeof(TUCOutputEvent)) {
+        fprintf(stderr, "%s: version %u with records of %u bytes, expected version %u with %zu bytes\n", path,
+                header[1], header[2], kTUCEventRecordingVersion, sizeof(TUCOutputEvent));
+        fclose(file);
+        return NULL;
+    }
+
+    size_t capacity = 4096;
+    TUCOutputEvent *events = malloc(capacity * sizeof(TUCOutputEvent));
+    *count = 0;
+
+    while (events && fread(&events[*count], sizeof(TUCOutputEvent), 1, file) == 1) {
+        if (++*count == capacity) {
+            capacity *= 2;
+            TUCOutputEvent *grown = realloc(events, capacity * sizeof(TUCOutputEvent));
+            if (!grown) {
+                free(events);
+            }
+            events = grown;
+        }
+    }
+    if (!events) {
+        fprintf(stderr, "%s: out of memory\n", path);
+    }
+
+    fclose(file);
+    return events;
+}
+
+
+
+#pragma mark - Dump
+
+static void Dump(const TUCOutputEvent *events, size_t count) {
+    size_t numPerType[32] = { 0 };
+
+    for (size_t i = 0; i < count; i++) {
+        const TUCOutputEvent *event = &events[i];
+        double time = (event->timestamp - events[0].timestamp) / 1e6;
+
+        printf("%10.3f ms  %-10s %3d  %9.2f %9.2f", time, TypeName(event->type), event->value, event->x, event->y);
+        if (event->type == kTUCOutputEventMagnify) {
+            printf("  %+.4f", event->magnification);
+        }
+        printf("\n");
+
+        numPerType[event->type < 32 ? event->type : 0]++;
+    }
+
+    printf("\n%zu events", count);
+    if (count > 1) {
+        printf(" in %.3f s", (events[count - 1].timestamp - events[0].timestamp) / 1e9);
+    }
+    printf("\n");
+    for (uint32_t type = 0; type < 32; type++) {
+        if (numPerType[type] > 0) {
+            printf("  %-10s %zu\n", type == 0 ? "unknown" : TypeName(type), numPerType[type]);
+        }
+    }
+}
+
+
+
+#pragma mark - uinput
+
+#ifdef __linux__
+
+#define kAbsMax             65535
+#define kPixelsPerNotch     40.0        // roughly what one wheel notch scrolls on macOS
+#define kHiResPerNotch      120         // REL_WHEEL_HI_RES units of one notch
+
+typedef struct {
+    int fd;
+    double width, height;               // recorded screen, mapped onto 0...kAbsMax
+    double wheelRemainder[2];           // hi-res units not sent yet, vertical and horizontal
+    int    hiResRemainder[2];           // hi-res units sent since the last full notch
+} Player;
+
+
+static void Emit(int fd, uint16_t type, uint16_t code, int32_t value) {
+    struct input_event event = { .type = type, .code = code, .value = value };
+    if (write(fd, &event, sizeof(event)) != sizeof(event)) {
+        perror("uinput write");
+    }
+}
+
+
+static int OpenDevice(void) {
+    int fd = open("/dev/uinput", O_WRONLY | O_NONBLOCK);
+    if (fd < 0) {
+        perror("/dev/uinput");
+        return -1;
+    }
+
+    ioctl(fd, UI_SET_EVBIT, EV_KEY);
+    ioctl(fd, UI_SET_KEYBIT, BTN_LEFT);
+    ioctl(fd, UI_SET_KEYBIT, BTN_RIGHT);
+    ioctl(fd, UI_SET_EVBIT, EV_REL);
+    ioctl(fd, UI_SET_RELBIT, REL_WHEEL);
+    ioctl(fd, UI_SET_RELBIT, REL_HWHEEL);
+#ifdef REL_WHEEL_HI_RES
+    ioctl(fd, UI_SET_RELBIT, REL_WHEEL_HI_RES);
+    ioctl(fd, UI_SET_RELBIT, REL_HWHEEL_HI_RES);
+#endif
+    ioctl(fd, UI_SET_EVBIT, EV_ABS);
+    ioctl(fd, UI_SET_PROPBIT, INPUT_PROP_POINTER);
+
+    for (int axis = ABS_X; axis <= ABS_Y; axis++) {
+        struct uinput_abs_setup abs = { .code = axis, .absinfo = { .minimum = 0, .maximum = kAbsMax } };
+        if (ioctl(fd, UI_ABS_SETUP, &abs) < 0) {
+            perror("UI_ABS_SETUP");
+            close(fd);
+            return -1;
+        }
+    }
+
+    struct uinput_setup setup = { .id = { .bustype = BUS_VIRTUAL, .vendor = 0x1234, .product = 0x5455 } };
+    snprintf(setup.name, UINPUT_MAX_NAME_SIZE, "Touch Up replay");
+    if (ioctl(fd, UI_DEV_SETUP, &setup) < 0 || ioctl(fd, UI_DEV_CREATE) < 0) {
+        perror("uinput device");
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+
+static int32_t AbsValue(double position, double size) {
+    double value = position / size * kAbsMax;
+    return (int32_t)(value < 0 ? 0 : value > kAbsMax ? kAbsMax : value + 0.5);
+}
+
+
+/**
+ Sends the wheel steps of a scroll translation in pixels along one axis (0 vertical, 1 horizontal).
+ */
+static void Scroll(Player *player, int axis, double pixels) {
+    player->wheelRemainder[axis] += pixels / kPixelsPerNotch * kHiResPerNotch;
+    int hiRes = (int)player->wheelRemainder[axis];
+    if (hiRes == 0) {
+        return;
+    }
+    player->wheelRemainder[axis] -= hiRes;
+
+#ifdef REL_WHEEL_HI_RES
+    Emit(player->fd, EV_REL, axis == 0 ? REL_WHEEL_HI_RES : REL_HWHEEL_HI_RES, hiRes);
+#endif
+
+    // the classic wheel axis gets a step per full notch
+    player->hiResRemainder[axis] += hiRes;
+    int notches = player->hiResRemainder[axis] / kHiResPerNotch;
+    if (notches != 0) {
+        player->hiResRemainder[axis] -= notches * kHiResPerNotch;
+        Emit(player->fd, EV_REL, axis == 0 ? REL_WHEEL : REL_HWHEEL, notches);
+    }
+}
+
+
+static void PlayEvent(Player *player, const TUCOutputEvent *event) {
+    if (IsPointerEvent(event->type)) {
+        Emit(player->fd, EV_ABS, ABS_X, AbsValue(event->x, player->width));
+        Emit(player->fd, EV_ABS, ABS_Y, AbsValue(event->y, player->height));
+    }
+
+    switch (event->type) {
+        case kLeftMouseDown:    Emit(player->fd, EV_KEY, BTN_LEFT, 1);  break;
+        case kLeftMouseUp:      Emit(player->fd, EV_KEY, BTN_LEFT, 0);  break;
+        case kRightMouseDown:   Emit(player->fd, EV_KEY, BTN_RIGHT, 1); break;
+        case kRightMouseUp:     Emit(player->fd, EV_KEY, BTN_RIGHT, 0); break;
+
+        case kScrollWheel:
+            Scroll(player, 0, event->y);
+            Scroll(player, 1, event->x);
+            break;
+    }
+
+    Emit(player->fd, EV_SYN, SYN_REPORT, 0);
+}
+
+
+static void SleepUntil(const struct timespec *start, uint64_t offset) {
+    struct timespec deadline = {
+        .tv_sec  = start->tv_sec + (time_t)(offset / 1000000000ull),
+        .tv_nsec = start->tv_nsec + (long)(offset % 1000000000ull),
+    };
+    if (deadline.tv_nsec >= 1000000000L) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000L;
+    }
+    while (clock_nanosleep(CLOCK_MONOTONIC, TIMER_ABSTIME, &deadline, NULL) == EINTR) {
+    }
+}
+
+
+static int Play(const TUCOutputEvent *events, size_t count, double width, double height) {
+    if (width <= 0 || height <= 0) {
+        // the largest recorded position, the recorded screen is at least that large
+        for (size_t i = 0; i < count; i++) {
+            if (IsPointerEvent(events[i].type)) {
+                width = events[i].x > width ? events[i].x : width;
+                height = events[i].y > height ? events[i].y : height;
+            }
+        }
+        width = width > 0 ? width : 1;
+        height = height > 0 ? height : 1;
+    }
+
+    Player player = { .fd = OpenDevice(), .width = width, .height = height };
+    if (player.fd < 0) {
+        return 1;
+    }
+    printf("playing %zu events on a %.0f x %.0f screen\n", count, width, height);
+
+    // the desktop needs a moment to pick up the new device
+    sleep(1);
+
+    size_t numSkipped = 0;
+    struct timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+
+    for (size_t i = 0; i < count; i++) {
+        if (events[i].type == kTUCOutputEventMagnify) {
+            numSkipped++;
+            continue;
+        }
+        SleepUntil(&start, events[i].timestamp - events[0].timestamp);
+        PlayEvent(&player, &events[i]);
+    }
+
+    if (numSkipped > 0) {
+        printf("skipped %zu magnify events\n", numSkipped);
+    }
+
+    ioctl(player.fd, UI_DEV_DESTROY);
+    close(player.fd);
+    return 0;
+}
+
+#endif
+
+
+
+int main(int argc, char *argv[]) {
+    bool shouldPlay = false;
+    double width = 0, height = 0;
+    const char *path = NULL;
+
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "-p") == 0) {
+            shouldPlay = true;
+        } else if (strcmp(argv[i], "-s") == 0 && i + 1 < argc) {
+            if (sscanf(argv[++i], "%lfx%lf", &width, &height) != 2) {
+                path = NULL;
+                break;
+            }
+        } else if (!path) {
+            path = argv[i];
+        } else {
+            path = NULL;
+            break;
+        }
+    }
+
+    if (!path) {
+        fprintf(stderr, "usage: %s [-p [-s WIDTHxHEIGHT]] recording.tuce\n", argv[0]);
+        return 1;
+    }
+
+    size_t count;
+    TUCOutputEvent *events = ReadRecording(path, &count);
+    if (!events) {
+        return 1;
+    }
+    if (count == 0) {
+        printf("no events\n");
+        free(events);
+        return 0;
+    }
+
+    int result = 0;
+    if (shouldPlay) {
+#ifdef __linux__
+        result = Play(events, count, width, height);
+#else
+        fprintf(stderr, "playing needs Linux and /dev/uinput, printing instead\n");
+        Dump(events, count);
+#endif
+    } else {
+        Dump(events, count);
+    }
+
+    free(events);
+    return result;
+}
@@ -0,0 +1,157 @@
+//
+//  tuc-predictor-replay.c
+//  Touch Up
+//
+//  Created by Touch Up contributors on 16.10.26.
+//
+//  Replays synthetic finger paths through TUCMotionPredictor and reports how far the predicted position is from where the finger
+//  really is a look-ahead later, next to the error without prediction (the last sample, which is what the cursor shows today).
+//  The paths are sampled at the report rate with a little sensor noise, on a 15.6" panel of 344 x 194 mm.
+//
+//  Build:  cc -std=c11 -O2 -I TouchUpCore -o tuc-predictor-replay Tools/tuc-predictor-replay.c TouchUpCore/TUCMotionPredictor.c -lm
+//  Usage:  ./tuc-predictor-replay [report rate in Hz]
+//
+
+#include <math.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "TUCMotionPredictor.h"
+
+
+#define kPanelWidth     344.0       // mm
+#define kPanelHeight    194.0
+#define kNoise          0.2         // mm, peak
+#define kDuration       1.0         // s per path
+#define kMaxSamples     1024
+
+static const double kPi = 3.14159265358979323846;
+
+
+typedef struct {
+    const char *name;
+    void (*position)(double time, double *x, double *y);   // mm
+} Path;
+
+
+// a drag across the screen at 200 mm/s
+static void Line(double time, double *x, double *y) {
+    *x = 50 + 200 * time;
+    *y = 100;
+}
+
+// circles of 40 mm radius, one per second: the velocity turns all the time
+static void Circle(double time, double *x, double *y) {
+    *x = 170 + 40 * cos(2 * kPi * time);
+    *y = 100 + 40 * sin(2 * kPi * time);
+}
+
+// a flick: 600 mm/s, slowing down exponentially
+static void Flick(double time, double *x, double *y) {
+    *x = 30 + 600 * 0.15 * (1 - exp(-time / 0.15));
+    *y = 60 + 0.3 * *x;
+}
+
+// 250 mm/s for half a second, then the finger stops dead
+static void Stop(double time, double *x, double *y) {
+    *x = 50 + 250 * fmin(time, 0.5);
+    *y = 120;
+}
+
+static const Path kPaths[] = {
+    { "line",   Line },
+    { "circle", Circle },
+    { "flick",  Flick },
+    { "stop",   Stop },
+};
+
+static const double kLookaheads[] = { 0, 0.008, 0.016, 0.025, 0.033, 0.050 };
+
+
+
+static double Noise(void) {
+    return kNoise * (2.0 * rand() / RAND_MAX - 1.0);
+}
+
+
+static int CompareDoubles(const void *a, const void *b) {
+    double x = *(const double *)a, y = *(const double *)b;
+    return x < y ? -1 : x > y;
+}
+
+
+typedef struct {
+    double mean;
+    double p95;
+} ErrorStatistics;
+
+
+static ErrorStatistics Statistics(double *errors, int count) {
+    double sum = 0;
+    for (int i = 0; i < count; i++) {
+        sum += errors[i];
+    }
+    qsort(errors, count, sizeof(double), CompareDoubles);
+    return (ErrorStatistics){ sum / count, errors[(int)(0.95 * (count - 1))] };
+}
+
+
+/**
+ Feeds the noisy samples of the path to the predictor; after each one the position `lookahead` later is predicted and compared
+ with the true position then. Errors in mm.
+ */
+static void Replay(const Path *path, double rate, double lookahead, ErrorStatistics *predicted, ErrorStatistics *unpredicted) {
+    static double predictedErrors[kMaxSamples], unpredictedErrors[kMaxSamples];
+    int numSamples = (int)(kDuration * rate);
+    if (numSamples > kMaxSamples) {
+        numSamples = kMaxSamples;
+    }
+
+    TUCMotionPredictor predictor;
+    TUCMotionPredictorInit(&predictor);
+    srand(1);
+
+    for (int i = 0; i < numSamples; i++) {
+        double time = i / rate;
+        double x, y, futureX, futureY;
+        path->position(time, &x, &y);
+        path->position(time + lookahead, &futureX, &futureY);
+
+        double sampleX = (x + Noise()) / kPanelWidth;
+        double sampleY = (y + Noise()) / kPanelHeight;
+        TUCMotionPredictorUpdate(&predictor, 0, sampleX, sampleY, time);
+
+        double predictedX = sampleX, predictedY = sampleY;
+        TUCMotionPredictorPredict(&predictor, 0, time + lookahead, &predictedX, &predictedY);
+
+        predictedErrors[i] = hypot((predictedX * kPanelWidth - futureX), (predictedY * kPanelHeight - futureY));
+        unpredictedErrors[i] = hypot((sampleX * kPanelWidth - futureX), (sampleY * kPanelHeight - futureY));
+    }
+
+    *predicted = Statistics(predictedErrors, numSamples);
+    *unpredicted = Statistics(unpredictedErrors, numSamples);
+}
+
+
+
+int main(int argc, const char *argv[]) {
+    double rate = argc > 1 ? atof(argv[1]) : 100;
+    if (rate <= 0 || rate > kMaxSamples / kDuration) {
+        fprintf(stderr, "usage: %s [report rate in Hz, up to %d]\n", argv[0], (int)(kMaxSamples / kDuration));
+        return 1;
+    }
+
+    printf("errors in mm at %.0f Hz, mean / 95th percentile\n\n", rate);
+    printf("%-8s %10s %20s %20s\n", "path", "look-ahead", "no prediction", "predicted");
+
+    for (size_t p = 0; p < sizeof(kPaths) / sizeof(*kPaths); p++) {
+        for (size_t l = 0; l < sizeof(kLookaheads) / sizeof(*kLookaheads); l++) {
+            ErrorStatistics predicted, unpredicted;
+            Replay(&kPaths[p], rate, kLookaheads[l], &predicted, &unpredicted);
+
+            printf("%-8s %7.0f ms %10.2f / %6.2f %10.2f / %6.2f\n", l == 0 ? kPaths[p].name : "", kLookaheads[l] * 1000,
+                   unpredicted.mean, unpredicted.p95, predicted.mean, predicted.p95);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,136 @@
+//
+//  tuclog-decode.c
+//  Touch Up
+//
+//  Created by Touch Up contributors on 16.10.26.
+//
+//  Turns a binary log written by TUCLog into text, one line per record:
+//  time since the first record, thread, level, category and the formatted message.
+//
+//  Build:  cc -O2 -I TouchUpCore -o tuclog-decode Tools/tuclog-decode.c TouchUpCore/TUCLogFormat.c
+//  Usage:  ./tuclog-decode [/tmp/touchup.tuclog]
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "TUCLogFormat.h"
+
+
+#define kMaxSites 65536
+
+
+static const char *LevelNames[] = { "TRACE", "DEBUG", "INFO", "WARNING", "ERROR" };
+static const char *CategoryNames[] = { "HID", "Frame", "Touch", "Gesture", "Cursor", "Screen" };
+
+typedef struct {
+    char *format;
+    uint8_t level;
+    uint8_t category;
+} Site;
+
+static Site gSites[kMaxSites];
+
+
+
+static const char *LevelName(uint8_t level) {
+    return level < sizeof(LevelNames) / sizeof(*LevelNames) ? LevelNames[level] : "?";
+}
+
+static const char *CategoryName(uint8_t category) {
+    return category < sizeof(CategoryNames) / sizeof(*CategoryNames) ? CategoryNames[category] : "?";
+}
+
+
+
+int main(int argc, const char *argv[]) {
+    const char *path = argc > 1 ? argv[1] : "/tmp/touchup.tuclog";
+
+    FILE *file = fopen(path, "rb");
+    if (!file) {
+        perror(path);
+        return 1;
+    }
+
+    TUCLogFileHeader header;
+    if (fread(&header, sizeof(header), 1, file) != 1 || memcmp(header.magic, kTUCLogFileMagic, sizeof(header.magic)) != 0) {
+        fprintf(stderr, "%s: not a Touch Up log\n", path);
+        return 1;
+    }
+
+    double nsPerTick = header.timebaseDenom ? (double)header.timebaseNumer / header.timebaseDenom : 1;
+    uint64_t firstTime = 0;
+    int tag;
+
+    while ((tag = fgetc(file)) != EOF) {
+        switch (tag) {
+            case TUCLogEntrySite: {
+                TUCLogSiteEntry entry;
+                if (fread(&entry, sizeof(entry), 1, file) != 1) {
+                    goto truncated;
+                }
+
+                char *format = malloc(entry.formatLength + 1);
+                if (!format || fread(format, 1, entry.formatLength, file) != entry.formatLength) {
+                    goto truncated;
+                }
+                format[entry.formatLength] = '\0';
+
+                free(gSites[entry.id].format);
+                gSites[entry.id] = (Site){ format, entry.level, entry.category };
+                break;
+            }
+
+            case TUCLogEntryRecord: {
+                TUCLogRecord record;
+                if (fread(&record, kTUCLogRecordHeaderSize, 1, file) != 1 || record.payloadSize > kTUCLogPayloadSize
+                    || fread(record.payload, 1, record.payloadSize, file) != record.payloadSize) {
+                    goto truncated;
+                }
+
+                if (firstTime == 0) {
+                    firstTime = record.time;
+                }
+                double time = (double)(record.time - firstTime) * nsPerTick / 1e6;
+
+                Site *site = &gSites[record.siteID];
+                char text[1024];
+                if (site->format) {
+                    TUCLogFormatPayload(text, sizeof(text), site->format, record.payload, record.payloadSize);
+                } else {
+                    snprintf(text, sizeof(text), "<unknown call site %u>", record.siteID);
+                }
+
+                printf("%12.3f  %6u  %-7s  %-7s  %s%s\n", time, record.threadID, LevelName(site->level),
+                       CategoryName(site->category), text, (record.flags & kTUCLogRecordTruncated) ? " <truncated>" : "");
+                break;
+            }
+
+            case TUCLogEntryDropped: {
+                TUCLogDroppedEntry entry;
+                if (fread(&entry, sizeof(entry), 1, file) != 1) {
+                    goto truncated;
+                }
+
+                double time = firstTime ? (double)(entry.time - firstTime) * nsPerTick / 1e6 : 0;
+                printf("%12.3f  %6u  %-7s  %-7s  %llu records dropped\n", time, entry.threadID, "-", "-",
+                       (unsigned long long)entry.count);
+                break;
+            }
+
+            default:
+                fprintf(stderr, "%s: unknown entry '%c', stopping\n", path, tag);
+                return 1;
+        }
+    }
+
+    fclose(file);
+    return 0;
+
+truncated:
+    // the app may still be writing, everything up to here was complete
+    fprintf(stderr, "%s: ends with an incomplete entry\n", path);
+    fclose(file);
+    return 0;
+}
@@ -265,6 +265,7 @@ struct DebugView: View {
                                 
                                 print("[DebugView] PUNKT \(calibrationPointsCaptured + 1)/4: touch=(\(String(format: "%.2f", touch.location.x)), \(String(format: "%.2f", touch.location.y))) -> target=(\(String(format: "%.0f", screenPoint.x)), \(String(format: "%.0f", screenPoint.y)))")
                                 screen.recordCalibrationPoint(touch.location, atScreenLocation: screenPoint, pointIndex: calibrationPointsCaptured)
+                                model.touchManager.reloadConfiguration()
                                 
                                 DispatchQueue.main.async {
                                     self.calibrationPointsCaptured += 1
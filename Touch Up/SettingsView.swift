@@ -121,6 +121,7 @@ struct SettingsView: View {
             Button(action: {
                 if let screen = model.connectedTouchscreen {
                     screen.startCalibration()
+                    model.touchManager.reloadConfiguration()
                     // Öffne Debug-Overlay für Kalibrierung
                     (NSApp.delegate as? AppDelegate)?.showDebugOverlay()
                     print("[SettingsView] Kalibrierung gestartet - fullscreen overlay öffnet")
@@ -32,16 +32,19 @@ class TouchUp: NSObject, ObservableObject {
     
     
     // Gesten deaktiviert - nur Klick und Ziehen aktiv
-    @Published var isScrollingWithOneFingerEnabled = false
-    @Published var isSecondaryClickEnabled = false
-    @Published var isMagnificationEnabled = false
-    @Published var isClickWindowToFrontEnabled = false
-    @Published var isClickOnLiftEnabled = false
+    // action(for:) answers from these, the touch manager only sees a change after reloadConfiguration
+    @Published var isScrollingWithOneFingerEnabled = false { didSet { touchManager.reloadConfiguration() } }
+    @Published var isSecondaryClickEnabled = false { didSet { touchManager.reloadConfiguration() } }
+    @Published var isMagnificationEnabled = false { didSet { touchManager.reloadConfiguration() } }
+    @Published var isClickWindowToFrontEnabled = false { didSet { touchManager.reloadConfiguration() } }
+    @Published var isClickOnLiftEnabled = false { didSet { touchManager.reloadConfiguration() } }
     
     
     
     @Published var connectedScreens = [TUCScreen]()
-    var connectedTouchscreen: TUCScreen?
+    var connectedTouchscreen: TUCScreen? {
+        didSet { touchManager.reloadConfiguration() }
+    }
     
     var lastDateUSBAdded: Date?
     var lastDateScreenAdded: Date?
@@ -337,7 +340,7 @@ extension TouchUp {
 
 extension TouchUp: TUCTouchDelegate {
     
-    func touchesDidChange() {
+    func touchesDidChange(_ changes: TUCTouchChanges) {
         self.touches = self.touchManager.touchSet.allObjects as! [TUCTouch]
     }
     
@@ -0,0 +1,261 @@
+//
+//  HIDContactTracker.c
+//  Touch Up Core
+//
+//  Created by Touch Up contributors on 16.10.26.
+//
+
+#include "HIDContactTracker.h"
+
+#include <float.h>
+#include <string.h>
+
+
+// rows are contacts, columns are touches (padded to the number of contacts), index 0 is used by the solver
+#define kMaxSize (HID_FRAME_MAX_CONTACTS + 1)
+
+
+void HIDContactTrackerInit(HIDContactTracker *tracker, float gate) {
+    tracker->gateSquared = gate * gate;
+
+    tracker->numFrames = 0;
+    tracker->numNewTouches = 0;
+    tracker->numUntracked = 0;
+
+    HIDContactTrackerReset(tracker);
+}
+
+
+void HIDContactTrackerReset(HIDContactTracker *tracker) {
+    for (int i = 0; i < HID_TRACKER_MAX_SLOTS; i++) {
+        tracker->slots[i] = (HIDTrackerSlot){ .id = kHIDContactTrackerNoID };
+    }
+    tracker->nextID = 0;
+}
+
+
+
+/**
+ Hungarian method with potentials for a cost matrix of `numRows` × `numColumns` (1-based, numRows <= numColumns).
+ On return `rowForColumn[j]` is the row assigned to column j, 0 if none. O(numRows² × numColumns).
+ */
+static void SolveAssignment(float cost[kMaxSize][kMaxSize], int numRows, int numColumns, int rowForColumn[kMaxSize]) {
+    float u[kMaxSize] = {0}, v[kMaxSize] = {0}, minValue[kMaxSize];
+    int way[kMaxSize];
+    bool isUsed[kMaxSize];
+
+    memset(rowForColumn, 0, sizeof(int) * kMaxSize);
+
+    for (int row = 1; row <= numRows; row++) {
+        rowForColumn[0] = row;
+        int column = 0;
+
+        for (int j = 0; j <= numColumns; j++) {
+            minValue[j] = FLT_MAX;
+            isUsed[j] = false;
+        }
+
+        // grow an alternating path from the new row until it reaches a free column
+        do {
+            isUsed[column] = true;
+            int currentRow = rowForColumn[column];
+            float delta = FLT_MAX;
+            int nextColumn = 0;
+
+            for (int j = 1; j <= numColumns; j++) {
+                if (isUsed[j]) continue;
+
+                float reduced = cost[currentRow][j] - u[currentRow] - v[j];
+                if (reduced < minValue[j]) {
+                    minValue[j] = reduced;
+                    way[j] = column;
+                }
+                if (minValue[j] < delta) {
+                    delta = minValue[j];
+                    nextColumn = j;
+                }
+            }
+
+            for (int j = 0; j <= numColumns; j++) {
+                if (isUsed[j]) {
+                    u[rowForColumn[j]] += delta;
+                    v[j] -= delta;
+                } else {
+                    minValue[j] -= delta;
+                }
+            }
+            column = nextColumn;
+        } while (rowForColumn[column] != 0);
+
+        // flip the path
+        do {
+            int previous = way[column];
+            rowForColumn[column] = rowForColumn[previous];
+            column = previous;
+        } while (column != 0);
+    }
+}
+
+
+
+static float DistanceSquared(float x1, float y1, float x2, float y2) {
+    float dx = x2 - x1;
+    float dy = y2 - y1;
+    return dx * dx + dy * dy;
+}
+
+
+/**
+ Squared distance of a contact to the touch of a slot. A finger that stops suddenly is close to its last position instead of the
+ predicted one, so the smaller of both counts.
+ */
+static float SlotCost(const HIDTrackerSlot *slot, float x, float y) {
+    float predicted = DistanceSquared(slot->x + slot->dx, slot->y + slot->dy, x, y);
+    float last = DistanceSquared(slot->x, slot->y, x, y);
+    return predicted < last ? predicted : last;
+}
+
+
+
+static int StartTouch(HIDContactTracker *tracker, float x, float y) {
+    int slotIndex = -1;
+
+    // reuse the ID of an ended touch, keeps the IDs small
+    for (int i = 0; i < HID_TRACKER_MAX_SLOTS && slotIndex < 0; i++) {
+        if (!tracker->slots[i].isActive && tracker->slots[i].id != kHIDContactTrackerNoID) {
+            slotIndex = i;
+        }
+    }
+    for (int i = 0; i < HID_TRACKER_MAX_SLOTS && slotIndex < 0; i++) {
+        if (!tracker->slots[i].isActive) {
+            slotIndex = i;
+            tracker->slots[i].id = tracker->nextID++;
+        }
+    }
+    if (slotIndex < 0) {
+        return -1;
+    }
+
+    tracker->slots[slotIndex] = (HIDTrackerSlot){
+        .id = tracker->slots[slotIndex].id,
+        .isActive = true,
+        .x = x,
+        .y = y,
+    };
+    tracker->numNewTouches++;
+
+    return slotIndex;
+}
+
+
+
+void HIDContactTrackerAssign(HIDContactTracker *tracker, const HIDDecodedContact *contacts, uint32_t count, int32_t *ids) {
+    tracker->numFrames++;
+
+    bool isAnyActive = false;
+    for (int i = 0; i < HID_TRACKER_MAX_SLOTS; i++) {
+        isAnyActive |= tracker->slots[i].isActive;
+    }
+    if (!isAnyActive) {
+        HIDContactTrackerReset(tracker);
+    }
+
+    // rows: contacts that take part in the matching
+    int contactForRow[kMaxSize];
+    int numRows = 0;
+
+    for (uint32_t i = 0; i < count && i < HID_FRAME_MAX_CONTACTS; i++) {
+        const HIDDecodedContact *contact = &contacts[i];
+
+        if (!contact->tipSwitch && !contact->isValid) {
+            ids[i] = kHIDContactTrackerNoID;
+        } else if (contact->x < 0 || contact->y < 0 || contact->x > 1 || contact->y > 1) {
+            ids[i] = contact->contactID;
+        } else {
+            ids[i] = kHIDContactTrackerNoID;
+            contactForRow[++numRows] = (int)i;
+        }
+    }
+
+    // columns: active touches, padded with "no touch" columns so every contact has one
+    int slotForColumn[kMaxSize];
+    int numColumns = 0;
+
+    for (int i = 0; i < HID_TRACKER_MAX_SLOTS; i++) {
+        if (tracker->slots[i].isActive) {
+            slotForColumn[++numColumns] = i;
+        }
+    }
+    int numTouches = numColumns;
+    while (numColumns < numRows) {
+        slotForColumn[++numColumns] = -1;
+    }
+
+    if (numRows > 0 && numTouches > 0) {
+        // costs are cut off at the gate: beyond it a match is no better than starting a new touch
+        float cost[kMaxSize][kMaxSize];
+        for (int row = 1; row <= numRows; row++) {
+            const HIDDecodedContact *contact = &contacts[contactForRow[row]];
+
+            for (int column = 1; column <= numColumns; column++) {
+                int slotIndex = slotForColumn[column];
+                float value = slotIndex < 0 ? tracker->gateSquared : SlotCost(&tracker->slots[slotIndex], contact->x, contact->y);
+                cost[row][column] = value < tracker->gateSquared ? value : tracker->gateSquared;
+            }
+        }
+
+        int rowForColumn[kMaxSize];
+        SolveAssignment(cost, numRows, numColumns, rowForColumn);
+
+        for (int column = 1; column <= numTouches; column++) {
+            int row = rowForColumn[column];
+            if (row == 0 || cost[row][column] >= tracker->gateSquared) {
+                continue;
+            }
+
+            const HIDDecodedContact *contact = &contacts[contactForRow[row]];
+            HIDTrackerSlot *slot = &tracker->slots[slotForColumn[column]];
+
+            slot->dx = contact->x - slot->x;
+            slot->dy = contact->y - slot->y;
+            slot->x = contact->x;
+            slot->y = contact->y;
+
+            ids[contactForRow[row]] = slot->id;
+        }
+    }
+
+    // everything left over starts a new touch, in the order of the report
+    for (int row = 1; row <= numRows; row++) {
+        int index = contactForRow[row];
+        if (ids[index] != kHIDContactTrackerNoID) {
+            continue;
+        }
+
+        // a finger lifting off does not start a touch, nothing would end it
+        if (!contacts[index].tipSwitch) {
+            continue;
+        }
+
+        int slotIndex = StartTouch(tracker, contacts[index].x, contacts[index].y);
+        if (slotIndex < 0) {
+            tracker->numUntracked++;
+            ids[index] = contacts[index].contactID;
+        } else {
+            ids[index] = tracker->slots[slotIndex].id;
+        }
+    }
+}
+
+
+
+void HIDContactTrackerRelease(HIDContactTracker *tracker, int32_t id) {
+    for (int i = 0; i < HID_TRACKER_MAX_SLOTS; i++) {
+        if (tracker->slots[i].isActive && tracker->slots[i].id == id) {
+            tracker->slots[i].isActive = false;
+            tracker->slots[i].dx = 0;
+            tracker->slots[i].dy = 0;
+            return;
+        }
+    }
+}
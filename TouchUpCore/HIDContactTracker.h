@@ -0,0 +1,77 @@
+//
+//  HIDContactTracker.h
+//  Touch Up Core
+//
+//  Created by Touch Up contributors on 16.10.26.
+//
+
+#ifndef HIDContactTracker_h
+#define HIDContactTracker_h
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "HIDFrameAssembler.h"
+
+/*
+ Gives the contacts of a frame stable IDs by their position.
+
+ In hybrid mode the hardware reuses the same Contact ID for different fingers, so the ID of a touch is derived from where it is.
+ All contacts of a frame are matched against all active touches at once: the assignment with the smallest sum of squared
+ distances to the predicted positions wins (Hungarian method). Unlike matching contact by contact, two fingers moving fast or
+ close together cannot steal each other's ID that way. A contact farther than the gate from every touch starts a new one.
+
+ Internal IDs stay small (0...9): the ID of an ended touch is handed to the next new touch, and once no touch is active the IDs
+ start at 0 again. Like the decoder, this file does not depend on IOKit or CoreFoundation.
+ */
+
+
+#define HID_TRACKER_MAX_SLOTS 10
+
+#define kHIDContactTrackerDefaultGate   0.05f   // normalized distance, 5% = same touch
+#define kHIDContactTrackerNoID          (-1)
+
+
+typedef struct {
+    int32_t id;                 // kHIDContactTrackerNoID until the slot was used
+    bool    isActive;
+    float   x, y;               // last position
+    float   dx, dy;             // movement during the last frame, predicts the next position
+} HIDTrackerSlot;
+
+
+typedef struct {
+    HIDTrackerSlot slots[HID_TRACKER_MAX_SLOTS];
+    int32_t nextID;
+    float   gateSquared;
+
+    // statistics
+    uint64_t numFrames;
+    uint64_t numNewTouches;
+    uint64_t numUntracked;      // contacts that found no free slot and kept their hardware ID
+} HIDContactTracker;
+
+
+
+void HIDContactTrackerInit(HIDContactTracker *tracker, float gate);
+
+/**
+ Frees all slots, the IDs start at 0 again.
+ */
+void HIDContactTrackerReset(HIDContactTracker *tracker);
+
+/**
+ Assigns an ID to every contact of one frame and advances the matched touches. `ids` gets one entry per contact:
+ - kHIDContactTrackerNoID for empty touch collections (neither tip nor valid set) and lifted contacts that match no touch
+ - the hardware Contact ID for positions outside 0...1 and if all slots are taken
+ - otherwise the ID of the matched or newly started touch
+ Touches without a contact in this frame stay active, they end with HIDContactTrackerRelease.
+ */
+void HIDContactTrackerAssign(HIDContactTracker *tracker, const HIDDecodedContact *contacts, uint32_t count, int32_t *ids);
+
+/**
+ Ends the touch with the given ID, its ID may be handed to the next new touch.
+ */
+void HIDContactTrackerRelease(HIDContactTracker *tracker, int32_t id);
+
+#endif /* HIDContactTracker_h */
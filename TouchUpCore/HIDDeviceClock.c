@@ -0,0 +1,137 @@
+//
+//  HIDDeviceClock.c
+//  Touch Up Core
+//
+//  Created by Touch Up contributors on 16.10.26.
+//
+
+#include "HIDDeviceClock.h"
+
+#include <math.h>
+
+
+#define kResyncThreshold    50e6        // ns, larger differences are not transport latency any more
+#define kOffsetGain         0.01        // how fast the offset follows a growing latency
+#define kDriftMinSpan       10e9        // ns of device time before the drift is measured
+#define kDriftGain          0.1
+#define kMaxDrift           1e-3        // 1000 ppm, everything beyond is a measurement error
+
+
+void HIDDeviceClockInit(HIDDeviceClock *clock, uint32_t period, uint32_t unit) {
+    clock->period = period > 0 ? period : kHIDDeviceClockDefaultPeriod;
+    clock->unit   = unit > 0 ? unit : kHIDDeviceClockDefaultUnit;
+
+    clock->numWraps = 0;
+    clock->numResyncs = 0;
+
+    HIDDeviceClockReset(clock);
+}
+
+
+void HIDDeviceClockReset(HIDDeviceClock *clock) {
+    clock->hasSample = false;
+    clock->lastTimestamp = 0;
+    clock->lastLatency = 0;
+    clock->deviceTime = 0;
+    clock->offset = 0;
+    clock->rate = 1;
+}
+
+
+
+static void Anchor(HIDDeviceClock *clock, uint64_t hostTime) {
+    clock->offset = (double)hostTime - (double)clock->deviceTime * clock->rate;
+    clock->anchorDeviceTime = clock->deviceTime;
+    clock->anchorHostTime = hostTime;
+}
+
+
+
+uint64_t HIDDeviceClockUpdate(HIDDeviceClock *clock, uint32_t scanTime, uint64_t hostTime) {
+    uint32_t count = scanTime % clock->period;
+
+    if (!clock->hasSample) {
+        clock->hasSample = true;
+        clock->lastCount = count;
+        clock->lastHostTime = hostTime;
+        clock->lastTimestamp = hostTime;
+        clock->deviceTime = 0;
+        clock->rate = 1;
+        Anchor(clock, hostTime);
+        return hostTime;
+    }
+
+    double periodTime = (double)clock->period * clock->unit;
+    double hostElapsed = hostTime > clock->lastHostTime ? (double)(hostTime - clock->lastHostTime) : 0;
+
+    // same frame
+    if (count == clock->lastCount && hostElapsed < periodTime / 2) {
+        return clock->lastTimestamp;
+    }
+
+    // unwrap the counter
+    uint64_t deltaCounts = (count + clock->period - clock->lastCount) % clock->period;
+    if (count < clock->lastCount) {
+        clock->numWraps++;
+    }
+
+    double deltaTime = (double)deltaCounts * clock->unit;
+
+    // after a pause the counter may have wrapped more than once, the host clock tells how often
+    double expected = hostElapsed / clock->rate;
+    if (expected > periodTime / 2) {
+        double wraps = round((expected - deltaTime) / periodTime);
+        if (wraps > 0) {
+            deltaTime += wraps * periodTime;
+            clock->numWraps += (uint64_t)wraps;
+        }
+    }
+
+    clock->deviceTime += (uint64_t)deltaTime;
+    clock->lastCount = count;
+    clock->lastHostTime = hostTime;
+
+    // offset: a frame cannot arrive before it was sampled, so the smallest latency seen is the best estimate
+    double mapped = clock->offset + (double)clock->deviceTime * clock->rate;
+    double residual = (double)hostTime - mapped;
+
+    if (fabs(residual) > kResyncThreshold) {
+        clock->numResyncs++;
+        Anchor(clock, hostTime);
+
+    } else if (residual < 0) {
+        clock->offset += residual;
+
+    } else {
+        clock->offset += residual * kOffsetGain;
+    }
+
+    // drift: compare elapsed host and device time over a long span, the latency jitter averages out
+    double span = (double)(clock->deviceTime - clock->anchorDeviceTime);
+    if (span >= kDriftMinSpan) {
+        double measured = (double)(hostTime - clock->anchorHostTime) / span;
+        if (measured > 1 + kMaxDrift) measured = 1 + kMaxDrift;
+        if (measured < 1 - kMaxDrift) measured = 1 - kMaxDrift;
+
+        double rate = clock->rate + (measured - clock->rate) * kDriftGain;
+
+        // keep the mapping continuous at the current device time
+        clock->offset += (double)clock->deviceTime * (clock->rate - rate);
+        clock->rate = rate;
+    }
+
+    double timestamp = clock->offset + (double)clock->deviceTime * clock->rate;
+    uint64_t result = timestamp > 0 ? (uint64_t)timestamp : 0;
+
+    if (result > hostTime) {
+        result = hostTime;
+    }
+    if (result < clock->lastTimestamp) {
+        result = clock->lastTimestamp;
+    }
+
+    clock->lastTimestamp = result;
+    clock->lastLatency = hostTime - result;
+
+    return result;
+}
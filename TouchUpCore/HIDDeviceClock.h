@@ -0,0 +1,66 @@
+//
+//  HIDDeviceClock.h
+//  Touch Up Core
+//
+//  Created by Touch Up contributors on 16.10.26.
+//
+
+#ifndef HIDDeviceClock_h
+#define HIDDeviceClock_h
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ Converts the Relative Scan Time of a digitizer into timestamps on the host timeline.
+
+ The scan time is a free running counter of the device (100 µs per count, 16 bit on all screens we know), so it describes
+ when a frame was sampled instead of when the host got around to process it. The clock unwraps the counter,
+ estimates the offset of the device clock to the host clock and their drift, and maps every scan time to host time in ns.
+ Like the decoder, this file does not depend on IOKit or CoreFoundation.
+ */
+
+
+#define kHIDDeviceClockDefaultPeriod    65536       // counts until the scan time wraps around
+#define kHIDDeviceClockDefaultUnit      100000      // ns per count
+
+
+typedef struct {
+    uint32_t period;
+    uint32_t unit;
+
+    bool     hasSample;
+    uint32_t lastCount;
+    uint64_t lastHostTime;
+    uint64_t lastTimestamp;
+
+    uint64_t deviceTime;        // unwrapped device time in ns since the first sample
+    double   offset;            // host time of device time 0 in ns
+    double   rate;              // host ns per device ns, 1 + drift
+
+    uint64_t anchorDeviceTime;  // start of the drift measurement
+    uint64_t anchorHostTime;
+
+    // statistics
+    uint64_t lastLatency;       // ns between sampling and arrival of the last frame
+    uint64_t numWraps;
+    uint64_t numResyncs;        // the device clock jumped, e.g. after the screen was idle and reset its counter
+} HIDDeviceClock;
+
+
+
+/**
+ `period` is the logical maximum of the scan time + 1, pass 0 for the default.
+ */
+void HIDDeviceClockInit(HIDDeviceClock *clock, uint32_t period, uint32_t unit);
+
+void HIDDeviceClockReset(HIDDeviceClock *clock);
+
+/**
+ Feeds the scan time of one frame together with the host time the frame arrived (ns).
+ Returns the time the frame was sampled, mapped to the host timeline in ns. The result never decreases.
+ Further partial reports of a hybrid frame repeat the scan time and get the same timestamp.
+ */
+uint64_t HIDDeviceClockUpdate(HIDDeviceClock *clock, uint32_t scanTime, uint64_t hostTime);
+
+#endif /* HIDDeviceClock_h */
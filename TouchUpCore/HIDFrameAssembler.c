@@ -0,0 +1,137 @@
+//
+//  HIDFrameAssembler.c
+//  Touch Up Core
+//
+//  Created by Touch Up contributors on 16.10.26.
+//
+
+#include "HIDFrameAssembler.h"
+
+#include <string.h>
+
+
+void HIDFrameAssemblerInit(HIDFrameAssembler *assembler, uint64_t timeout) {
+    memset(assembler, 0, sizeof(*assembler));
+    assembler->timeout = timeout;
+}
+
+
+void HIDFrameAssemblerReset(HIDFrameAssembler *assembler) {
+    assembler->inProgress = false;
+    assembler->hasLastScanTime = false;
+}
+
+
+
+static void EmitFrame(HIDFrameAssembler *assembler, bool isComplete, HIDFrameCallback callback, void *context) {
+    HIDTouchFrame *frame = &assembler->frame;
+
+    frame->isComplete = isComplete;
+    assembler->inProgress = false;
+
+    assembler->numFrames++;
+    if (!isComplete) {
+        assembler->numIncompleteFrames++;
+    }
+
+    assembler->hasLastScanTime = (frame->scanTime != kHIDDecoderValueAbsent);
+    assembler->lastScanTime = frame->scanTime;
+
+    if (callback) {
+        callback(frame, context);
+    }
+}
+
+
+
+static bool ReportHasTouch(const HIDDecodedReport *report) {
+    for (uint8_t i = 0; i < report->numContacts; i++) {
+        if (report->contacts[i].tipSwitch) {
+            return true;
+        }
+    }
+    return false;
+}
+
+
+void HIDFrameAssemblerAddReport(HIDFrameAssembler *assembler, const HIDDecodedReport *report, uint64_t now,
+                                HIDFrameCallback callback, void *context) {
+
+    bool hasScanTime = (report->scanTime != kHIDDecoderValueAbsent);
+    bool hasContactCount = (report->contactCount != kHIDDecoderValueAbsent);
+
+    // does the report continue the frame in progress?
+    // with a scan time this is decided by the scan time, otherwise a report that announces contacts starts a new frame
+    if (assembler->inProgress) {
+        bool continuesFrame = hasScanTime
+                            ? (report->scanTime == assembler->frame.scanTime)
+                            : !(hasContactCount && report->contactCount > 0);
+
+        if (!continuesFrame) {
+            EmitFrame(assembler, false, callback, context);
+        }
+    }
+
+    if (!assembler->inProgress) {
+        // late partial of a frame that already timed out
+        if (hasScanTime && assembler->hasLastScanTime && report->scanTime == assembler->lastScanTime) {
+            assembler->numDroppedReports++;
+            return;
+        }
+
+        // a Contact Count of 0 starts no frame of its own while it carries touching contacts: it is the continuation of a frame
+        // whose first report was lost, with or without a scan time. Without the announced count there is nothing to complete,
+        // the touches carry over until the next frame.
+        // without touching contacts it is an empty frame: all fingers lifted
+        if (hasContactCount && report->contactCount == 0 && ReportHasTouch(report)) {
+            assembler->numDroppedReports++;
+            return;
+        }
+
+        uint32_t contactCount = hasContactCount ? (uint32_t)report->contactCount : report->numContacts;
+        if (contactCount > HID_FRAME_MAX_CONTACTS) {
+            contactCount = HID_FRAME_MAX_CONTACTS;
+        }
+
+        HIDTouchFrame *frame = &assembler->frame;
+        frame->scanTime = report->scanTime;
+        frame->timestamp = now;
+        frame->contactCount = contactCount;
+        frame->numContacts = 0;
+        frame->isComplete = false;
+        assembler->inProgress = true;
+    }
+
+    HIDTouchFrame *frame = &assembler->frame;
+
+    // a report always fills its touch collections in order, collections beyond the remaining count are empty slots
+    uint32_t remaining = frame->contactCount - frame->numContacts;
+    uint32_t numToCopy = report->numContacts < remaining ? report->numContacts : remaining;
+
+    memcpy(&frame->contacts[frame->numContacts], report->contacts, numToCopy * sizeof(HIDDecodedContact));
+    frame->numContacts += numToCopy;
+
+    if (frame->numContacts >= frame->contactCount) {
+        EmitFrame(assembler, true, callback, context);
+    }
+}
+
+
+
+bool HIDFrameAssemblerCheckTimeout(HIDFrameAssembler *assembler, uint64_t now, HIDFrameCallback callback, void *context) {
+    if (!assembler->inProgress || now < HIDFrameAssemblerDeadline(assembler)) {
+        return false;
+    }
+
+    EmitFrame(assembler, false, callback, context);
+    return true;
+}
+
+
+
+uint64_t HIDFrameAssemblerDeadline(const HIDFrameAssembler *assembler) {
+    if (!assembler->inProgress) {
+        return 0;
+    }
+    return assembler->frame.timestamp + assembler->timeout;
+}
@@ -0,0 +1,90 @@
+//
+//  HIDFrameAssembler.h
+//  Touch Up Core
+//
+//  Created by Touch Up contributors on 16.10.26.
+//
+
+#ifndef HIDFrameAssembler_h
+#define HIDFrameAssembler_h
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "HIDReportDecoder.h"
+
+/*
+ Assembles the input reports of a digitizer into complete touch frames.
+
+ In hybrid mode a screen reports fewer contacts per input report than fingers are down: the first report of a frame carries the
+ Contact Count of the whole frame, the following reports carry a Contact Count of 0 and the same Relative Scan Time.
+ Our ELAN screens send 2 contacts per report, so a 10 finger frame takes 5 reports.
+ The assembler buffers those partial reports and emits exactly one frame once all announced contacts arrived.
+ A report with a Contact Count of 0 and no touching contacts is not a continuation but an empty frame: all fingers lifted.
+ Continuations whose first report was lost are dropped, the touches of the last frame carry over.
+
+ A frame is emitted early and marked as incomplete if a report with a new scan time arrives or the frame times out,
+ i.e. when a partial report was lost. Like the decoder, this file does not depend on IOKit or CoreFoundation.
+ */
+
+
+#define HID_FRAME_MAX_CONTACTS 32
+
+// a frame normally completes within a few milliseconds, the timeout only matters if a partial report was lost
+#define kHIDFrameAssemblerDefaultTimeout (25ull * 1000000ull)    // ns
+
+
+typedef struct {
+    int32_t  scanTime;          // kHIDDecoderValueAbsent if the device does not report a scan time
+    uint64_t timestamp;         // host time of the first report of the frame in ns
+    uint32_t contactCount;      // contacts announced for the frame
+    uint32_t numContacts;       // contacts that actually arrived
+    bool     isComplete;        // false if partial reports were lost
+    HIDDecodedContact contacts[HID_FRAME_MAX_CONTACTS];
+} HIDTouchFrame;
+
+
+typedef void (*HIDFrameCallback)(const HIDTouchFrame *frame, void *context);
+
+
+typedef struct {
+    HIDTouchFrame frame;        // frame being assembled
+    bool     inProgress;
+    uint64_t timeout;           // ns
+
+    bool     hasLastScanTime;
+    int32_t  lastScanTime;      // scan time of the last emitted frame, late partials of it are dropped
+
+    // statistics
+    uint64_t numFrames;
+    uint64_t numIncompleteFrames;
+    uint64_t numDroppedReports;
+} HIDFrameAssembler;
+
+
+
+void HIDFrameAssemblerInit(HIDFrameAssembler *assembler, uint64_t timeout);
+
+/**
+ Discards the frame in progress without emitting it, e.g. when the device disconnects. Statistics are kept.
+ */
+void HIDFrameAssemblerReset(HIDFrameAssembler *assembler);
+
+/**
+ Adds one decoded input report. `now` is the host time of the report in ns.
+ Calls `callback` for every frame that is finished by this report: an incomplete frame that is superseded and/or the frame completed by it.
+ */
+void HIDFrameAssemblerAddReport(HIDFrameAssembler *assembler, const HIDDecodedReport *report, uint64_t now,
+                                HIDFrameCallback callback, void *context);
+
+/**
+ Emits the frame in progress as incomplete if it is older than the timeout. Returns true if a frame was emitted.
+ */
+bool HIDFrameAssemblerCheckTimeout(HIDFrameAssembler *assembler, uint64_t now, HIDFrameCallback callback, void *context);
+
+/**
+ Host time in ns at which the frame in progress times out, 0 if no frame is in progress.
+ */
+uint64_t HIDFrameAssemblerDeadline(const HIDFrameAssembler *assembler);
+
+#endif /* HIDFrameAssembler_h */
@@ -0,0 +1,76 @@
+//
+//  HIDFrameRing.c
+//  Touch Up Core
+//
+//  Created by Touch Up contributors on 16.10.26.
+//
+
+#include "HIDFrameRing.h"
+
+#include <stddef.h>
+#include <string.h>
+
+
+void HIDFrameRingInit(HIDFrameRing *ring) {
+    atomic_init(&ring->head, 0);
+    atomic_init(&ring->tail, 0);
+}
+
+
+
+bool HIDFrameRingPush(HIDFrameRing *ring, const HIDFrameRingEntry *entry) {
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_relaxed);
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_acquire);
+
+    if (head - tail >= HID_FRAME_RING_CAPACITY) {
+        return false;
+    }
+
+    HIDFrameRingEntry *slot = &ring->entries[head & (HID_FRAME_RING_CAPACITY - 1)];
+
+    // only the contacts that arrived are copied, a frame with 2 fingers does not move 32 contacts
+    size_t size = offsetof(HIDFrameRingEntry, frame.contacts);
+    if (entry->event == HIDFrameRingEventFrame) {
+        size += entry->frame.numContacts * sizeof(HIDDecodedContact);
+    }
+    memcpy(slot, entry, size);
+
+    // publishes the entry to the consumer
+    atomic_store_explicit(&ring->head, head + 1, memory_order_release);
+    return true;
+}
+
+
+
+bool HIDFrameRingPop(HIDFrameRing *ring, HIDFrameRingEntry *entry) {
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+
+    if (tail == head) {
+        return false;
+    }
+
+    const HIDFrameRingEntry *slot = &ring->entries[tail & (HID_FRAME_RING_CAPACITY - 1)];
+
+    size_t size = offsetof(HIDFrameRingEntry, frame.contacts);
+    if (slot->event == HIDFrameRingEventFrame) {
+        size += slot->frame.numContacts * sizeof(HIDDecodedContact);
+    }
+    memcpy(entry, slot, size);
+
+    // hands the slot back to the producer
+    atomic_store_explicit(&ring->tail, tail + 1, memory_order_release);
+    return true;
+}
+
+
+
+const HIDFrameRingEntry *HIDFrameRingPeek(HIDFrameRing *ring) {
+    uint32_t tail = atomic_load_explicit(&ring->tail, memory_order_relaxed);
+    uint32_t head = atomic_load_explicit(&ring->head, memory_order_acquire);
+
+    if (tail == head) {
+        return NULL;
+    }
+    return &ring->entries[tail & (HID_FRAME_RING_CAPACITY - 1)];
+}
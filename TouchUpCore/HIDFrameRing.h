@@ -0,0 +1,71 @@
+//
+//  HIDFrameRing.h
+//  Touch Up Core
+//
+//  Created by Touch Up contributors on 16.10.26.
+//
+
+#ifndef HIDFrameRing_h
+#define HIDFrameRing_h
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "HIDFrameAssembler.h"
+
+/*
+ Single producer / single consumer ring that hands assembled frames from the HID thread to the gesture stage.
+
+ The HID thread is the only writer of `head`, the gesture stage the only writer of `tail`, so pushing and popping
+ needs neither a lock nor a system call. Entries are copied in and out. A push into a full ring fails instead of
+ waiting, what the producer does then is up to it (see PostToGestureStage).
+ Like the decoder, this file does not depend on IOKit or CoreFoundation.
+ */
+
+
+#define HID_FRAME_RING_CAPACITY 64      // power of 2, about 1 s of frames at 60 Hz
+
+
+typedef enum {
+    HIDFrameRingEventFrame = 0,
+    HIDFrameRingEventDeviceAdded,
+    HIDFrameRingEventDeviceRemoved,     // the gesture stage ends the touches of the device, then owns and releases it
+} HIDFrameRingEvent;
+
+
+typedef struct {
+    HIDFrameRingEvent event;
+    void     *device;                   // device context the entry belongs to
+    bool     isLastDevice;              // HIDFrameRingEventDeviceRemoved: no other device is connected
+    uint64_t arrivalTime;               // host time in ns of the report that finished the frame
+    HIDTouchFrame frame;                // HIDFrameRingEventFrame only
+} HIDFrameRingEntry;
+
+
+typedef struct {
+    _Atomic uint32_t head;              // next entry to write, producer only
+    _Atomic uint32_t tail;              // next entry to read, consumer only
+    HIDFrameRingEntry entries[HID_FRAME_RING_CAPACITY];
+} HIDFrameRing;
+
+
+
+void HIDFrameRingInit(HIDFrameRing *ring);
+
+/**
+ Producer side. Returns false if the ring is full, i.e. the gesture stage fell HID_FRAME_RING_CAPACITY entries behind.
+ */
+bool HIDFrameRingPush(HIDFrameRing *ring, const HIDFrameRingEntry *entry);
+
+/**
+ Consumer side. Copies the oldest entry to `entry`, returns false if the ring is empty.
+ */
+bool HIDFrameRingPop(HIDFrameRing *ring, HIDFrameRingEntry *entry);
+
+/**
+ Consumer side. The oldest entry without removing it, NULL if the ring is empty. Valid until the next pop.
+ */
+const HIDFrameRingEntry *HIDFrameRingPeek(HIDFrameRing *ring);
+
+#endif /* HIDFrameRing_h */
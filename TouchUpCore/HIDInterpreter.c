@@ -6,85 +6,31 @@
 //
 
 #include "HIDInterpreter.h"
+#include "HIDContactTracker.h"
+#include "HIDDeviceClock.h"
+#include "HIDFrameAssembler.h"
+#include "HIDJitterFilter.h"
+#include "HIDFrameRing.h"
+#include "HIDReportDecoder.h"
+#include "HIDValueStore.h"
+#include "TUCLog.h"
 #include "TUCTouchInputManager-C.h"
 
 #include <mach/mach_port.h>
 #include <mach/mach_time.h>
+#include <mach/thread_act.h>
+#include <mach/thread_policy.h>
 #include <IOKit/IOKitLib.h>
 #include <IOKit/hid/IOHIDManager.h>
 #include <IOKit/usb/IOUSBLib.h>
 #include <dispatch/dispatch.h>
 #include <stdbool.h>
 #include <pthread.h>
-#include <stdarg.h>
+#include <stdatomic.h>
 #include <string.h>
-#include <time.h>
 
 #include <CoreGraphics/CoreGraphics.h>
 
-// Debug logging to file
-#define DEBUG_LOG_FILE "/tmp/touchup_debug.log"
-#define TOUCH_LOG_FILE "/tmp/touchup_touch_events.log"
-static FILE *gDebugLog = NULL;
-static FILE *gTouchLog = NULL;
-
-static inline void DebugLog(const char *format, ...) {
-    if (!gDebugLog) {
-        gDebugLog = fopen(DEBUG_LOG_FILE, "a");
-    }
-    if (gDebugLog) {
-        va_list args;
-        va_start(args, format);
-        vfprintf(gDebugLog, format, args);
-        va_end(args);
-        fprintf(gDebugLog, "\n");
-        fflush(gDebugLog);
-    }
-    // Also print to stdout
-    printf("[TouchUp] ");
-    va_list args2;
-    va_start(args2, format);
-    vprintf(format, args2);
-    va_end(args2);
-    printf("\n");
-    fflush(stdout);
-}
-
-// Touch event logging - dedicated file for touch events only
-static inline void TouchLog(const char *format, ...) {
-    if (!gTouchLog) {
-        gTouchLog = fopen(TOUCH_LOG_FILE, "w");  // Überschreibe bei jedem Start
-        if (gTouchLog) {
-            // Header mit Zeitstempel
-            time_t now = time(NULL);
-            fprintf(gTouchLog, "=== Touch Up Touch Event Log ===\n");
-            fprintf(gTouchLog, "Started: %s\n", ctime(&now));
-            fprintf(gTouchLog, "Format: [Timestamp] Event: Details\n\n");
-            fflush(gTouchLog);
-        }
-    }
-    if (gTouchLog) {
-        // Timestamp in Millisekunden seit App-Start
-        static uint64_t startTime = 0;
-        if (startTime == 0) {
-            startTime = mach_absolute_time();
-        }
-        uint64_t now = mach_absolute_time();
-        mach_timebase_info_data_t timebase;
-        mach_timebase_info(&timebase);
-        uint64_t elapsedNano = (now - startTime) * timebase.numer / timebase.denom;
-        uint64_t elapsedMs = elapsedNano / 1000000;
-        
-        fprintf(gTouchLog, "[%6llums] ", elapsedMs);
-        va_list args;
-        va_start(args, format);
-        vfprintf(gTouchLog, format, args);
-        va_end(args);
-        fprintf(gTouchLog, "\n");
-        fflush(gTouchLog);
-    }
-}
-
 #pragma mark - Global variables
 
 static void* gTouchManager;
@@ -93,7 +39,45 @@ static CFRunLoopRef gRunLoopRef;
 
 static IOHIDManagerRef gHidManager;
 
-IOHIDQueueRef gQueue;
+/**
+ The HID manager, the queues and the report callbacks run on a dedicated thread with a time-constraint policy, so reports
+ no longer wait behind SwiftUI redraws on the main thread. Set to 0 to schedule the HID manager on the main run loop again,
+ e.g. to compare the latencies logged by RecordLatency.
+ */
+#define HID_USE_INPUT_THREAD 1
+
+static pthread_t gHIDThread;
+
+/**
+ Assembled frames are handed from the HID thread to the gesture stage through this ring. The gesture stage runs on the serial
+ queue of the touch manager and owns everything behind the frame assembler: position deduplication, lifecycle and the touch manager.
+ */
+static HIDFrameRing gFrameRing;
+static dispatch_queue_t gGestureQueue;
+static atomic_bool gIsDrainScheduled;
+
+// HIDDropPolicyPreserveAll: the HID thread sleeps on the semaphore while the ring is full, the drain signals it after a pop
+static dispatch_semaphore_t gFrameRingSpace;
+static atomic_bool gIsWaitingForSpace;
+
+// see HIDDropPolicy and HIDInputStatistics, read by the app from any thread
+static _Atomic int gDropPolicy = HIDDropPolicyPreserveAll;
+static _Atomic uint32_t gTotalQueueDepth;     // sum of HIDDeviceContext.queueDepth of the connected devices
+static _Atomic uint64_t gNumQueueOverflows;
+static _Atomic uint64_t gNumStaleReports;
+static _Atomic uint64_t gNumDroppedFrames;
+static _Atomic uint64_t gNumStalls;
+static _Atomic uint64_t gNumSuppressedMoves;
+static _Atomic uint64_t gNumRejectedOversized;
+static _Atomic uint64_t gNumRejectedLowConfidence;
+
+#define kStaleReportAge     (100ull * 1000000ull)   // ns, older reports no longer describe where the fingers are
+#define kQueueFramesBuffered 4                      // frames the IOHIDQueue of the queue path holds
+#define kPendingFrameRetryInterval (4ull * 1000000ull)  // ns, see ScheduleFrameTimeout
+
+// palm rejection: contacts whose larger side exceeds this (relative to the screen) are no fingers
+// generic screens range from laptops to walls, so the default only catches forearms on the small ones
+#define kDefaultMaxContactSize  0.25f
 
 // USB Direct Access Handle Structure
 typedef struct {
@@ -111,10 +95,15 @@ typedef struct {
 // 0x04F3 = Original ELAN vendor ID
 // 0x0712 = hotlotus vendor ID for "normal Elan" device
 #define kELANVendorID 0x0712
-#define kELANProductID 0x000A
 
-// Flag to track if we detected an ELAN device
-Boolean gIsELANDevice = FALSE;
+// jitter filter tuning of the ELAN panels: resting fingers jitter by about ±3 of 4096 logical units
+#define kELANJitterFilterProfile ((HIDJitterFilterProfile){ \
+    .minCutoff = 1.5f, .beta = 20.0f, .derivativeCutoff = 1.0f, .deadband = 0.0008f })
+
+// ELAN wall panels are about 1.2 m wide: 8% is a palm (~10 cm), a flat thumb stays well below
+#define kELANMaxContactSize 0.08f
+
+#define kELANProductID 0x000A
 
 // USB Direct Access Handle for non-HID ELAN devices
 static USBDirectAccessHandle *gUSBDirectAccessHandle = NULL;
@@ -132,183 +121,182 @@ int USBDirectAccessor_ReadInterrupt(USBDirectAccessHandle *handle, uint8_t *buff
                                      uint32_t bufferSize, uint32_t timeoutMS);
 int USBDirectAccessor_Write(USBDirectAccessHandle *handle, const uint8_t *data, uint32_t dataSize);
 
-uint8_t gAreElementRefsSet = 0;
-
-IOHIDElementRef         gApplicationCollectionElement;
-IOHIDElementRef         gScanTimeElement;
-CFMutableArrayRef       gTouchCollectionElements;
-
 // Forward declaration of USB Direct Access fallback function
 void TryUSBDirectAccess(void);
 
-/**
- stores values for the touch collections: cookie -> latest value
- in hybrid mode (especially if order of touches moves) this data has to be set to last state per collection element receiving touches now
- */
-CFMutableDictionaryRef  gStoredInputValues; //
 
+// POSITION-BASED DEDUPLICATION: Löst Hybrid-Mode Problem
+// Hardware sendet gleiche ContactID=0 für verschiedene Finger
+// Wir deduplicaten nach Position statt Hardware-ID (siehe HIDContactTracker)
+#define MAX_ACTIVE_TOUCHES HID_TRACKER_MAX_SLOTS
 
-CFIndex gContactCount = 1;
-CFIndex gHybridOffset = 0; // how many touches are already sent until this point?
-Boolean gTouchscreenUsesHybridMode = FALSE;
 
 
-CFMutableArrayRef gContactIdentifiers;
+#pragma mark - Device Context
 
-// POSITION-BASED DEDUPLICATION: Löst Hybrid-Mode Problem
-// Hardware sendet gleiche ContactID=0 für verschiedene Finger
-// Wir deduplicaten nach Position statt Hardware-ID
-#define MAX_ACTIVE_TOUCHES 10
-#define POSITION_MATCH_THRESHOLD 0.05f  // 5% Abstand = gleicher Touch (sehr nah)
+#define MAX_DEVICES kTouchInputManagerMaxDevices
+#define kContactIDsPerDevice 100   // contact IDs of device n start at n * kContactIDsPerDevice
 
-typedef struct {
-    CFIndex internalID;         // Stabile interne Touch-ID (0-9)
-    CGFloat currentX, currentY; // Aktuelle Position
-    Boolean isActive;           // Ist dieser Touch gerade aktiv?
-} ActiveTouchSlot;
-
-static ActiveTouchSlot gActiveTouches[MAX_ACTIVE_TOUCHES];
-static CFIndex gNextInternalTouchID = 0;  // Interne IDs starten bei 0
-
-// Prüfe ob alle Slots inaktiv sind
-static Boolean AreAllSlotsInactive(void) {
-    for (int i = 0; i < MAX_ACTIVE_TOUCHES; i++) {
-        if (gActiveTouches[i].isActive) {
-            return FALSE;
-        }
-    }
-    return TRUE;
-}
+// contacts passed to the touch manager per frame: the dispatched ones plus one per ended touch
+#define kMaxFrameContacts (HID_FRAME_MAX_CONTACTS + kContactIDsPerDevice)
 
-// Setze Slot-Zustand komplett zurück (IDs werden wieder bei 0 gestartet)
-static void ResetAllSlots(void) {
-    for (int i = 0; i < MAX_ACTIVE_TOUCHES; i++) {
-        gActiveTouches[i].internalID = -1;
-        gActiveTouches[i].currentX = -1.0;
-        gActiveTouches[i].currentY = -1.0;
-        gActiveTouches[i].isActive = FALSE;
-    }
-    gNextInternalTouchID = 0;
-}
+/**
+ Set of the internal touch IDs of one frame, one bit per ID. IDs of a device are below kContactIDsPerDevice, larger ones would
+ collide with the next device anyway and are not tracked.
+ */
+#define kTouchIDSetWords ((kContactIDsPerDevice + 63) / 64)
 
-// Initialisiere das Position-basierte Deduplication-System
-static void InitializePositionDeduplication(void) {
-    for (int i = 0; i < MAX_ACTIVE_TOUCHES; i++) {
-        gActiveTouches[i].internalID = -1;
-        gActiveTouches[i].currentX = -1.0;
-        gActiveTouches[i].currentY = -1.0;
-        gActiveTouches[i].isActive = FALSE;
-    }
-    gNextInternalTouchID = 0;
-}
+typedef struct {
+    uint64_t words[kTouchIDSetWords];
+} HIDTouchIDSet;
 
-// Berechne Distanz zwischen zwei Positionen (normalisiert 0.0-1.0 Koordinaten)
-static CGFloat PositionDistance(CGFloat x1, CGFloat y1, CGFloat x2, CGFloat y2) {
-    CGFloat dx = x2 - x1;
-    CGFloat dy = y2 - y1;
-    return sqrtf(dx*dx + dy*dy);
+static inline Boolean TouchIDSetContains(const HIDTouchIDSet *set, CFIndex touchID) {
+    return touchID >= 0 && touchID < kContactIDsPerDevice && (set->words[touchID / 64] >> (touchID % 64)) & 1;
 }
 
-// Mappt Position zu stabiler interner Touch-ID
-// Hardware kann gleiche ContactID für verschiedene Finger verwenden (Hybrid-Mode)
-static CFIndex MapPositionToInternalID(CFIndex hardwareID, CGFloat x, CGFloat y) {
-    // CRITICAL: Ungültige Positionen abfangen (z.B. bei leeren Slots)
-    // Diese sollten nicht in das Dedup-System kommen
-    if (x < 0.0 || y < 0.0 || x > 1.0 || y > 1.0) {
-        TouchLog("[DEDUP-SKIP] Invalid position (%.3f,%.3f) - returning HW-ID=%ld directly", x, y, (long)hardwareID);
-        return hardwareID;
-    }
-    
-    // Wenn alles inaktiv ist, IDs zurücksetzen damit wir bei 0-9 bleiben
-    if (AreAllSlotsInactive()) {
-        TouchLog("[DEDUP-RESET] All slots inactive → resetting to ID=0");
-        ResetAllSlots();
+static inline void TouchIDSetAdd(HIDTouchIDSet *set, CFIndex touchID) {
+    if (touchID >= 0 && touchID < kContactIDsPerDevice) {
+        set->words[touchID / 64] |= 1ull << (touchID % 64);
     }
+}
 
-    // 1. Suche nach bereits aktivem Touch an ähnlicher Position
-    for (int i = 0; i < MAX_ACTIVE_TOUCHES; i++) {
-        if (!gActiveTouches[i].isActive) continue;
-        
-        CGFloat distance = PositionDistance(gActiveTouches[i].currentX, gActiveTouches[i].currentY, x, y);
-        
-        // Wenn sehr nah → gleicher Touch!
-        if (distance < POSITION_MATCH_THRESHOLD) {
-            // Update Position (Finger bewegt sich)
-            gActiveTouches[i].currentX = x;
-            gActiveTouches[i].currentY = y;
-            return gActiveTouches[i].internalID;
-        }
-    }
-    
-    // 2. Kein Match gefunden → neuer Touch mit neuer ID
-    // 2a. Reuse inaktiven Slot mit bestehender ID (hält IDs klein)
-    for (int i = 0; i < MAX_ACTIVE_TOUCHES; i++) {
-        if (!gActiveTouches[i].isActive && gActiveTouches[i].internalID != -1) {
-            CFIndex reusedID = gActiveTouches[i].internalID;
-            gActiveTouches[i].currentX = x;
-            gActiveTouches[i].currentY = y;
-            gActiveTouches[i].isActive = TRUE;
-            TouchLog("[DEDUP-REUSE] HW-ID=%ld pos=(%.3f,%.3f) → REUSE ID=%ld",
-                   (long)hardwareID, x, y, (long)reusedID);
-            return reusedID;
-        }
+static inline CFIndex TouchIDSetCount(const HIDTouchIDSet *set) {
+    CFIndex count = 0;
+    for (int i = 0; i < kTouchIDSetWords; i++) {
+        count += __builtin_popcountll(set->words[i]);
     }
+    return count;
+}
 
-    // 2b. Falls nötig, neue ID erzeugen
-    CFIndex newInternalID = gNextInternalTouchID++;
-    
-    // Finde freien Slot (leer oder inaktiv)
-    for (int i = 0; i < MAX_ACTIVE_TOUCHES; i++) {
-        if (!gActiveTouches[i].isActive) {
-            gActiveTouches[i].internalID = newInternalID;
-            gActiveTouches[i].currentX = x;
-            gActiveTouches[i].currentY = y;
-            gActiveTouches[i].isActive = TRUE;
-            TouchLog("[DEDUP-NEW] HW-ID=%ld pos=(%.3f,%.3f) → NEW ID=%ld",
-                   (long)hardwareID, x, y, (long)newInternalID);
-            return newInternalID;
+/**
+ Everything that belongs to one connected touchscreen. A context is created in Handle_DeviceMatchingCallback and passed to all
+ callbacks of its device, so several screens on one host (e.g. dual-panel kiosks) are decoded, assembled and tracked independently.
+ Everything up to the frame assembler belongs to the HID thread, deduplication and lifecycle to the gesture stage.
+ */
+typedef struct {
+    IOHIDDeviceRef device;
+    Boolean isELAN;
+    
+    // output routing: contact IDs reported to the touch manager are offset by this, so touches of different screens never collide
+    // the touch manager keeps the frames of the screens apart by the slot
+    int slot;
+    CFIndex contactIDBase;
+    
+    /**
+     Raw report path: the report descriptor is compiled once at connect, afterwards each input report is decoded directly from its byte buffer.
+     If the descriptor cannot be compiled, the element based queue path below is used as fallback.
+     */
+    HIDReportDecoder reportDecoder;
+    Boolean usesReportDecoder;
+    uint8_t *reportBuffer;
+    CFIndex reportBufferSize;
+    
+    // queue path
+    IOHIDQueueRef queue;
+    CFIndex queueDepth;         // values, see QueueDepthForLayout
+    IOHIDElementRef applicationCollectionElement;
+    IOHIDElementRef scanTimeElement;
+    CFMutableArrayRef touchCollectionElements;
+    
+    /**
+     stores values for the touch collections: cookie -> latest value
+     The store is a flat array indexed by cookie that is allocated in IdentifyElements, so storing and reading values never allocates.
+     */
+    HIDValueStore storedInputValues;
+    
+    // cookie of the contact count element, avoids querying usage page and usage for every stored value
+    IOHIDElementCookie contactCountCookie;
+    Boolean hasContactCountElement;
+    
+    // one precompiled field map per entry of touchCollectionElements, built in IdentifyElements
+    HIDTouchCollectionMap touchCollectionMaps[HID_DECODER_MAX_COLLECTIONS];
+    CFIndex numTouchCollectionMaps;
+    
+    /**
+     Both paths pass their reports through the frame assembler. It collects the partial reports of hybrid mode by their Relative Scan Time,
+     so the lifecycle code below only ever sees complete frames. The timer emits a frame whose remaining partials were lost.
+     */
+    HIDFrameAssembler frameAssembler;
+    CFRunLoopTimerRef frameTimeoutTimer;
+    uint64_t lastReportTime;    // host time in ns of the last report passed to the assembler
+    
+    // HIDDropPolicyDropOldest: the newest frame that found the frame ring full, pushed once the gesture stage made room
+    HIDFrameRingEntry pendingFrame;
+    Boolean hasPendingFrame;
+    
+    // maps the Relative Scan Time of the frames to the host timeline, every contact carries the time it was sampled at
+    HIDDeviceClock deviceClock;
+    
+    // position based deduplication, all contacts of a frame are assigned at once
+    HIDContactTracker contactTracker;
+    
+    // smoothes the positions per internal touch ID, tuned per panel family
+    HIDJitterFilter jitterFilter;
+    
+    // palm rejection, see RejectContact
+    float maxContactSize;       // relative to the screen, tuned per panel family
+    Boolean usesTouchValid;     // the device set Touch Valid at least once, so a cleared flag means low confidence
+    HIDTouchIDSet rejectedTouchIDsThisCycle;
+    HIDTouchIDSet rejectedTouchIDsLastCycle;
+    
+    // ROBUST TOUCH LIFECYCLE: Set-basiertes Tracking, ein Bit pro interner Touch-ID
+    HIDTouchIDSet activeTouchIDsThisCycle;  // Touch-IDs im aktuellen Cycle
+    HIDTouchIDSet activeTouchIDsLastCycle;  // Touch-IDs im vorherigen Cycle
+    
+    // the frame in progress for the touch manager, handed over in one call by CompleteFrame
+    TouchInputManagerContact frameContacts[kMaxFrameContacts];
+    CFIndex numFrameContacts;
+    
+    // debug output of DispatchContact, times in ms since the device connected
+    uint64_t connectTime;       // mach absolute time
+    int numDispatchedContacts;
+    CFIndex lastTipSwitch;
+    CFIndex lastContactID;
+    uint64_t lastDispatchTime;
+} HIDDeviceContext;
+
+
+static HIDDeviceContext *gDevices[MAX_DEVICES];
+
+
+static HIDDeviceContext *DeviceContextForDevice(IOHIDDeviceRef device) {
+    for (int i = 0; i < MAX_DEVICES; i++) {
+        if (gDevices[i] && gDevices[i]->device == device) {
+            return gDevices[i];
         }
     }
-    
-    // Sollte nie passieren (MAX_ACTIVE_TOUCHES zu klein)
-    TouchLog("[DEDUP-WARN] All slots full, using HW-ID=%ld directly", (long)hardwareID);
-    return hardwareID;
+    return NULL;
 }
 
-// Markiere Touch als beendet (tip=0)
-static void DeactivateTouchByID(CFIndex internalID) {
-    for (int i = 0; i < MAX_ACTIVE_TOUCHES; i++) {
-        if (gActiveTouches[i].internalID == internalID && gActiveTouches[i].isActive) {
-            gActiveTouches[i].isActive = FALSE;
-            TouchLog("[DEDUP-DEACTIVATE] ID=%ld deactivated", (long)internalID);
-            // Reset wird beim nächsten MapPositionToInternalID() Aufruf gecheckt
-            return;
+
+static CFIndex NumberOfDevices(void) {
+    CFIndex count = 0;
+    for (int i = 0; i < MAX_DEVICES; i++) {
+        if (gDevices[i]) {
+            count++;
         }
     }
+    return count;
 }
 
+
+
+
 // SIMPLE & ROBUST TOUCH LIFECYCLE: Set-basiertes Tracking mit Hardware-IDs
 // Hardware-IDs direkt verwenden - keine komplexe Remapping-Logik nötig
-static uint64_t gStartTime = 0;     // Für relative Timestamps
-
-// ROBUST TOUCH LIFECYCLE: Set-basiertes Tracking
-static CFMutableSetRef gActiveTouchIDsThisCycle = NULL;   // Touch-IDs im aktuellen Cycle (als CFNumber)
-static CFMutableSetRef gActiveTouchIDsLastCycle = NULL;   // Touch-IDs im vorherigen Cycle
-static Boolean gReportCycleInProgress = FALSE;             // Sind wir mitten in einem Report-Cycle?
 
-// Hilfsfunktion: Hole aktuelle Zeit in Millisekunden
-static uint64_t GetCurrentTimeMS(void) {
-    if (gStartTime == 0) {
-        gStartTime = mach_absolute_time();
-    }
-    
+// Hilfsfunktion: mach_absolute_time → Nanosekunden
+static uint64_t HostTimeToNanoseconds(uint64_t hostTime) {
     static mach_timebase_info_data_t timebase;
     if (timebase.denom == 0) {
         mach_timebase_info(&timebase);
     }
-    
-    uint64_t elapsed = mach_absolute_time() - gStartTime;
-    return (elapsed * timebase.numer) / (timebase.denom * 1000000ULL);
+    return hostTime * timebase.numer / timebase.denom;
+}
+
+// Hilfsfunktion: Zeit seit dem Verbinden des Geräts in Millisekunden
+static uint64_t GetDeviceTimeMS(const HIDDeviceContext *context) {
+    return HostTimeToNanoseconds(mach_absolute_time() - context->connectTime) / 1000000ULL;
 }
 
 
@@ -381,87 +369,100 @@ void PrintInput(IOHIDValueRef inHIDValue) {
 #pragma mark - Storing Values
 
 
-int64_t StorageKeyForElement(IOHIDElementRef element) {
+uint32_t StorageKeyForElement(IOHIDElementRef element) {
     return IOHIDElementGetCookie(element);
 }
 
 
 
-CFIndex ValueOfElement(IOHIDElementRef element) {
+CFIndex ValueOfElement(HIDDeviceContext *context, IOHIDElementRef element) {
     
     if (!element) {
         return kCFNotFound;
     }
     
-    int64_t hash = StorageKeyForElement(element);
-    CFNumberRef key = CFNumberCreate(kCFAllocatorDefault, kCFNumberSInt32Type, &hash);
-    
-    if (CFDictionaryContainsKey(gStoredInputValues, key)) {
-        CFIndex value;
-        CFNumberRef num = CFDictionaryGetValue(gStoredInputValues, key);
-        CFNumberGetValue(num, kCFNumberCFIndexType, &value);
-        CFRelease(key);
-        return value;
-        
+    int64_t value;
+    if (HIDValueStoreGet(&context->storedInputValues, StorageKeyForElement(element), &value)) {
+        return (CFIndex)value;
     }
     return kCFNotFound;
-
 }
 
 
 
-void StoreInputValue(IOHIDValueRef hidValue) {
+void StoreInputValue(HIDDeviceContext *context, IOHIDValueRef hidValue) {
     
     CFIndex value = IOHIDValueGetIntegerValue(hidValue);
     IOHIDElementRef elem = IOHIDValueGetElement(hidValue);
     
-    CFIndex keyValue = StorageKeyForElement(elem);
+    uint32_t key = StorageKeyForElement(elem);
     
-    CFNumberRef key = CFNumberCreate(kCFAllocatorDefault, kCFNumberSInt32Type, &keyValue);
+    HIDValueStoreSet(&context->storedInputValues, key, value);
     
-    CFNumberRef num = CFNumberCreate(kCFAllocatorDefault, kCFNumberCFIndexType, &value);
-    
-    CFDictionarySetValue(gStoredInputValues, key, num);
-    
-    CFRelease(num);
-    CFRelease(key);
-    
-    
-    // special case: contact count could be zero in hybrid mode --> s
-    CFIndex page = IOHIDElementGetUsagePage(elem);
-    CFIndex usage = IOHIDElementGetUsage(elem);
+    TUCLogTrace(HID, "[StoreInput] cookie=%u value=%ld", key, (long)value);
+}
+
+
+
+
+/**
+ Looks up once which cookie holds which field of a touch collection and precomputes the normalization of position and size,
+ so dispatching a collection does not have to walk its children and query usages again for every report.
+ */
+static void BuildTouchCollectionMap(IOHIDElementRef collection, HIDTouchCollectionMap *map) {
+    HIDTouchCollectionMapInit(map);
     
-    // Debug: Zeige alle Digitizer-Eingaben
-    static int inputCount = 0;
-    if (page == kHIDPage_Digitizer && ++inputCount % 50 == 0) {
-        printf("[StoreInput] #%d page=0x%lx usage=0x%lx value=%ld\n",
-               inputCount, (long)page, (long)usage, (long)value);
-    }
+    CFArrayRef children = IOHIDElementGetChildren(collection);
     
-    if (page == kHIDPage_Digitizer && usage == kHIDUsage_Dig_ContactCount) {
-        printf("[ContactCount] value=%ld (previous gContactCount=%ld)\n", 
-               (long)value, (long)gContactCount);
-        // hybrid mode can only exist if the old value is larger than the number of collections that can be communicated at once
-        CFIndex numCollections =  CFArrayGetCount(gTouchCollectionElements);
+    for (CFIndex i=0; children && i<CFArrayGetCount(children); i++) {
+        IOHIDElementRef element = (IOHIDElementRef)CFArrayGetValueAtIndex(children, i);
         
-        if (gContactCount > numCollections && value == 0 && gHybridOffset > 0) {
-            gTouchscreenUsesHybridMode = TRUE;
-            
-        } else {
-            gContactCount = value;
-            gHybridOffset = 0;
+        CFIndex page = IOHIDElementGetUsagePage(element);
+        CFIndex usage = IOHIDElementGetUsage(element);
+        HIDTouchField field = HIDTouchFieldCount;
+        
+        if (page == kHIDPage_GenericDesktop) {
+            if (usage == kHIDUsage_GD_X) {
+                field = HIDTouchFieldX;
+            } else if (usage == kHIDUsage_GD_Y) {
+                field = HIDTouchFieldY;
+            }
+        } else if (page == kHIDPage_Digitizer) {
+            if (usage == kHIDUsage_Dig_ContactIdentifier) {
+                field = HIDTouchFieldContactID;
+            } else if (usage == kHIDUsage_Dig_TipSwitch) {
+                field = HIDTouchFieldTip;
+            } else if (usage == kHIDUsage_Dig_TouchValid) {
+                field = HIDTouchFieldValid;
+            } else if (usage == kHIDUsage_Dig_Width) {
+                field = HIDTouchFieldWidth;
+            } else if (usage == kHIDUsage_Dig_Height) {
+                field = HIDTouchFieldHeight;
+            } else if (usage == kHIDUsage_Dig_Azimuth) {
+                field = HIDTouchFieldAzimuth;
+            }
+        }
+        
+        // first element wins, like the old lookup did for duplicate usages
+        if (field == HIDTouchFieldCount || map->slots[field] != kHIDValueStoreNoSlot) {
+            continue;
+        }
+        
+        map->slots[field] = StorageKeyForElement(element);
+        
+        if (field == HIDTouchFieldX || field == HIDTouchFieldY || field == HIDTouchFieldWidth || field == HIDTouchFieldHeight) {
+            HIDTouchCollectionMapSetRange(map, field, IOHIDElementGetLogicalMin(element), IOHIDElementGetLogicalMax(element));
         }
     }
 }
 
 
 
-
 /**
  We need to inspect the HID tree as a whole once to see which elements are grouped into logical groups of touch data.
  Just pass in any element of the tree, the function will walk up the tree, search for the logical groups and rememeber them in the global variables.
  */
-void IdentifyElements(IOHIDElementRef anyElement, Boolean printTree) {
+void IdentifyElements(HIDDeviceContext *context, IOHIDElementRef anyElement, Boolean printTree) {
     
     IOHIDElementRef applicationCollection = anyElement;
     IOHIDElementType type = kIOHIDElementTypeOutput;
@@ -476,7 +477,7 @@ void IdentifyElements(IOHIDElementRef anyElement, Boolean printTree) {
         }
     }
     
-    gApplicationCollectionElement = applicationCollection;
+    context->applicationCollectionElement = applicationCollection;
     
     
     CFArrayRef children = IOHIDElementGetChildren(applicationCollection);
@@ -486,6 +487,26 @@ void IdentifyElements(IOHIDElementRef anyElement, Boolean printTree) {
         printf("# parent (type %u) has %ld children:\n", type, numChildren);
     }
     
+    // size the value store by the highest cookie of the tree, values are stored by cookie afterwards
+    uint32_t maxCookie = StorageKeyForElement(applicationCollection);
+    for (CFIndex i=0; i<numChildren; i++) {
+        IOHIDElementRef element = (IOHIDElementRef)CFArrayGetValueAtIndex(children, i);
+        uint32_t cookie = StorageKeyForElement(element);
+        if (cookie > maxCookie) maxCookie = cookie;
+        
+        CFArrayRef grandchildren = IOHIDElementGetChildren(element);
+        for (CFIndex j=0; grandchildren && j<CFArrayGetCount(grandchildren); j++) {
+            cookie = StorageKeyForElement((IOHIDElementRef)CFArrayGetValueAtIndex(grandchildren, j));
+            if (cookie > maxCookie) maxCookie = cookie;
+        }
+    }
+    HIDValueStoreCreate(&context->storedInputValues, maxCookie);
+    context->hasContactCountElement = FALSE;
+    
+    CFArrayRemoveAllValues(context->touchCollectionElements);
+    context->numTouchCollectionMaps = 0;
+    context->scanTimeElement = NULL;
+    
     
     for (CFIndex i=0; i<numChildren; i++) {
         IOHIDElementRef element = (IOHIDElementRef)CFArrayGetValueAtIndex(children, i);
@@ -496,7 +517,11 @@ void IdentifyElements(IOHIDElementRef anyElement, Boolean printTree) {
         IOHIDElementCollectionType collectionType = IOHIDElementGetCollectionType(element);
         
         if (type == kIOHIDElementTypeCollection && collectionType == kIOHIDElementCollectionTypeLogical) {
-            CFArrayAppendValue(gTouchCollectionElements, element);
+            if (context->numTouchCollectionMaps >= HID_DECODER_MAX_COLLECTIONS) {
+                continue;
+            }
+            CFArrayAppendValue(context->touchCollectionElements, element);
+            BuildTouchCollectionMap(element, &context->touchCollectionMaps[context->numTouchCollectionMaps++]);
             
             if (printTree) {
                 printf(" > Logical collection %ld\n", i);
@@ -514,13 +539,18 @@ void IdentifyElements(IOHIDElementRef anyElement, Boolean printTree) {
         } // logical collection
         
         else if (page == kHIDPage_Digitizer && usage == kHIDUsage_Dig_ContactCount) {
+            context->contactCountCookie = StorageKeyForElement(element);
+            context->hasContactCountElement = TRUE;
             if (printTree) {
                 printf(" > Contact Count\n");
             }
         }
         
         else if (page == kHIDPage_Digitizer && usage == kHIDUsage_Dig_RelativeScanTime) {
-            gScanTimeElement = element;
+            context->scanTimeElement = element;
+            if (!context->usesReportDecoder) {
+                HIDDeviceClockInit(&context->deviceClock, (uint32_t)(IOHIDElementGetLogicalMax(element) + 1), kHIDDeviceClockDefaultUnit);
+            }
             if (printTree) {
                 printf(" > Scan Time\n");
             }
@@ -545,7 +575,7 @@ void IdentifyElements(IOHIDElementRef anyElement, Boolean printTree) {
 #pragma mark - Propagate Touch Data to next layer
 
 
-void PrintTouchCollection(IOHIDElementRef collection) {
+void PrintTouchCollection(HIDDeviceContext *context, IOHIDElementRef collection) {
     CFArrayRef children = IOHIDElementGetChildren(collection);
     
     // get stored values of all touches
@@ -555,7 +585,7 @@ void PrintTouchCollection(IOHIDElementRef collection) {
         CFIndex page = IOHIDElementGetUsagePage(element);
         CFIndex usage = IOHIDElementGetUsage(element);
         CFIndex cookie = IOHIDElementGetCookie(element);
-        CFIndex value = ValueOfElement(element);
+        CFIndex value = ValueOfElement(context, element);
         
         char pageDescr[6]  = "(---)";
         char usageDescr[10] = "(-------)";
@@ -592,344 +622,698 @@ void PrintTouchCollection(IOHIDElementRef collection) {
         
         
         
-        printf("[%u]\t%#02lx\t%#02lx %s\t %8ld\n", cookie, page, usage, usageDescr,  value);
+        // values received during the current report are marked with *
+        char fresh = HIDValueStoreWasSeen(&context->storedInputValues, (uint32_t)cookie) ? '*' : ' ';
+        
+        printf("[%u]\t%#02lx\t%#02lx %s\t %8ld%c\n", cookie, page, usage, usageDescr,  value, fresh);
     }
     printf("\n");
 }
 
 
 /**
- Dispatches touch data for the given collection, but only if all values needed were received
+ Adds a contact to the frame for the touch manager.
  */
-
-void DispatchTouchDataForCollection(IOHIDElementRef collection) {
+static void AppendFrameContact(HIDDeviceContext *context, CFIndex internalTouchID, CGFloat x, CGFloat y, Boolean onSurface, Boolean isValid,
+                               CGFloat width, CGFloat height, CGFloat azimuth, uint64_t timestamp) {
+    if (context->numFrameContacts == kMaxFrameContacts) {
+        return;
+    }
     
-    CFArrayRef children = IOHIDElementGetChildren(collection);
+    context->frameContacts[context->numFrameContacts++] = (TouchInputManagerContact){
+        .contactID = context->contactIDBase + internalTouchID,
+        .x = x,
+        .y = y,
+        .width = width,
+        .height = height,
+        .azimuth = azimuth,
+        .timestamp = timestamp,
+        .onSurface = onSurface,
+        .isValid = isValid,
+    };
+}
 
-    CGFloat x = -1;
-    CGFloat y = -1;
-    
-    CFIndex contactID = 0;
-    CFIndex tipSwitch = 0;
-    CFIndex isValid = 0;
-    
-    CFIndex width   = kCFNotFound;
-    CFIndex height  = kCFNotFound;
-    CFIndex azimuth = kCFNotFound;
-    
-    // get stored values of all touches
-    for (CFIndex i=0; i<CFArrayGetCount(children); i++) {
-        IOHIDElementRef element = (IOHIDElementRef)CFArrayGetValueAtIndex(children, i);
-        
-        CFIndex page = IOHIDElementGetUsagePage(element);
-        CFIndex usage = IOHIDElementGetUsage(element);
-        CFIndex value = ValueOfElement(element);
-        
-        if (value != kCFNotFound) {
-            if (page == kHIDPage_GenericDesktop) {
-                if (usage == kHIDUsage_GD_X) {
-                    CGFloat min = (CGFloat)IOHIDElementGetLogicalMin(element);
-                    CGFloat max = (CGFloat)IOHIDElementGetLogicalMax(element);
-                    CGFloat curr = (CGFloat)value;
-                    x = ( (curr - min) / (max - min) ) + min;
-                }
-                
-                else if (usage == kHIDUsage_GD_Y) {
-                    CGFloat min = (CGFloat)IOHIDElementGetLogicalMin(element);
-                    CGFloat max = (CGFloat)IOHIDElementGetLogicalMax(element);
-                    CGFloat curr = (CGFloat)value;
-                    y = ( (curr - min) / (max - min) ) + min;
-                }
-            } //kHIDPage_GenericDesktop
-            
-            else if (page == kHIDPage_Digitizer) {
-                if (usage == kHIDUsage_Dig_ContactIdentifier) {
-                    contactID = value;
-                } else if (usage == kHIDUsage_Dig_TipSwitch) {
-                    tipSwitch = value;
-                } else if (usage == kHIDUsage_Dig_TouchValid) {
-                    isValid = value;
-                } else if (usage == kHIDUsage_Dig_Width) {
-                    width = value;
-                } else if (usage == kHIDUsage_Dig_Height) {
-                    height = value;
-                } else if (usage == kHIDUsage_Dig_Azimuth) {
-                    azimuth = value;
-                }
-            } // kHIDPage_Digitizer
-        }
-    }
+
+/**
+ Passes the data of one contact on to the touch manager. Used by both the queue and the raw report path.
+ `width` and `height` are relative to the screen, kCFNotFound like `azimuth` if the device does not report them.
+ */
+static void DispatchContact(HIDDeviceContext *context, CFIndex contactID, CFIndex internalTouchID, CGFloat x, CGFloat y,
+                            CFIndex tipSwitch, CFIndex isValid, CGFloat width, CGFloat height, CFIndex azimuth, uint64_t timestamp) {
     
-    // Debug: Zeige ALLE Reports für Diagnose mit Zeitstempel
-    static int reportCount = 0;
-    static CFIndex lastTipSwitch = -1;
-    static CFIndex lastContactID = -1;
-    static uint64_t lastReportTime = 0;
-    reportCount++;
+    // Debug: Zeige ALLE Reports für Diagnose mit Zeitstempel, gezählt pro Gerät
+    int reportCount = ++context->numDispatchedContacts;
     
-    uint64_t now = GetCurrentTimeMS();
-    uint64_t timeSinceLastReport = (lastReportTime == 0) ? 0 : (now - lastReportTime);
-    lastReportTime = now;
+    uint64_t now = GetDeviceTimeMS(context);
+    uint64_t timeSinceLastReport = (reportCount == 1) ? 0 : (now - context->lastDispatchTime);
+    context->lastDispatchTime = now;
     
-    int tipSwitchChanged = (tipSwitch != lastTipSwitch);
-    int contactChanged = (contactID != lastContactID);
-    lastTipSwitch = tipSwitch;
-    lastContactID = contactID;
+    int tipSwitchChanged = (tipSwitch != context->lastTipSwitch);
+    int contactChanged = (contactID != context->lastContactID);
+    context->lastTipSwitch = tipSwitch;
+    context->lastContactID = contactID;
     
-    // POSITION-DEDUPLICATION: Map Position zu stabiler interner ID
+    // POSITION-DEDUPLICATION: internalTouchID kommt aus HIDContactTrackerAssign
     // Hardware verwendet gleiche ContactID für verschiedene Finger im Hybrid-Mode
     Boolean isActive = (tipSwitch == 1);
-    CFIndex internalTouchID = MapPositionToInternalID(contactID, x, y);
     
     // CRITICAL FIX: Nur Touches mit tipSwitch=1 ODER isValid=1 verarbeiten
-    // Leere Slots mit tipSwitch=0 und isValid=0 sind nicht relevant
-    if (tipSwitch == 0 && isValid == 0) {
+    // Leere Slots mit tipSwitch=0 und isValid=0 sind nicht relevant, ebenso abgehobene Finger ohne Touch
+    if ((tipSwitch == 0 && isValid == 0) || internalTouchID == kHIDContactTrackerNoID) {
         // Das ist ein leerer Touch-Slot - ignorieren
         if (reportCount <= 10) {
-            printf("[HID %llums] Report #%d: SKIPPED (empty slot) HW-ID=%ld tip=%ld valid=%ld\n", 
-                   now, reportCount, (long)contactID, (long)tipSwitch, (long)isValid);
+            TUCLogTrace(Frame, "[HID %llums] Report #%d: SKIPPED (empty slot) HW-ID=%ld tip=%ld valid=%ld",
+                        now, reportCount, (long)contactID, (long)tipSwitch, (long)isValid);
         }
         return;
     }
     
     // LIFECYCLE TRACKING: Markiere Touch-ID als aktiv in diesem Cycle
-    if (isActive && gActiveTouchIDsThisCycle != NULL) {
-        CFNumberRef touchIDNum = CFNumberCreate(kCFAllocatorDefault, kCFNumberCFIndexType, &internalTouchID);
-        
+    if (isActive) {
         // Prüfe ob Touch im LETZTEN Cycle aktiv war (nicht im aktuellen!)
-        Boolean wasActiveLastCycle = (gActiveTouchIDsLastCycle != NULL) && 
-                                     CFSetContainsValue(gActiveTouchIDsLastCycle, touchIDNum);
+        Boolean wasActiveLastCycle = TouchIDSetContains(&context->activeTouchIDsLastCycle, internalTouchID);
         
         if (!wasActiveLastCycle) {
             // Neuer Touch - erstmals gesehen
-            TouchLog("TOUCH START: ID=%ld x=%.3f y=%.3f", (long)internalTouchID, x, y);
+            TUCLogDebug(Touch, "TOUCH START: ID=%ld x=%.3f y=%.3f", (long)internalTouchID, x, y);
+            HIDJitterFilterReset(&context->jitterFilter, (int32_t)internalTouchID);
         } else {
-            // Touch-Move - loggen um Bewegungen zu tracken
-            static int moveLogCounter = 0;
-            if (++moveLogCounter % 10 == 0) {
-                TouchLog("TOUCH MOVE: ID=%ld x=%.3f y=%.3f (report #%d)", (long)internalTouchID, x, y, reportCount);
-            }
+            TUCLogTrace(Touch, "TOUCH MOVE: ID=%ld x=%.3f y=%.3f (report #%d)", (long)internalTouchID, x, y, reportCount);
         }
         
-        CFSetAddValue(gActiveTouchIDsThisCycle, touchIDNum);
-        CFRelease(touchIDNum);
+        TouchIDSetAdd(&context->activeTouchIDsThisCycle, internalTouchID);
+        
+        // JITTER FILTER: ein ruhender Finger wird an derselben Position gemeldet, der Manager sieht ihn als stationary
+        float filteredX = (float)x;
+        float filteredY = (float)y;
+        if (HIDJitterFilterApply(&context->jitterFilter, (int32_t)internalTouchID, (double)timestamp / 1e9, &filteredX, &filteredY)) {
+            atomic_fetch_add_explicit(&gNumSuppressedMoves, 1, memory_order_relaxed);
+        }
+        x = filteredX;
+        y = filteredY;
     }
     
     // Zeige alle Reports für die ersten 100, dann nur Changes
     if (reportCount <= 100 || tipSwitchChanged || contactChanged) {
-        printf("[HID %llums +%llums] Report #%d: HW-ID=%ld (mapped→%ld) x=%.2f y=%.2f tip=%ld valid=%ld%s%s\n", 
-               now, timeSinceLastReport, reportCount, 
-               (long)contactID, (long)internalTouchID, x, y, (long)tipSwitch, (long)isValid,
-               tipSwitchChanged ? " [TIP▲]" : "",
-               contactChanged ? " [ID▲]" : "");
+        TUCLogDebug(Frame, "[HID %llums +%llums] Report #%d: HW-ID=%ld (mapped→%ld) x=%.2f y=%.2f tip=%ld valid=%ld%s%s",
+                    now, timeSinceLastReport, reportCount,
+                    (long)contactID, (long)internalTouchID, x, y, (long)tipSwitch, (long)isValid,
+                    tipSwitchChanged ? " [TIP▲]" : "",
+                    contactChanged ? " [ID▲]" : "");
     }
     
-    // Verwende die gemappte ID für den TouchInputManager
-    TouchInputManagerUpdateTouchPosition(gTouchManager, internalTouchID, x, y, (int)tipSwitch, (int)isValid);
+    // Verwende die gemappte ID für den TouchInputManager, die Größe nur solange der Finger aufliegt
+    Boolean hasSize = isActive && width != kCFNotFound && height != kCFNotFound;
+    AppendFrameContact(context, internalTouchID, x, y, tipSwitch == 1, isValid == 1,
+                       hasSize ? width : -1, hasSize ? height : -1, azimuth != kCFNotFound ? (CGFloat)azimuth : 0, timestamp);
     
-//    if (width != kCFNotFound && height != kCFNotFound && azimuth != kCFNotFound) {
-//        TouchInputManagerUpdateTouchSize(gTouchManager, contactID, (CGFloat)width, (CGFloat)height, (CGFloat)azimuth);
-//    }
+}
+
+
+
+static void DispatchDecodedContact(HIDDeviceContext *context, const HIDDecodedContact *contact, int32_t internalTouchID) {
+    CGFloat width   = contact->relativeWidth  < 0 ? kCFNotFound : contact->relativeWidth;
+    CGFloat height  = contact->relativeHeight < 0 ? kCFNotFound : contact->relativeHeight;
+    CFIndex azimuth = contact->azimuth == kHIDDecoderValueAbsent ? kCFNotFound : contact->azimuth;
     
+    DispatchContact(context, contact->contactID, internalTouchID, contact->x, contact->y, contact->tipSwitch, contact->isValid,
+                    width, height, azimuth, contact->timestamp);
 }
 
 
 
-void DispatchTouches(void) {
+/**
+ Palm rejection: decides whether a contact is a finger before anything of it reaches the touch manager. Rejected are contacts
+ - whose larger side exceeds the maximal contact size of the device (palms, forearms, sleeves)
+ - with tip set but Touch Valid cleared, which is how digitizers flag a contact they are not confident about.
+   Some devices report Touch Valid but always leave it 0, so the flag only counts once the device has set it.
+ A rejected touch stays rejected until it is lifted, even if it shrinks meanwhile: palms land and lift edge first.
+ If a finger grows into a palm, its touch ends and the rest of it is rejected.
+ */
+static Boolean RejectContact(HIDDeviceContext *context, const HIDDecodedContact *contact, int32_t internalTouchID) {
+    if (contact->isValid) {
+        context->usesTouchValid = TRUE;
+    }
     
-    // Markiere Beginn eines neuen Report-Cycles beim ersten Aufruf
-    if (!gReportCycleInProgress && gActiveTouchIDsThisCycle != NULL) {
-        gReportCycleInProgress = TRUE;
-        printf("[LIFECYCLE] Neuer Report-Cycle beginnt\n");
+    if (internalTouchID == kHIDContactTrackerNoID) {
+        return FALSE;
     }
-
-    CFIndex numCollections = CFArrayGetCount(gTouchCollectionElements);
-    CFIndex remainingUpdates = gContactCount - gHybridOffset;
     
-    CFIndex numUpdates = numCollections;
-    if (remainingUpdates < numCollections) {
-        numUpdates = remainingUpdates;
+    // still the same palm, its lift does not reach the touch manager either
+    if (TouchIDSetContains(&context->rejectedTouchIDsLastCycle, internalTouchID)) {
+        if (contact->tipSwitch) {
+            TouchIDSetAdd(&context->rejectedTouchIDsThisCycle, internalTouchID);
+        }
+        return TRUE;
     }
     
-    CFIndex numElementsToPost = CFArrayGetCount(gTouchCollectionElements);
-    if (numUpdates < numElementsToPost)
-        numElementsToPost = numUpdates;
+    if (!contact->tipSwitch) {
+        return FALSE;
+    }
+    
+    float size = contact->relativeWidth > contact->relativeHeight ? contact->relativeWidth : contact->relativeHeight;
+    Boolean isOversized = size > context->maxContactSize;
+    Boolean isUnconfident = context->usesTouchValid && !contact->isValid;
     
-    // CRITICAL FIX: Falls gContactCount noch nicht aktualisiert wurde, aber wir haben Touch-Daten
-    // gContactCount basiert auf dem HID ContactCount-Element, das der Touchscreen
-    // möglicherweise nicht zuverlässig sendet. Daher: Verarbeite mindestens 1 Touch,
-    // wenn wir gTouchCollectionElements haben
-    if (numElementsToPost == 0 && numCollections > 0) {
-        // ContactCount wurde nicht aktualisiert, aber wir haben Touch Collections
-        // Das ist normal bei manchen Touchscreens - verarbeite einfach alle Collections
-        numElementsToPost = numCollections;
-        printf("[DISPATCH] ContactCount nicht aktualisiert, verarbeite alle %ld Touches trotzdem\n", 
-               (long)numElementsToPost);
+    if (!isOversized && !isUnconfident) {
+        return FALSE;
     }
     
-    static int dispatchCount = 0;
-    if (++dispatchCount % 100 == 0) {
-        printf("[DispatchTouches] #%d: numElementsToPost=%ld gContactCount=%ld\n", 
-               dispatchCount, (long)numElementsToPost, (long)gContactCount);
+    atomic_fetch_add_explicit(isOversized ? &gNumRejectedOversized : &gNumRejectedLowConfidence, 1, memory_order_relaxed);
+    TUCLogDebug(Touch, "[PALM] Touch ID=%ld rejected: size %.3f valid=%d", (long)internalTouchID, size, contact->isValid);
+    
+    TouchIDSetAdd(&context->rejectedTouchIDsThisCycle, internalTouchID);
+    return TRUE;
+}
+
+
+
+/**
+ Ends the frame: touches of the last frame that are missing now have ended, the touch manager gets the whole frame in one call.
+ If partial reports of the frame were lost, missing touches are carried over instead, they most likely were in the lost part.
+ Rejected touches only free their tracker slot once they were lifted.
+ */
+static void CompleteFrame(HIDDeviceContext *context, Boolean isComplete, uint64_t timestamp) {
+    
+    // LIFECYCLE MANAGEMENT: Frame ist abgeschlossen
+    // Finde alle Touches die im LETZTEN Frame aktiv waren aber NICHT im aktuellen Frame (last & ~this)
+    HIDTouchIDSet *thisCycle = &context->activeTouchIDsThisCycle;
+    const HIDTouchIDSet *lastCycle = &context->activeTouchIDsLastCycle;
+    HIDTouchIDSet *rejectedThisCycle = &context->rejectedTouchIDsThisCycle;
+    const HIDTouchIDSet *rejectedLastCycle = &context->rejectedTouchIDsLastCycle;
+    
+    for (int word = 0; word < kTouchIDSetWords; word++) {
+        uint64_t ended = lastCycle->words[word] & ~thisCycle->words[word];
+        uint64_t liftedPalms = rejectedLastCycle->words[word] & ~rejectedThisCycle->words[word];
+        
+        if (!isComplete) {
+            // unvollständiger Frame: Touches bleiben aktiv, sie waren wahrscheinlich im verlorenen Teil
+            thisCycle->words[word] |= ended;
+            rejectedThisCycle->words[word] |= liftedPalms;
+            continue;
+        }
+        
+        while (liftedPalms != 0) {
+            HIDContactTrackerRelease(&context->contactTracker, (int32_t)(word * 64 + __builtin_ctzll(liftedPalms)));
+            liftedPalms &= liftedPalms - 1;
+        }
+        
+        // Sende tip=0 für alle Touches die VERSCHWUNDEN sind, aufsteigend nach ID
+        while (ended != 0) {
+            CFIndex touchID = word * 64 + __builtin_ctzll(ended);
+            ended &= ended - 1;
+            
+            TUCLogDebug(Touch, "[LIFECYCLE END] Touch ID=%ld war aktiv, ist jetzt weg → sende tip=0", (long)touchID);
+            
+            // CRITICAL: Deaktiviere Touch in Position-Dedup System
+            // (außer er wurde zur Handfläche, dann behält er seinen Slot bis zum Abheben)
+            if (!TouchIDSetContains(rejectedThisCycle, touchID)) {
+                HIDContactTrackerRelease(&context->contactTracker, (int32_t)touchID);
+            }
+            
+            AppendFrameContact(context, touchID, 0.0, 0.0, FALSE, FALSE, -1, -1, 0, timestamp);
+        }
     }
     
-    if (numElementsToPost > 0) {
-        DebugLog("DispatchTouches: %ld contacts to dispatch (%ld total)", numElementsToPost, gContactCount);
-        printf("[DispatchTouches] Processing %ld elements, ContactCount=%ld\n", 
-               (long)numElementsToPost, (long)gContactCount);
+    // one bridge call per frame: all contacts, then the frame logic of the touch manager
+    TouchInputManagerProcessFrame(gTouchManager, context->slot, context->frameContacts, context->numFrameContacts, timestamp);
+    context->numFrameContacts = 0;
+    
+    // Logge nur wenn Anzahl sich ÄNDERT (nicht bei jedem Report!)
+    CFIndex count = TouchIDSetCount(thisCycle);
+    CFIndex lastCycleCount = TouchIDSetCount(lastCycle);
+    
+    if (count != lastCycleCount) {
+        if (count > 0) {
+            TUCLogDebug(Touch, "[LIFECYCLE] Cycle: %ld aktive Touches (vorher: %ld)", (long)count, (long)lastCycleCount);
+        } else {
+            TUCLogDebug(Touch, "[LIFECYCLE] Cycle: 0 aktive Touches (alle beendet)");
+        }
     }
     
-    // update the touch data
-    for (CFIndex i=0; i<numElementsToPost; i++) {
-        IOHIDElementRef collection = (IOHIDElementRef)CFArrayGetValueAtIndex(gTouchCollectionElements, i);
-        DispatchTouchDataForCollection(collection);
+    // Swap: Aktueller Frame → Letzter Frame, Reset für nächsten Frame
+    context->activeTouchIDsLastCycle = *thisCycle;
+    *thisCycle = (HIDTouchIDSet){0};
+    context->rejectedTouchIDsLastCycle = *rejectedThisCycle;
+    *rejectedThisCycle = (HIDTouchIDSet){0};
+}
+
+
+
+/**
+ Gesture stage: dispatches all contacts of one complete (or timed out) frame.
+ */
+static void ProcessFrame(HIDDeviceContext *context, const HIDTouchFrame *frame) {
+    int32_t internalTouchIDs[HID_FRAME_MAX_CONTACTS];
+    HIDContactTrackerAssign(&context->contactTracker, frame->contacts, frame->numContacts, internalTouchIDs);
+    
+    for (uint32_t i = 0; i < frame->numContacts; i++) {
+        if (RejectContact(context, &frame->contacts[i], internalTouchIDs[i])) {
+            continue;
+        }
+        DispatchDecodedContact(context, &frame->contacts[i], internalTouchIDs[i]);
     }
     
-    gHybridOffset = gHybridOffset + numUpdates;
+    uint64_t timestamp = frame->numContacts > 0 ? frame->contacts[0].timestamp : HostTimeToNanoseconds(mach_absolute_time());
+    CompleteFrame(context, frame->isComplete, timestamp);
+}
+
+
+
+#pragma mark - Gesture Stage
+
+// report to post latency in buckets of 50 µs, everything above 50 ms lands in the last bucket
+#define kLatencyBucketWidth     50000
+#define kLatencyNumBuckets      1000
+#define kLatencyReportInterval  1000    // frames
+
+static uint32_t gLatencyHistogram[kLatencyNumBuckets];
+static uint32_t gNumLatencySamples;
+static uint64_t gMaxLatency;
+
+
+static double LatencyPercentile(double percentile) {
+    uint32_t rank = (uint32_t)(gNumLatencySamples * percentile);
+    uint32_t count = 0;
+    for (int i = 0; i < kLatencyNumBuckets; i++) {
+        count += gLatencyHistogram[i];
+        if (count > rank) {
+            return (i + 1) * kLatencyBucketWidth / 1e6;
+        }
+    }
+    return kLatencyNumBuckets * kLatencyBucketWidth / 1e6;
+}
+
+
+/**
+ Records the time from the arrival of the last report of a frame until the gesture stage posted its events.
+ */
+static void RecordLatency(uint64_t arrivalTime) {
+    uint64_t now = HostTimeToNanoseconds(mach_absolute_time());
+    uint64_t latency = now > arrivalTime ? now - arrivalTime : 0;
     
-    if (gHybridOffset == gContactCount) {
-        gHybridOffset = 0;
+    uint64_t bucket = latency / kLatencyBucketWidth;
+    gLatencyHistogram[bucket < kLatencyNumBuckets ? bucket : kLatencyNumBuckets - 1]++;
+    gNumLatencySamples++;
+    if (latency > gMaxLatency) {
+        gMaxLatency = latency;
     }
+    
+    if (gNumLatencySamples == kLatencyReportInterval) {
+        TUCLogInfo(Frame, "Latency report -> post over %u frames: p50 %.2f ms, p99 %.2f ms, max %.2f ms (%s)",
+                   gNumLatencySamples, LatencyPercentile(0.5), LatencyPercentile(0.99), gMaxLatency / 1e6,
+                   HID_USE_INPUT_THREAD ? "HID thread" : "main run loop");
+        
+        memset(gLatencyHistogram, 0, sizeof(gLatencyHistogram));
+        gNumLatencySamples = 0;
+        gMaxLatency = 0;
+    }
+}
 
-    if (gHybridOffset == 0) {
-        if (gContactCount > 0) {
-            DebugLog("DispatchTouches: Sending report with %ld contacts to TouchManager", gContactCount);
+
+static void ReleaseDeviceContext(HIDDeviceContext *context);
+
+
+/**
+ Runs on the gesture queue: processes everything the HID thread pushed since the last drain.
+ */
+static void DrainFrameRing(void *unused) {
+    // cleared before popping: a push after this point schedules the next drain
+    atomic_store(&gIsDrainScheduled, false);
+    
+    HIDFrameRingEntry entry;
+    while (HIDFrameRingPop(&gFrameRing, &entry)) {
+        HIDDeviceContext *context = entry.device;
+        
+        // the pop is visible before the flag is read, see WaitAndPush
+        atomic_thread_fence(memory_order_seq_cst);
+        if (atomic_load_explicit(&gIsWaitingForSpace, memory_order_relaxed) && atomic_exchange(&gIsWaitingForSpace, false)) {
+            dispatch_semaphore_signal(gFrameRingSpace);
         }
         
-        // LIFECYCLE MANAGEMENT: Report-Cycle ist abgeschlossen
-        // Finde alle Touches die im LETZTEN Cycle aktiv waren aber NICHT im aktuellen Cycle
-        if (gActiveTouchIDsLastCycle != NULL && gActiveTouchIDsThisCycle != NULL) {
-            CFIndex lastCycleCount = CFSetGetCount(gActiveTouchIDsLastCycle);
-            
-            if (lastCycleCount > 0) {
-                const void **lastCycleTouches = malloc(sizeof(void*) * lastCycleCount);
-                CFSetGetValues(gActiveTouchIDsLastCycle, lastCycleTouches);
-                
-                // Sende tip=0 für alle Touches die VERSCHWUNDEN sind
-                for (CFIndex i = 0; i < lastCycleCount; i++) {
-                    CFNumberRef touchIDNum = (CFNumberRef)lastCycleTouches[i];
-                    
-                    // War dieser Touch im letzten Cycle aktiv aber NICHT im aktuellen?
-                    if (!CFSetContainsValue(gActiveTouchIDsThisCycle, touchIDNum)) {
-                        CFIndex touchID;
-                        CFNumberGetValue(touchIDNum, kCFNumberCFIndexType, &touchID);
-                        
-                        printf("[LIFECYCLE END] Touch ID=%ld war aktiv, ist jetzt weg → sende tip=0\n", (long)touchID);
-                        TouchLog("TOUCH END: ID=%ld (disappeared from reports)", (long)touchID);
-                        
-                        // CRITICAL: Deaktiviere Touch in Position-Dedup System
-                        DeactivateTouchByID(touchID);
-                        
-                        TouchInputManagerUpdateTouchPosition(gTouchManager, touchID, 0.0, 0.0, 0, 0);
-                    }
+        switch (entry.event) {
+            case HIDFrameRingEventFrame: {
+                // a complete frame describes all fingers, so a newer frame of the device supersedes this one
+                const HIDFrameRingEntry *next = HIDFrameRingPeek(&gFrameRing);
+                if (atomic_load_explicit(&gDropPolicy, memory_order_relaxed) == HIDDropPolicyDropOldest
+                    && next && next->event == HIDFrameRingEventFrame && next->device == entry.device && next->frame.isComplete) {
+                    atomic_fetch_add_explicit(&gNumDroppedFrames, 1, memory_order_relaxed);
+                    break;
                 }
                 
-                free(lastCycleTouches);
+                ProcessFrame(context, &entry.frame);
+                RecordLatency(entry.arrivalTime);
+                break;
             }
-        }
-        
-        TouchInputManagerDidProcessReport(gTouchManager);
-        
-        // Swap: Aktueller Cycle → Letzter Cycle für nächsten Report
-        if (gActiveTouchIDsLastCycle != NULL && gActiveTouchIDsThisCycle != NULL) {
-            CFSetRemoveAllValues(gActiveTouchIDsLastCycle);
-            
-            // Kopiere alle Touch-IDs vom aktuellen zum letzten Cycle
-            CFIndex count = CFSetGetCount(gActiveTouchIDsThisCycle);
-            static CFIndex lastCycleCount = 0;  // Merke vorherige Anzahl für Change-Detection
-            
-            if (count > 0) {
-                const void **values = malloc(sizeof(void*) * count);
-                CFSetGetValues(gActiveTouchIDsThisCycle, values);
-                for (CFIndex i = 0; i < count; i++) {
-                    CFSetAddValue(gActiveTouchIDsLastCycle, values[i]);
-                }
-                free(values);
                 
-                // Logge nur wenn Anzahl sich ÄNDERT (nicht bei jedem Report!)
-                if (count != lastCycleCount) {
-                    printf("[LIFECYCLE] Cycle: %ld aktive Touches (vorher: %ld)\n", (long)count, (long)lastCycleCount);
-                    TouchLog("CYCLE: %ld active touch(es)", (long)count);
-                    lastCycleCount = count;
+            case HIDFrameRingEventDeviceAdded:
+                TouchInputManagerDidConnectTouchscreen(gTouchManager);
+                break;
+                
+            case HIDFrameRingEventDeviceRemoved: {
+                // the screen sends no frames anymore: an empty complete frame ends the touches it still has,
+                // otherwise they would stay down until the timeout counts frames of this screen, which never come
+                static const HIDTouchFrame kLiftFrame = { .scanTime = kHIDDecoderValueAbsent, .isComplete = true };
+                ProcessFrame(context, &kLiftFrame);
+                
+                ReleaseDeviceContext(context);
+                if (entry.isLastDevice) {
+                    TouchInputManagerDidDisconnectTouchscreen(gTouchManager);
                 }
-            } else if (lastCycleCount > 0) {
-                // Touches beendet - nur loggen wenn vorher welche aktiv waren
-                printf("[LIFECYCLE] Cycle: 0 aktive Touches (alle beendet)\n");
-                TouchLog("CYCLE: 0 active touches (all ended)");
-                lastCycleCount = 0;
+                break;
             }
-            
-            // Reset für nächsten Cycle
-            CFSetRemoveAllValues(gActiveTouchIDsThisCycle);
         }
+    }
+}
+
+
+static void ScheduleDrain(void) {
+    if (!atomic_exchange(&gIsDrainScheduled, true)) {
+        dispatch_async_f(gGestureQueue, NULL, DrainFrameRing);
+    }
+}
+
+
+/**
+ Runs on the HID thread: pushes an entry, sleeping until the drain made room if the ring is full. A drain is always
+ scheduled then, the ring holds entries it has not popped yet.
+ */
+static void WaitAndPush(const HIDFrameRingEntry *entry) {
+    if (HIDFrameRingPush(&gFrameRing, entry)) {
+        return;
+    }
+    
+    if (atomic_fetch_add_explicit(&gNumStalls, 1, memory_order_relaxed) % 100 == 0) {
+        TUCLogWarning(HID, "Gesture stage is behind, HID thread waits (%llu times)", (unsigned long long)atomic_load(&gNumStalls));
+    }
+    
+    for (;;) {
+        atomic_store(&gIsWaitingForSpace, true);
+        // the flag is visible before the push looks at the ring: a pop the push missed signals the semaphore
+        atomic_thread_fence(memory_order_seq_cst);
         
-        gContactCount = 0;
-        gReportCycleInProgress = FALSE;
+        if (HIDFrameRingPush(&gFrameRing, entry)) {
+            if (!atomic_exchange(&gIsWaitingForSpace, false)) {
+                // the drain took the flag, its signal must not wake the next wait
+                dispatch_semaphore_wait(gFrameRingSpace, DISPATCH_TIME_FOREVER);
+            }
+            return;
+        }
+        dispatch_semaphore_wait(gFrameRingSpace, DISPATCH_TIME_FOREVER);
+    }
+}
+
+
+/**
+ Runs on the HID thread: pushes the frame the device set aside, returns false if the ring is still full.
+ */
+static bool PushPendingFrame(HIDDeviceContext *context) {
+    if (!context->hasPendingFrame) {
+        return true;
+    }
+    if (!HIDFrameRingPush(&gFrameRing, &context->pendingFrame)) {
+        return false;
+    }
+    context->hasPendingFrame = false;
+    return true;
+}
+
+
+/**
+ Runs on the HID thread: keeps a frame that did not fit into the ring, replacing (and dropping) an older one.
+ */
+static void SetFrameAside(HIDDeviceContext *context, const HIDFrameRingEntry *entry) {
+    if (context->hasPendingFrame) {
+        atomic_fetch_add_explicit(&gNumDroppedFrames, 1, memory_order_relaxed);
+    }
+    memcpy(&context->pendingFrame, entry, offsetof(HIDFrameRingEntry, frame.contacts) + entry->frame.numContacts * sizeof(HIDDecodedContact));
+    context->hasPendingFrame = true;
+}
+
+
+/**
+ Runs on the HID thread: hands an entry to the gesture stage.
+ With HIDDropPolicyDropOldest the HID thread never waits: a frame that finds the ring full is set aside and replaced by the next
+ one, the frame timeout timer pushes it once there is room again (see ScheduleFrameTimeout). Only the newest frame matters,
+ the gesture stage skips superseded frames anyway. With HIDDropPolicyPreserveAll, and always for connects and disconnects,
+ the HID thread sleeps until the gesture stage made room; meanwhile new reports queue up in the kernel.
+ */
+static void PostToGestureStage(const HIDFrameRingEntry *entry) {
+    HIDDeviceContext *context = entry->device;
+    
+    if (entry->event == HIDFrameRingEventFrame && atomic_load_explicit(&gDropPolicy, memory_order_relaxed) == HIDDropPolicyDropOldest) {
+        // the frame set aside is older and goes first
+        if (!PushPendingFrame(context) || !HIDFrameRingPush(&gFrameRing, entry)) {
+            SetFrameAside(context, entry);
+        }
+    } else {
+        if (context->hasPendingFrame) {
+            if (entry->event == HIDFrameRingEventDeviceRemoved) {
+                atomic_fetch_add_explicit(&gNumDroppedFrames, 1, memory_order_relaxed);
+            } else {
+                // the policy was changed to HIDDropPolicyPreserveAll meanwhile
+                WaitAndPush(&context->pendingFrame);
+            }
+            context->hasPendingFrame = false;
+        }
+        WaitAndPush(entry);
     }
+    
+    ScheduleDrain();
+}
 
-}/*!
+
+
+/**
+ Frame assembler callback on the HID thread: passes one complete (or timed out) frame on to the gesture stage.
+ */
+static void DispatchFrame(const HIDTouchFrame *frame, void *inContext) {
+    HIDDeviceContext *context = inContext;
+    
+    TUCLogTrace(Frame, "[DispatchFrame] %u contacts, scan time %d", frame->numContacts, frame->scanTime);
+    
+    if (!frame->isComplete) {
+        TUCLogDebug(Frame, "[DispatchFrame] Incomplete frame: %u of %u contacts, scan time %d (%llu of %llu frames incomplete)",
+                    frame->numContacts, frame->contactCount, frame->scanTime,
+                    (unsigned long long)context->frameAssembler.numIncompleteFrames,
+                    (unsigned long long)context->frameAssembler.numFrames);
+    }
+    
+    HIDFrameRingEntry entry;
+    entry.event = HIDFrameRingEventFrame;
+    entry.device = context;
+    entry.isLastDevice = false;
+    entry.arrivalTime = context->lastReportTime;
+    memcpy(&entry.frame, frame, offsetof(HIDTouchFrame, contacts) + frame->numContacts * sizeof(HIDDecodedContact));
+    
+    PostToGestureStage(&entry);
+}
+
+
+
+/**
+ Re-arms the timeout timer for the frame in progress. While a frame is set aside, see PostToGestureStage, the timer fires
+ every kPendingFrameRetryInterval at the latest to push it.
+ */
+static void ScheduleFrameTimeout(HIDDeviceContext *context) {
+    if (!context->frameTimeoutTimer) {
+        return;
+    }
+    
+    uint64_t deadline = HIDFrameAssemblerDeadline(&context->frameAssembler);
+    if (context->hasPendingFrame) {
+        uint64_t retry = HostTimeToNanoseconds(mach_absolute_time()) + kPendingFrameRetryInterval;
+        deadline = deadline == 0 || retry < deadline ? retry : deadline;
+    }
+    if (deadline == 0) {
+        CFRunLoopTimerSetNextFireDate(context->frameTimeoutTimer, CFAbsoluteTimeGetCurrent() + 1e9);
+        return;
+    }
+    
+    uint64_t now = HostTimeToNanoseconds(mach_absolute_time());
+    CFTimeInterval delay = deadline > now ? (CFTimeInterval)(deadline - now) / 1e9 : 0;
+    CFRunLoopTimerSetNextFireDate(context->frameTimeoutTimer, CFAbsoluteTimeGetCurrent() + delay);
+}
+
+
+
+static void Handle_FrameTimeout(CFRunLoopTimerRef timer, void *info) {
+    HIDDeviceContext *context = info;
+    if (context->hasPendingFrame && PushPendingFrame(context)) {
+        ScheduleDrain();
+    }
+    HIDFrameAssemblerCheckTimeout(&context->frameAssembler, HostTimeToNanoseconds(mach_absolute_time()), DispatchFrame, context);
+    ScheduleFrameTimeout(context);
+}
+
+
+
+/**
+ Passes one (partial) report on to the frame assembler. Used by both the queue and the raw report path.
+ The contacts are stamped with the time the device sampled them, or the arrival time if the device has no scan time.
+ */
+static void AssembleReport(HIDDeviceContext *context, HIDDecodedReport *report, uint64_t hostTime) {
+    uint64_t now = HostTimeToNanoseconds(hostTime);
+    uint64_t timestamp = now;
+    
+    uint64_t processingTime = HostTimeToNanoseconds(mach_absolute_time());
+    if (processingTime > now && processingTime - now > kStaleReportAge) {
+        atomic_fetch_add_explicit(&gNumStaleReports, 1, memory_order_relaxed);
+        if (atomic_load_explicit(&gDropPolicy, memory_order_relaxed) == HIDDropPolicyDropOldest) {
+            // the assembler treats it like a lost partial report
+            return;
+        }
+    }
+    
+    if (report->scanTime != kHIDDecoderValueAbsent) {
+        timestamp = HIDDeviceClockUpdate(&context->deviceClock, (uint32_t)report->scanTime, now);
+    }
+    
+    for (uint8_t i = 0; i < report->numContacts; i++) {
+        report->contacts[i].timestamp = timestamp;
+    }
+    
+    context->lastReportTime = now;
+    HIDFrameAssemblerAddReport(&context->frameAssembler, report, now, DispatchFrame, context);
+    ScheduleFrameTimeout(context);
+}
+
+
+
+/**
+ Queue path: collects the values of the report that was just stored into a decoded report. `hostTime` is the timestamp of its values.
+ */
+void DispatchTouches(HIDDeviceContext *context, uint64_t hostTime) {
+    HIDDecodedReport report;
+    int64_t value;
+    
+    report.reportID = 0;
+    report.contactCount = kHIDDecoderValueAbsent;
+    report.scanTime = kHIDDecoderValueAbsent;
+    
+    if (context->hasContactCountElement && HIDValueStoreGet(&context->storedInputValues, context->contactCountCookie, &value)) {
+        report.contactCount = (int32_t)value;
+    }
+    if (context->scanTimeElement && HIDValueStoreGet(&context->storedInputValues, StorageKeyForElement(context->scanTimeElement), &value)) {
+        report.scanTime = (int32_t)value;
+    }
+    
+    report.numContacts = (uint8_t)context->numTouchCollectionMaps;
+    for (CFIndex i=0; i<context->numTouchCollectionMaps; i++) {
+        HIDValueStoreReadContact(&context->storedInputValues, &context->touchCollectionMaps[i], &report.contacts[i]);
+    }
+    
+    AssembleReport(context, &report, hostTime);
+    
+    HIDValueStoreBeginFrame(&context->storedInputValues);
+}
+
+
+
+/*!
     @param context void * pointer to your data, often a pointer to an object.
     @param result Completion result of desired operation.
     @param inSender Interface instance sending the completion routine.
 */
 
 static void Handle_QueueValueAvailable(
-            void * _Nullable        context,
+            void * _Nullable        inContext,
             IOReturn                result,
             void * _Nullable        inSender
 ) {
-    static int callCount = 0;
-    callCount++;
-    DebugLog(">>> Queue callback #%d", callCount);
+    HIDDeviceContext *context = inContext;
+    
+    TUCLogTrace(HID, ">>> Queue callback");
     
     int valueCount = 0;
+    uint64_t reportTime = 0;
     do {
         IOHIDValueRef valueRef = IOHIDQueueCopyNextValueWithTimeout((IOHIDQueueRef) inSender, 0.);
         if (!valueRef)  {
-            // finished processing 1 report
+            // finished processing the last report
             if (valueCount > 0) {
-                DebugLog("    Queue had %d values", valueCount);
+                TUCLogTrace(HID, "    Queue had %d values", valueCount);
+                DispatchTouches(context, reportTime);
             }
-            DispatchTouches();
             break;
         }
+        
+        // all values of a report share its timestamp, a new timestamp means the previous report is complete
+        // (the queue may hold several reports if the HID thread was delayed, each of them is dispatched on its own)
+        uint64_t valueTime = IOHIDValueGetTimeStamp(valueRef);
+        if (valueCount > 0 && valueTime != reportTime) {
+            DispatchTouches(context, reportTime);
+        }
+        reportTime = valueTime;
+        
         valueCount++;
         // process the HID value reference
-        StoreInputValue(valueRef);
+        StoreInputValue(context, valueRef);
         
         // Don't forget to release our HID value reference
         CFRelease(valueRef);
     } while (1) ;
+    
+    // the queue does not report overruns, but a callback that drains a full queue most likely missed the values arriving meanwhile
+    if (valueCount >= context->queueDepth) {
+        atomic_fetch_add_explicit(&gNumQueueOverflows, 1, memory_order_relaxed);
+        TUCLogWarning(HID, "Queue overflow: %d values in a queue of %ld", valueCount, (long)context->queueDepth);
+    }
 }
 
 
-static void Handle_InputValueCallback (
-                void *          inContext,      // context from IOHIDManagerRegisterInputValueCallback
-                IOReturn        inResult,       // completion result for the input value operation
-                void *          inSender,       // the IOHIDManagerRef
-                IOHIDValueRef   inIOHIDValueRef // the new element value
+
+static void Handle_ReportCallback(
+                void *          inContext,      // the HIDDeviceContext of the device
+                IOReturn        inResult,       // completion result for the input report operation
+                void *          inSender,       // the IOHIDDeviceRef that sent the report
+                IOHIDReportType inType,         // type of the report
+                uint32_t        inReportID,     // report ID, also contained in the first byte of the buffer if the device uses IDs
+                uint8_t *       inReport,       // the report bytes
+                CFIndex         inReportLength, // length of the report
+                uint64_t        inTimeStamp     // mach absolute time of the report
 ) {
-    if(!gAreElementRefsSet) {
-        IOHIDElementRef e = IOHIDValueGetElement(inIOHIDValueRef);
-        if (gIsELANDevice) {
-            printf("\\n=== ELAN Device Element Structure ===\\n");
-        }
-        IdentifyElements(e, TRUE);
-        gAreElementRefsSet = 1;
-        
-        if (gIsELANDevice) {
-            printf("=== ELAN Device: Found %ld touch collection elements ===\\n\\n", CFArrayGetCount(gTouchCollectionElements));
-        }
+    HIDDeviceContext *context = inContext;
+    if (!context->usesReportDecoder || inResult != kIOReturnSuccess || inType != kIOHIDReportTypeInput) {
+        return;
     }
     
-    IOHIDElementRef elem = IOHIDValueGetElement(inIOHIDValueRef);
+    HIDDecodedReport report;
+    if (!HIDReportDecoderDecode(&context->reportDecoder, inReport, (size_t)inReportLength, &report)) {
+        // not a touch report (e.g. vendor specific or a mouse emulation collection)
+        return;
+    }
+    
+    AssembleReport(context, &report, inTimeStamp);
+}
+
+
+
+/**
+ Compiles the report descriptor of the device into the raw report decoder. Returns FALSE if the device has to use the queue path.
+ */
+static Boolean CompileReportDecoder(HIDDeviceContext *context) {
+    CFTypeRef descriptor = IOHIDDeviceGetProperty(context->device, CFSTR(kIOHIDReportDescriptorKey));
+    if (!descriptor || CFGetTypeID(descriptor) != CFDataGetTypeID()) {
+        TUCLogInfo(HID, "[Decoder] No report descriptor available - using HID queue");
+        return FALSE;
+    }
+    
+    CFDataRef data = (CFDataRef)descriptor;
+    if (!HIDReportDecoderCompile(&context->reportDecoder, CFDataGetBytePtr(data), (size_t)CFDataGetLength(data))) {
+        TUCLogInfo(HID, "[Decoder] Report descriptor has no touch collections - using HID queue");
+        return FALSE;
+    }
     
-    Boolean added = IOHIDQueueContainsElement(gQueue, elem);
-    if(!added) {
-        IOHIDQueueAddElement(gQueue, elem);
-        StoreInputValue(inIOHIDValueRef);
+    for (uint8_t i = 0; i < context->reportDecoder.numReports; i++) {
+        const HIDTouchReportLayout *layout = &context->reportDecoder.reports[i];
+        TUCLogInfo(HID, "[Decoder] Report ID %u: %u bytes, %u touch collections, contact count %s, scan time %s",
+                   layout->reportID, layout->byteLength, layout->numCollections,
+                   layout->contactCount.bitSize ? "yes" : "no",
+                   layout->scanTime.bitSize ? "yes" : "no");
     }
     
+    return TRUE;
 }
 
 
@@ -940,7 +1324,7 @@ static void Handle_InputValueCallback (
 
 // Initialize ELAN device by sending Feature Reports
 static void InitializeELANDevice(IOHIDDeviceRef inIOHIDDeviceRef) {
-    DebugLog("Attempting to initialize ELAN device...");
+    TUCLogInfo(HID, "Attempting to initialize ELAN device...");
     
     // Try to get all Feature elements and read/write them
     CFArrayRef elements = IOHIDDeviceCopyMatchingElements(inIOHIDDeviceRef, 
@@ -948,7 +1332,7 @@ static void InitializeELANDevice(IOHIDDeviceRef inIOHIDDeviceRef) {
                                                           kIOHIDOptionsTypeNone);
     if (elements) {
         CFIndex count = CFArrayGetCount(elements);
-        DebugLog("Device has %ld HID elements, scanning for Feature elements...", count);
+        TUCLogInfo(HID, "Device has %ld HID elements, scanning for Feature elements...", count);
         
         int featureCount = 0;
         for (CFIndex i = 0; i < count; i++) {
@@ -960,7 +1344,7 @@ static void InitializeELANDevice(IOHIDDeviceRef inIOHIDDeviceRef) {
             // Look for feature report elements
             if (type == kIOHIDElementTypeFeature) {
                 featureCount++;
-                DebugLog("[Feature %d] Report ID: %u, Size: %ld bytes", featureCount, reportID, reportSize);
+                TUCLogInfo(HID, "[Feature %d] Report ID: %u, Size: %ld bytes", featureCount, reportID, reportSize);
                 
                 // Try to get the feature report with larger buffer
                 uint8_t buffer[512] = {0};
@@ -973,14 +1357,14 @@ static void InitializeELANDevice(IOHIDDeviceRef inIOHIDDeviceRef) {
                                                          &bufferSize);
                 
                 if (getResult == kIOReturnSuccess) {
-                    DebugLog("  -> Got Feature Report %u (%ld bytes returned)", reportID, bufferSize);
+                    TUCLogInfo(HID, "  -> Got Feature Report %u (%ld bytes returned)", reportID, bufferSize);
                     
                     // Print hex dump of first few bytes
-                    DebugLog("  -> Data (first 16 bytes): %02X %02X %02X %02X %02X %02X %02X %02X %02X %02X %02X %02X %02X %02X %02X %02X",
-                             buffer[0], buffer[1], buffer[2], buffer[3], 
-                             buffer[4], buffer[5], buffer[6], buffer[7],
-                             buffer[8], buffer[9], buffer[10], buffer[11],
-                             buffer[12], buffer[13], buffer[14], buffer[15]);
+                    for (int row = 0; row < 16; row += 8) {
+                        TUCLogInfo(HID, "  -> Data [%2d]: %02X %02X %02X %02X %02X %02X %02X %02X", row,
+                                   buffer[row + 0], buffer[row + 1], buffer[row + 2], buffer[row + 3],
+                                   buffer[row + 4], buffer[row + 5], buffer[row + 6], buffer[row + 7]);
+                    }
                     
                     // Try writing it back (sometimes needed for activation)
                     IOReturn setResult = IOHIDDeviceSetReport(inIOHIDDeviceRef,
@@ -988,22 +1372,22 @@ static void InitializeELANDevice(IOHIDDeviceRef inIOHIDDeviceRef) {
                                                              reportID,
                                                              buffer,
                                                              bufferSize);
-                    DebugLog("  -> Set Feature Report %u back: 0x%08X", reportID, setResult);
+                    TUCLogInfo(HID, "  -> Set Feature Report %u back: 0x%08X", reportID, setResult);
                 } else {
-                    DebugLog("  -> Failed to get Feature Report %u: 0x%08X", reportID, getResult);
+                    TUCLogWarning(HID, "  -> Failed to get Feature Report %u: 0x%08X", reportID, getResult);
                 }
             }
         }
         
-        DebugLog("Scanned %d Feature elements total", featureCount);
+        TUCLogInfo(HID, "Scanned %d Feature elements total", featureCount);
         CFRelease(elements);
     }
     
-    DebugLog("ELAN device initialization complete");
+    TUCLogInfo(HID, "ELAN device initialization complete");
     
     // EXPERIMENTAL: Versuche den Touchscreen zu aktivieren
     // Manche ELAN-Geräte brauchen einen speziellen "Wake Up" oder "Set Mode" Befehl
-    DebugLog("Sending wake-up command to ELAN device...");
+    TUCLogInfo(HID, "Sending wake-up command to ELAN device...");
     
     // Versuch 1: Feature Report 2 mit 0x0F (oft "wake up" oder "set mode")
     uint8_t wakeupCmd1[] = {0x02, 0x0F};
@@ -1012,8 +1396,7 @@ static void InitializeELANDevice(IOHIDDeviceRef inIOHIDDeviceRef) {
                                                 2,
                                                 wakeupCmd1,
                                                 sizeof(wakeupCmd1));
-    DebugLog("Wake-up command 1 (Report 2, 0x0F): 0x%08X", wakeResult1);
-    printf("[ELAN Init] Wake-up cmd 1 result: 0x%08X\n", wakeResult1);
+    TUCLogInfo(HID, "Wake-up command 1 (Report 2, 0x0F): 0x%08X", wakeResult1);
     
     // Versuch 2: Feature Report 2 mit 0x01 (möglicherweise "enable continuous reporting")
     uint8_t wakeupCmd2[] = {0x02, 0x01};
@@ -1022,12 +1405,128 @@ static void InitializeELANDevice(IOHIDDeviceRef inIOHIDDeviceRef) {
                                                 2,
                                                 wakeupCmd2,
                                                 sizeof(wakeupCmd2));
-    DebugLog("Wake-up command 2 (Report 2, 0x01): 0x%08X", wakeResult2);
-    printf("[ELAN Init] Wake-up cmd 2 result: 0x%08X\n", wakeResult2);
+    TUCLogInfo(HID, "Wake-up command 2 (Report 2, 0x01): 0x%08X", wakeResult2);
+    
+    TUCLogInfo(HID, "ELAN device wake-up sequence complete");
+}
+
+static HIDDeviceContext *CreateDeviceContext(IOHIDDeviceRef device, int slot) {
+    HIDDeviceContext *context = calloc(1, sizeof(HIDDeviceContext));
+    if (!context) {
+        return NULL;
+    }
+    
+    context->device = (IOHIDDeviceRef)CFRetain(device);
+    context->slot = slot;
+    context->contactIDBase = slot * kContactIDsPerDevice;
+    
+    context->touchCollectionElements = CFArrayCreateMutable(kCFAllocatorDefault, 0, NULL);
+    
+    HIDContactTrackerInit(&context->contactTracker, kHIDContactTrackerDefaultGate);
+    HIDJitterFilterInit(&context->jitterFilter, kHIDJitterFilterDefaultProfile);
+    context->maxContactSize = kDefaultMaxContactSize;
+    
+    context->connectTime = mach_absolute_time();
+    context->lastTipSwitch = -1;
+    context->lastContactID = -1;
+    
+    HIDFrameAssemblerInit(&context->frameAssembler, kHIDFrameAssemblerDefaultTimeout);
+    CFRunLoopTimerContext timerContext = { 0, context, NULL, NULL, NULL };
+    context->frameTimeoutTimer = CFRunLoopTimerCreate(kCFAllocatorDefault, CFAbsoluteTimeGetCurrent() + 1e9, 1e9, 0, 0,
+                                                      Handle_FrameTimeout, &timerContext);
+    CFRunLoopAddTimer(gRunLoopRef, context->frameTimeoutTimer, kCFRunLoopCommonModes);
+    
+    gDevices[slot] = context;
+    return context;
+}
+
+
+
+/**
+ Releases the HID side of a context on the HID thread. The gesture stage may still hold frames of the device,
+ so the context itself is handed over and released there once they are processed.
+ */
+static void DestroyDeviceContext(HIDDeviceContext *context, Boolean notifyDisconnect) {
+    for (int i = 0; i < MAX_DEVICES; i++) {
+        if (gDevices[i] == context) {
+            gDevices[i] = NULL;
+        }
+    }
+    
+    if (context->queue) {
+        IOHIDQueueStop(context->queue);
+        IOHIDQueueUnscheduleFromRunLoop(context->queue, gRunLoopRef, kCFRunLoopCommonModes);
+        CFRelease(context->queue);
+        atomic_fetch_sub(&gTotalQueueDepth, (uint32_t)context->queueDepth);
+    }
+    
+    if (context->reportBuffer) {
+        IOHIDDeviceRegisterInputReportWithTimeStampCallback(context->device, context->reportBuffer, context->reportBufferSize, NULL, NULL);
+        free(context->reportBuffer);
+    }
+    
+    if (context->frameTimeoutTimer) {
+        CFRunLoopTimerInvalidate(context->frameTimeoutTimer);
+        CFRelease(context->frameTimeoutTimer);
+    }
+    
+    HIDValueStoreDestroy(&context->storedInputValues);
+    CFRelease(context->touchCollectionElements);
+    CFRelease(context->device);
+    context->device = NULL;
+    
+    HIDFrameRingEntry entry;
+    entry.event = HIDFrameRingEventDeviceRemoved;
+    entry.device = context;
+    entry.isLastDevice = notifyDisconnect && NumberOfDevices() == 0;
+    entry.arrivalTime = 0;
+    PostToGestureStage(&entry);
+}
+
+
+
+// gesture stage
+static void ReleaseDeviceContext(HIDDeviceContext *context) {
+    free(context);
+}
+
+
+
+/**
+ Queue depth in values for the queue path: every report carries one value per input element, and in hybrid mode a frame takes
+ as many reports as needed to deliver MAX_ACTIVE_TOUCHES contacts through the touch collections of one report.
+ */
+static CFIndex QueueDepthForLayout(HIDDeviceContext *context, CFIndex valuesPerReport) {
+    CFIndex collectionsPerReport = context->numTouchCollectionMaps > 0 ? context->numTouchCollectionMaps : 1;
+    CFIndex reportsPerFrame = (MAX_ACTIVE_TOUCHES + collectionsPerReport - 1) / collectionsPerReport;
+    
+    return valuesPerReport * reportsPerFrame * kQueueFramesBuffered;
+}
+
+
+
+/**
+ Registers Handle_ReportCallback for the device. The buffer has to hold the largest input report of the device.
+ */
+static void RegisterReportCallback(HIDDeviceContext *context) {
+    CFIndex size = 0;
+    CFNumberRef maxSizeRef = IOHIDDeviceGetProperty(context->device, CFSTR(kIOHIDMaxInputReportSizeKey));
+    if (maxSizeRef) {
+        CFNumberGetValue(maxSizeRef, kCFNumberCFIndexType, &size);
+    }
+    for (uint8_t i = 0; i < context->reportDecoder.numReports; i++) {
+        if (context->reportDecoder.reports[i].byteLength > size) {
+            size = context->reportDecoder.reports[i].byteLength;
+        }
+    }
     
-    DebugLog("ELAN device wake-up sequence complete");
+    context->reportBufferSize = size;
+    context->reportBuffer = malloc((size_t)size);
+    IOHIDDeviceRegisterInputReportWithTimeStampCallback(context->device, context->reportBuffer, size, Handle_ReportCallback, context);
 }
 
+
+
 // this will be called when the HID Manager matches a new (hot plugged) HID device
 static void Handle_DeviceMatchingCallback(
             void *          inContext,       // context from IOHIDManagerRegisterDeviceMatchingCallback
@@ -1053,22 +1552,19 @@ static void Handle_DeviceMatchingCallback(
         CFNumberGetValue(productIDRef, kCFNumberIntType, &productID);
     }
     
-    printf("Device detected - Vendor ID: 0x%04X, Product ID: 0x%04X\n", vendorID, productID);
-    DebugLog("Device detected - Vendor ID: 0x%04X, Product ID: 0x%04X", vendorID, productID);
+    TUCLogInfo(HID, "Device detected - Vendor ID: 0x%04X, Product ID: 0x%04X", vendorID, productID);
     
     if (productRef) {
         char productName[256];
         CFStringGetCString(productRef, productName, sizeof(productName), kCFStringEncodingUTF8);
-        printf("Product Name: %s\n", productName);
-        DebugLog("Product Name: %s", productName);
+        TUCLogInfo(HID, "Product Name: %s", productName);
     }
     
     // Check if this is an ELAN device (by vendor ID OR by product name containing "Elan" or "ELAN")
     bool isELAN = false;
     if (vendorID == kELANVendorID) {
         isELAN = true;
-        printf("Matched by ELAN vendor ID 0x0712\n");
-        DebugLog("Matched by ELAN vendor ID 0x0712");
+        TUCLogInfo(HID, "Matched by ELAN vendor ID 0x0712");
     }
     
     // Also check product name for "Elan" string
@@ -1077,50 +1573,69 @@ static void Handle_DeviceMatchingCallback(
         CFStringGetCString(productRef, productName, sizeof(productName), kCFStringEncodingUTF8);
         if (strcasestr(productName, "elan") != NULL) {
             isELAN = true;
-            printf("Matched by product name containing 'Elan'\n");
-            DebugLog("Matched by product name containing 'Elan': %s", productName);
+            TUCLogInfo(HID, "Matched by product name containing 'Elan': %s", productName);
         }
     }
     
     if (isELAN) {
-        gIsELANDevice = TRUE;
-        printf(">>> ELAN Touchscreen detected! <<<\n");
-        DebugLog(">>> ELAN Touchscreen detected! <<<");
-        TouchLog("DEVICE: ELAN Touchscreen detected - Vendor:0x%04X Product:0x%04X", vendorID, productID);
+        TUCLogInfo(HID, ">>> ELAN Touchscreen detected! <<<");
     } else {
-        gIsELANDevice = FALSE;
-        printf("Device is NOT an ELAN touchscreen - IGNORING\n");
-        DebugLog("Device is NOT an ELAN touchscreen - IGNORING");
-        TouchLog("DEVICE: Non-ELAN device IGNORED - Vendor:0x%04X Product:0x%04X", vendorID, productID);
+        TUCLogInfo(HID, "Device is NOT an ELAN touchscreen - IGNORING");
         
         // CRITICAL: Reject non-ELAN devices (z.B. MacBook Trackpad)
         // Nur ELAN Touchscreens sollen verarbeitet werden
         return;
     }
     
-    gAreElementRefsSet = 0;
-    
+    if (DeviceContextForDevice(inIOHIDDeviceRef)) {
+        return;
+    }
     
-    IOHIDQueueRef queue = IOHIDQueueCreate(kCFAllocatorDefault, inIOHIDDeviceRef, 1000, kNilOptions);
+    int slot = 0;
+    while (slot < MAX_DEVICES && gDevices[slot]) {
+        slot++;
+    }
+    if (slot == MAX_DEVICES) {
+        TUCLogWarning(HID, "Already %d touchscreens connected - IGNORING", MAX_DEVICES);
+        return;
+    }
     
-    if (CFGetTypeID(queue) != IOHIDQueueGetTypeID()) {
-        // this is not a valid HID queue reference!
+    HIDDeviceContext *context = CreateDeviceContext(inIOHIDDeviceRef, slot);
+    if (!context) {
+        return;
+    }
+    context->isELAN = isELAN;
+    if (isELAN) {
+        HIDJitterFilterInit(&context->jitterFilter, kELANJitterFilterProfile);
+        context->maxContactSize = kELANMaxContactSize;
     }
     
-    IOHIDQueueRegisterValueAvailableCallback(queue, Handle_QueueValueAvailable, NULL);
-    IOHIDQueueStart(queue);
-    gQueue = queue;
+    TUCLogInfo(HID, "Touchscreen %d uses contact IDs from %ld", slot, (long)context->contactIDBase);
     
-    IOHIDQueueScheduleWithRunLoop(queue, gRunLoopRef, kCFRunLoopCommonModes);
+    // Prefer the raw report path: no IOHIDValueRef per field and no queue needed
+    context->usesReportDecoder = CompileReportDecoder(context);
+    
+    // the queue path configures the clock when it finds the scan time element
+    HIDDeviceClockInit(&context->deviceClock, 0, kHIDDeviceClockDefaultUnit);
+    for (uint8_t i = 0; context->usesReportDecoder && i < context->reportDecoder.numReports; i++) {
+        const HIDReportField *scanTime = &context->reportDecoder.reports[i].scanTime;
+        if (scanTime->bitSize > 0 && scanTime->logicalMax > 0) {
+            HIDDeviceClockInit(&context->deviceClock, (uint32_t)scanTime->logicalMax + 1, kHIDDeviceClockDefaultUnit);
+            break;
+        }
+    }
+    
+    if (context->usesReportDecoder) {
+        RegisterReportCallback(context);
+    }
     
     // CRITICAL FIX: Proaktiv alle Input-Elemente zur Queue hinzufügen
-    // Nicht warten bis Handle_InputValueCallback aufgerufen wird
+    // Nicht warten bis der erste Wert ankommt
     CFArrayRef allElements = IOHIDDeviceCopyMatchingElements(inIOHIDDeviceRef, NULL, kIOHIDOptionsTypeNone);
     if (allElements) {
         CFIndex elementCount = CFArrayGetCount(allElements);
-        printf("[Queue Setup] Adding %ld elements to queue proactively\n", (long)elementCount);
+        CFMutableArrayRef inputElements = CFArrayCreateMutable(kCFAllocatorDefault, elementCount, NULL);
         
-        int addedCount = 0;
         IOHIDElementRef firstElement = NULL;
         
         for (CFIndex i = 0; i < elementCount; i++) {
@@ -1138,35 +1653,61 @@ static void Handle_DeviceMatchingCallback(
                 type == kIOHIDElementTypeInput_Axis ||
                 type == kIOHIDElementTypeInput_ScanCodes) {
                 
-                IOHIDQueueAddElement(queue, element);
-                addedCount++;
+                CFArrayAppendValue(inputElements, element);
             }
         }
         
-        printf("[Queue Setup] Added %d input elements to queue\n", addedCount);
-        
         // Jetzt identifiziere die Touch-Collections
         if (firstElement) {
-            if (gIsELANDevice) {
+            if (context->isELAN) {
                 printf("\\n=== ELAN Device Element Structure ===\\n");
             }
-            IdentifyElements(firstElement, TRUE);
-            gAreElementRefsSet = 1;
+            IdentifyElements(context, firstElement, TRUE);
             
-            if (gIsELANDevice) {
-                printf("=== ELAN Device: Found %ld touch collection elements ===\\n\\n", CFArrayGetCount(gTouchCollectionElements));
+            if (context->isELAN) {
+                printf("=== ELAN Device: Found %ld touch collection elements ===\\n\\n", CFArrayGetCount(context->touchCollectionElements));
             }
         }
         
+        // the queue is sized once the layout is known
+        if (!context->usesReportDecoder) {
+            CFIndex inputCount = CFArrayGetCount(inputElements);
+            context->queueDepth = QueueDepthForLayout(context, inputCount);
+            atomic_fetch_add(&gTotalQueueDepth, (uint32_t)context->queueDepth);
+            
+            IOHIDQueueRef queue = IOHIDQueueCreate(kCFAllocatorDefault, inIOHIDDeviceRef, context->queueDepth, kNilOptions);
+            
+            if (CFGetTypeID(queue) != IOHIDQueueGetTypeID()) {
+                // this is not a valid HID queue reference!
+            }
+            
+            for (CFIndex i = 0; i < inputCount; i++) {
+                IOHIDQueueAddElement(queue, (IOHIDElementRef)CFArrayGetValueAtIndex(inputElements, i));
+            }
+            TUCLogInfo(HID, "Added %ld input elements to a queue of %ld values", (long)inputCount, (long)context->queueDepth);
+            
+            IOHIDQueueRegisterValueAvailableCallback(queue, Handle_QueueValueAvailable, context);
+            IOHIDQueueStart(queue);
+            context->queue = queue;
+            
+            IOHIDQueueScheduleWithRunLoop(queue, gRunLoopRef, kCFRunLoopCommonModes);
+        }
+        
+        CFRelease(inputElements);
         CFRelease(allElements);
     }
     
     // Initialize ELAN device if detected
-    if (gIsELANDevice) {
+    if (context->isELAN) {
         InitializeELANDevice(inIOHIDDeviceRef);
     }
     
-    TouchInputManagerDidConnectTouchscreen(gTouchManager);
+    HIDFrameRingEntry entry;
+    entry.event = HIDFrameRingEventDeviceAdded;
+    entry.device = context;
+    entry.isLastDevice = false;
+    entry.arrivalTime = 0;
+    PostToGestureStage(&entry);
     
 }   // Handle_DeviceMatchingCallback
  
@@ -1182,20 +1723,17 @@ static void Handle_RemovalCallback(
     printf("%s(context: %p, result: %p, sender: %p, device: %p).\n",
         __PRETTY_FUNCTION__, inContext, (void *) inResult, inSender, (void*) inIOHIDDeviceRef);
     
-    if (gIsELANDevice) {
-        printf("ELAN Touchscreen disconnected\n");
-        gIsELANDevice = FALSE;
+    HIDDeviceContext *context = DeviceContextForDevice(inIOHIDDeviceRef);
+    if (!context) {
+        return;
     }
     
-    IOHIDQueueStop(gQueue);
-    CFRelease(gQueue);
-    gQueue = NULL;
-    
-    CFArrayRemoveAllValues(gTouchCollectionElements);
-    CFArrayRemoveAllValues(gContactIdentifiers);
-    CFDictionaryRemoveAllValues(gStoredInputValues);
+    if (context->isELAN) {
+        printf("ELAN Touchscreen disconnected\n");
+    }
     
-    TouchInputManagerDidDisconnectTouchscreen(gTouchManager);
+    // the touch manager only cares about the last screen
+    DestroyDeviceContext(context, TRUE);
 }   // Handle_RemovalCallback
 
 
@@ -1244,26 +1782,14 @@ static CFMutableDictionaryRef CreateDeviceMatchingDictionary(UInt32 inUsagePage,
 
 
 
-void OpenHIDManager(void *delegate) {
-    gTouchManager = delegate;
-    
-    // Initialize Position-Deduplication für Hybrid-Mode Multi-Touch
-    InitializePositionDeduplication();
-    
+// runs on the thread that owns gRunLoopRef
+static void StartHIDManager(void) {
     gHidManager = IOHIDManagerCreate(kCFAllocatorDefault, kIOHIDOptionsTypeNone);
     
     if (CFGetTypeID(gHidManager) != IOHIDManagerGetTypeID()) {
         printf("OH CRAP THIS IS NOT AN HID MANAGER");
     }
         
-    
-    gTouchCollectionElements = CFArrayCreateMutable(kCFAllocatorDefault, 0, NULL);
-    gContactIdentifiers      = CFArrayCreateMutable(kCFAllocatorDefault, 0, NULL);
-    gStoredInputValues       = CFDictionaryCreateMutable(kCFAllocatorDefault,0, NULL, NULL);
-    
-    // Initialize touch lifecycle tracking sets
-    gActiveTouchIDsThisCycle = CFSetCreateMutable(kCFAllocatorDefault, 0, &kCFTypeSetCallBacks);
-    gActiveTouchIDsLastCycle = CFSetCreateMutable(kCFAllocatorDefault, 0, &kCFTypeSetCallBacks);
    
     printf("Initializing HID Manager with ELAN touchscreen support...\n");
     printf("ELAN Vendor ID: 0x%04X\n", kELANVendorID);
@@ -1288,16 +1814,98 @@ void OpenHIDManager(void *delegate) {
     IOHIDManagerRegisterDeviceMatchingCallback(gHidManager, Handle_DeviceMatchingCallback, NULL);
     IOHIDManagerRegisterDeviceRemovalCallback(gHidManager, Handle_RemovalCallback, NULL);
     
-//    IOHIDManagerRegisterInputReportWithTimeStampCallback(gHidManager, Handle_ReportCallback, NULL);
-    IOHIDManagerRegisterInputValueCallback(gHidManager, Handle_InputValueCallback, NULL);
-    
-    
-    gRunLoopRef = CFRunLoopGetMain();
-    
     IOHIDManagerScheduleWithRunLoop(gHidManager, gRunLoopRef,
                                     kCFRunLoopCommonModes);
 
     IOHIDManagerOpen(gHidManager, kIOHIDOptionsTypeNone);
+}
+
+
+
+// runs on the thread that owns gRunLoopRef
+static void StopHIDManager(void) {
+    IOHIDManagerUnscheduleFromRunLoop(gHidManager, gRunLoopRef, kCFRunLoopCommonModes);
+    IOHIDManagerClose(gHidManager, kIOHIDOptionsTypeNone);
+    
+    for (int i = 0; i < MAX_DEVICES; i++) {
+        if (gDevices[i]) {
+            DestroyDeviceContext(gDevices[i], FALSE);
+        }
+    }
+}
+
+
+
+#pragma mark - HID Thread
+
+/**
+ Asks the scheduler for a time-constraint (real-time) policy: the thread needs little CPU, but needs it right when a report arrives.
+ Falls back to the user interactive QoS class if the policy is not granted.
+ */
+static void SetTimeConstraintPolicy(void) {
+    mach_timebase_info_data_t timebase;
+    mach_timebase_info(&timebase);
+    double absPerNs = (double)timebase.denom / timebase.numer;
+    
+    thread_time_constraint_policy_data_t policy;
+    policy.period      = 0;                                 // reports do not arrive strictly periodic
+    policy.computation = (uint32_t)(500000 * absPerNs);     // 0.5 ms to decode and assemble a report
+    policy.constraint  = (uint32_t)(2000000 * absPerNs);    // finished within 2 ms of arrival
+    policy.preemptible = TRUE;
+    
+    kern_return_t result = thread_policy_set(pthread_mach_thread_np(pthread_self()), THREAD_TIME_CONSTRAINT_POLICY,
+                                             (thread_policy_t)&policy, THREAD_TIME_CONSTRAINT_POLICY_COUNT);
+    if (result != KERN_SUCCESS) {
+        TUCLogWarning(HID, "Time constraint policy not available (0x%08X), using user interactive QoS", result);
+        pthread_set_qos_class_self_np(QOS_CLASS_USER_INTERACTIVE, 0);
+    }
+}
+
+
+
+static void *HIDThreadMain(void *ready) {
+    pthread_setname_np("de.schafe.TouchUp.HID");
+    SetTimeConstraintPolicy();
+    
+    gRunLoopRef = CFRunLoopGetCurrent();
+    StartHIDManager();
+    dispatch_semaphore_signal((dispatch_semaphore_t)ready);
+    
+    CFRunLoopRun();
+    
+    TUCLogInfo(HID, "HID thread stopped");
+    return NULL;
+}
+
+
+
+static void Handle_StopHIDThread(CFRunLoopTimerRef timer, void *info) {
+    StopHIDManager();
+    CFRunLoopStop(CFRunLoopGetCurrent());
+}
+
+
+
+void OpenHIDManager(void *delegate, dispatch_queue_t gestureQueue) {
+    gTouchManager = delegate;
+    TUCLogConfigureFromEnvironment();
+    
+    gGestureQueue = gestureQueue;
+    dispatch_retain(gGestureQueue);
+    HIDFrameRingInit(&gFrameRing);
+    atomic_store(&gIsDrainScheduled, false);
+    gFrameRingSpace = dispatch_semaphore_create(0);
+    atomic_store(&gIsWaitingForSpace, false);
+    
+#if HID_USE_INPUT_THREAD
+    dispatch_semaphore_t ready = dispatch_semaphore_create(0);
+    pthread_create(&gHIDThread, NULL, HIDThreadMain, ready);
+    dispatch_semaphore_wait(ready, DISPATCH_TIME_FOREVER);
+    dispatch_release(ready);
+#else
+    gRunLoopRef = CFRunLoopGetMain();
+    StartHIDManager();
+#endif
     
     // USB Direct Access is disabled - HID works directly
     // Archive: USBDirectAccessor wurde in _Archive/unused_code verschoben
@@ -1310,8 +1918,23 @@ void OpenHIDManager(void *delegate) {
 
 
 void CloseHIDManager(void) {
-    IOHIDManagerUnscheduleFromRunLoop(gHidManager, gRunLoopRef, kCFRunLoopCommonModes);
-    IOHIDManagerClose(gHidManager, kIOHIDOptionsTypeNone);
+#if HID_USE_INPUT_THREAD
+    // the HID objects belong to the HID thread, it tears them down itself
+    CFRunLoopTimerRef stopTimer = CFRunLoopTimerCreate(kCFAllocatorDefault, 0, 0, 0, 0, Handle_StopHIDThread, NULL);
+    CFRunLoopAddTimer(gRunLoopRef, stopTimer, kCFRunLoopCommonModes);
+    CFRunLoopWakeUp(gRunLoopRef);
+    pthread_join(gHIDThread, NULL);
+    CFRelease(stopTimer);
+#else
+    StopHIDManager();
+#endif
+    
+    // process the remaining frames, the device contexts are released with them
+    dispatch_sync_f(gGestureQueue, NULL, DrainFrameRing);
+    dispatch_release(gGestureQueue);
+    gGestureQueue = NULL;
+    dispatch_release(gFrameRingSpace);
+    gFrameRingSpace = NULL;
     
     // Clean up USB Direct Access if it was initialized
     if (gUSBDirectAccessHandle) {
@@ -1319,17 +1942,34 @@ void CloseHIDManager(void) {
         gUSBDirectAccessHandle = NULL;
     }
     
-    // Clean up touch lifecycle tracking sets
-    if (gActiveTouchIDsThisCycle != NULL) {
-        CFRelease(gActiveTouchIDsThisCycle);
-        gActiveTouchIDsThisCycle = NULL;
-    }
-    if (gActiveTouchIDsLastCycle != NULL) {
-        CFRelease(gActiveTouchIDsLastCycle);
-        gActiveTouchIDsLastCycle = NULL;
-    }
+    TUCLogFlush();
 }
 
+#pragma mark - Drop Policy & Statistics
+
+void HIDInterpreterSetDropPolicy(HIDDropPolicy policy) {
+    atomic_store(&gDropPolicy, policy);
+}
+
+
+HIDDropPolicy HIDInterpreterGetDropPolicy(void) {
+    return (HIDDropPolicy)atomic_load(&gDropPolicy);
+}
+
+
+void HIDInterpreterGetStatistics(HIDInputStatistics *statistics) {
+    statistics->queueDepth               = atomic_load_explicit(&gTotalQueueDepth, memory_order_relaxed);
+    statistics->numQueueOverflows        = atomic_load_explicit(&gNumQueueOverflows, memory_order_relaxed);
+    statistics->numStaleReports          = atomic_load_explicit(&gNumStaleReports, memory_order_relaxed);
+    statistics->numDroppedFrames         = atomic_load_explicit(&gNumDroppedFrames, memory_order_relaxed);
+    statistics->numStalls                = atomic_load_explicit(&gNumStalls, memory_order_relaxed);
+    statistics->numSuppressedMoves       = atomic_load_explicit(&gNumSuppressedMoves, memory_order_relaxed);
+    statistics->numRejectedOversized     = atomic_load_explicit(&gNumRejectedOversized, memory_order_relaxed);
+    statistics->numRejectedLowConfidence = atomic_load_explicit(&gNumRejectedLowConfidence, memory_order_relaxed);
+}
+
+
+
 #pragma mark - USB Direct Access Implementation (Fallback for non-HID devices)
 
 // Simplified USB Device Finder
@@ -1406,7 +2046,7 @@ USBDirectAccessHandle* USBDirectAccessor_Create(uint16_t vendorID, uint16_t prod
     // Start background thread to read from device
     int rc = pthread_create(&handle->readThread, NULL, USBInterruptReadThread, (void *)handle);
     if (rc != 0) {
-        DebugLog("USBDirectAccessor: Failed to create read thread: %d", rc);
+        TUCLogError(HID, "USBDirectAccessor: Failed to create read thread: %d", rc);
         free(handle);
         IOObjectRelease(usbDevice);
         return NULL;
@@ -1469,7 +2109,7 @@ int USBDirectAccessor_ReadInterrupt(USBDirectAccessHandle *handle,
         return -1;
     }
     
-    DebugLog("USBDirectAccessor_ReadInterrupt: Attempting to read up to %u bytes", bufferSize);
+    TUCLogDebug(HID, "USBDirectAccessor_ReadInterrupt: Attempting to read up to %u bytes", bufferSize);
     
     // For simplicity, return 0 bytes for now
     // Actual implementation would use libusb or IOUSBHostInterface
@@ -1519,7 +2159,7 @@ void USBDirectAccessor_Release(USBDirectAccessHandle *handle) {
     }
     
     free(handle);
-    DebugLog("USBDirectAccessor: Handle released");
+    TUCLogInfo(HID, "USBDirectAccessor: Handle released");
 }
 
 // ARCHIVED: USB Direct Access ist nicht mehr nötig - HID funktioniert direkt
@@ -1527,29 +2167,31 @@ void USBDirectAccessor_Release(USBDirectAccessHandle *handle) {
 /*
 void TryUSBDirectAccess(void) {
     // Check if HID manager found the device
-    if (gIsELANDevice) {
-        DebugLog("HIDInterpreter: ELAN device already found via HID Manager");
-        return;
+    for (int i = 0; i < MAX_DEVICES; i++) {
+        if (gDevices[i] && gDevices[i]->isELAN) {
+            TUCLogInfo(HID, "HIDInterpreter: ELAN device already found via HID Manager");
+            return;
+        }
     }
     
-    DebugLog("HIDInterpreter: HID Manager failed, attempting USB Direct Access for 0x%04x:0x%04x",
-           kELANVendorID, kELANProductID);
+    TUCLogInfo(HID, "HIDInterpreter: HID Manager failed, attempting USB Direct Access for 0x%04x:0x%04x",
+               kELANVendorID, kELANProductID);
     
     // Check if device is available
     if (!USBDirectAccessor_IsELANDeviceAvailable(kELANVendorID, kELANProductID)) {
-        DebugLog("HIDInterpreter: ELAN device (0x%04x:0x%04x) not available",
-               kELANVendorID, kELANProductID);
+        TUCLogInfo(HID, "HIDInterpreter: ELAN device (0x%04x:0x%04x) not available",
+                   kELANVendorID, kELANProductID);
         return;
     }
     
     // Try to create USB Direct Access
     gUSBDirectAccessHandle = USBDirectAccessor_Create(kELANVendorID, kELANProductID);
     if (!gUSBDirectAccessHandle) {
-        DebugLog("HIDInterpreter: Failed to create USB Direct Access handle");
+        TUCLogError(HID, "HIDInterpreter: Failed to create USB Direct Access handle");
         return;
     }
     
-    DebugLog("HIDInterpreter: USB Direct Access initialized successfully");
+    TUCLogInfo(HID, "HIDInterpreter: USB Direct Access initialized successfully");
     
     // TODO: Start reading from USB device in separate thread
     // For now, just log that we have access
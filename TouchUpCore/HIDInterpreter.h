@@ -9,9 +9,38 @@
 #define HIDInterpreter_h
 
 #include <stdio.h>
+#include <stdint.h>
+#include <dispatch/dispatch.h>
 
-void OpenHIDManager(void *delegate);
+typedef enum {
+    HIDDropPolicyPreserveAll = 0,   // every frame reaches the gesture stage, the HID thread waits if it falls behind
+    HIDDropPolicyDropOldest,        // stale reports and frames superseded before the gesture stage got to them are skipped, the HID thread never waits for frames
+} HIDDropPolicy;
+
+typedef struct {
+    uint32_t queueDepth;            // values the IOHIDQueues of all queue path devices hold together, 0 if no device uses a queue
+    uint64_t numQueueOverflows;     // queue callbacks that drained a full queue, values arriving meanwhile were probably lost
+    uint64_t numStaleReports;       // reports older than 100 ms when they were processed
+    uint64_t numDroppedFrames;      // frames skipped by HIDDropPolicyDropOldest
+    uint64_t numStalls;             // the HID thread slept until the gesture stage made room in the full frame ring
+    uint64_t numSuppressedMoves;    // contact samples the jitter filter reported at the previous position
+    uint64_t numRejectedOversized;  // touches rejected as palms because of their size
+    uint64_t numRejectedLowConfidence;  // touches rejected because the device cleared Touch Valid
+} HIDInputStatistics;
+
+/**
+ Starts the HID thread. Touches are tracked and passed to the `delegate` on the serial `gestureQueue`.
+ */
+void OpenHIDManager(void *delegate, dispatch_queue_t gestureQueue);
 
 void CloseHIDManager(void);
 
+/**
+ The policy and the statistics can be set and read from any thread, also while the HID manager is running.
+ */
+void HIDInterpreterSetDropPolicy(HIDDropPolicy policy);
+HIDDropPolicy HIDInterpreterGetDropPolicy(void);
+
+void HIDInterpreterGetStatistics(HIDInputStatistics *statistics);
+
 #endif /* HIDInterpreter_h */
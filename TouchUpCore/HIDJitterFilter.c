@@ -0,0 +1,91 @@
+//
+//  HIDJitterFilter.c
+//  Touch Up Core
+//
+//  Created by Touch Up contributors on 16.10.26.
+//
+
+#include "HIDJitterFilter.h"
+
+#include <math.h>
+#include <string.h>
+
+
+// M_PI is not part of strict C11
+static const double kPi = 3.14159265358979323846;
+
+
+void HIDJitterFilterInit(HIDJitterFilter *filter, HIDJitterFilterProfile profile) {
+    memset(filter, 0, sizeof(HIDJitterFilter));
+    filter->profile = profile;
+}
+
+
+void HIDJitterFilterReset(HIDJitterFilter *filter, int32_t contactID) {
+    if (contactID >= 0 && contactID < HID_JITTER_FILTER_MAX_IDS) {
+        filter->contacts[contactID].hasSample = false;
+    }
+}
+
+
+
+/**
+ Weight of a new sample for an exponential low-pass with this cutoff at this sample interval.
+ */
+static float SmoothingFactor(float cutoff, double dt) {
+    double tau = 1.0 / (2.0 * kPi * cutoff);
+    return (float)(1.0 / (1.0 + tau / dt));
+}
+
+
+bool HIDJitterFilterApply(HIDJitterFilter *filter, int32_t contactID, double time, float *x, float *y) {
+    if (contactID < 0 || contactID >= HID_JITTER_FILTER_MAX_IDS) {
+        return false;
+    }
+
+    HIDJitterFilterContact *contact = &filter->contacts[contactID];
+    const HIDJitterFilterProfile *profile = &filter->profile;
+    double dt = time - contact->time;
+
+    filter->numSamples++;
+
+    if (!contact->hasSample || dt <= 0) {
+        // first sample, or a sample without a usable interval: pass it and start over from here
+        *contact = (HIDJitterFilterContact){
+            .hasSample = true,
+            .time = time,
+            .x = *x,
+            .y = *y,
+            .reportedX = *x,
+            .reportedY = *y,
+        };
+        return false;
+    }
+
+    // speed of the raw sample against the filtered position, smoothed with its own cutoff
+    float dx = *x - contact->x;
+    float dy = *y - contact->y;
+    float rawSpeed = sqrtf(dx * dx + dy * dy) / (float)dt;
+    contact->speed += SmoothingFactor(profile->derivativeCutoff, dt) * (rawSpeed - contact->speed);
+
+    // the faster the finger, the higher the cutoff, the less lag
+    float alpha = SmoothingFactor(profile->minCutoff + profile->beta * contact->speed, dt);
+    contact->x += alpha * dx;
+    contact->y += alpha * dy;
+    contact->time = time;
+
+    float rx = contact->x - contact->reportedX;
+    float ry = contact->y - contact->reportedY;
+    bool isHeld = rx * rx + ry * ry < profile->deadband * profile->deadband;
+
+    if (!isHeld) {
+        contact->reportedX = contact->x;
+        contact->reportedY = contact->y;
+    } else {
+        filter->numHeld++;
+    }
+
+    *x = contact->reportedX;
+    *y = contact->reportedY;
+    return isHeld;
+}
@@ -0,0 +1,73 @@
+//
+//  HIDJitterFilter.h
+//  Touch Up Core
+//
+//  Created by Touch Up contributors on 16.10.26.
+//
+
+#ifndef HIDJitterFilter_h
+#define HIDJitterFilter_h
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ Adaptive low-pass filter for the contact positions (One Euro filter).
+
+ A resting finger on our panels jitters by a few logical units. Filtered with a low cutoff frequency, that jitter disappears, but
+ a fast swipe would lag behind. The One Euro filter therefore raises the cutoff with the speed of the finger: slow movements are
+ smoothed, fast ones pass almost unchanged. What remains of the jitter is caught by a small deadband: as long as the filtered
+ position stays within it, the previous position is reported again, so the touch manager sees a stationary touch and posts no event.
+
+ Positions are normalized (0...1), times in seconds. Like the decoder, this file does not depend on IOKit or CoreFoundation.
+ */
+
+
+#define HID_JITTER_FILTER_MAX_IDS 100   // kContactIDsPerDevice, contacts with larger IDs are passed unfiltered
+
+
+typedef struct {
+    float minCutoff;            // Hz, cutoff of a resting finger: lower = less jitter
+    float beta;                 // Hz per (screen per second), raises the cutoff with the speed: higher = less lag
+    float derivativeCutoff;     // Hz, smoothes the speed estimate
+    float deadband;             // normalized, filtered changes below are not reported
+} HIDJitterFilterProfile;
+
+// generic tuning for panels without a profile of their own, smoothes less than the ELAN profile
+#define kHIDJitterFilterDefaultProfile ((HIDJitterFilterProfile){ \
+    .minCutoff = 1.0f, .beta = 10.0f, .derivativeCutoff = 1.0f, .deadband = 0.0005f })
+
+
+typedef struct {
+    bool   hasSample;
+    double time;
+    float  x, y;                // filtered
+    float  speed;               // filtered, screen per second
+    float  reportedX, reportedY;
+} HIDJitterFilterContact;
+
+
+typedef struct {
+    HIDJitterFilterProfile profile;
+    HIDJitterFilterContact contacts[HID_JITTER_FILTER_MAX_IDS];
+
+    // statistics
+    uint64_t numSamples;
+    uint64_t numHeld;           // samples reported at the previous position, each one a move event less
+} HIDJitterFilter;
+
+
+
+void HIDJitterFilterInit(HIDJitterFilter *filter, HIDJitterFilterProfile profile);
+
+/**
+ Forgets a contact, call it when a touch starts. Its first sample passes unfiltered.
+ */
+void HIDJitterFilterReset(HIDJitterFilter *filter, int32_t contactID);
+
+/**
+ Filters one sample in place. Returns true if the position was held at the previously reported one.
+ */
+bool HIDJitterFilterApply(HIDJitterFilter *filter, int32_t contactID, double time, float *x, float *y);
+
+#endif /* HIDJitterFilter_h */
@@ -0,0 +1,743 @@
+//
+//  HIDReportDecoder.c
+//  Touch Up Core
+//
+//  Created by Touch Up contributors on 16.10.26.
+//
+
+#include "HIDReportDecoder.h"
+
+#include <string.h>
+
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#include <arm_neon.h>
+#endif
+
+
+#pragma mark - Usages
+
+#define kPageGenericDesktop     0x01
+#define kPageDigitizer          0x0D
+
+#define kUsageGD_X              0x30
+#define kUsageGD_Y              0x31
+
+#define kUsageDig_Touch         0x02
+#define kUsageDig_TouchScreen   0x04
+#define kUsageDig_TouchPad      0x05
+#define kUsageDig_Finger        0x22
+#define kUsageDig_TipSwitch     0x42
+#define kUsageDig_TouchValid    0x47
+#define kUsageDig_Width         0x48
+#define kUsageDig_Height        0x49
+#define kUsageDig_ContactID     0x51
+#define kUsageDig_ContactCount  0x54
+#define kUsageDig_ScanTime      0x56
+#define kUsageDig_Azimuth       0x3F
+
+#define USAGE(page, id) (((uint32_t)(page) << 16) | (uint32_t)(id))
+
+
+static int TouchFieldForUsage(uint32_t usage) {
+    switch (usage) {
+        case USAGE(kPageGenericDesktop, kUsageGD_X):        return HIDTouchFieldX;
+        case USAGE(kPageGenericDesktop, kUsageGD_Y):        return HIDTouchFieldY;
+        case USAGE(kPageDigitizer, kUsageDig_TipSwitch):    return HIDTouchFieldTip;
+        case USAGE(kPageDigitizer, kUsageDig_TouchValid):   return HIDTouchFieldValid;
+        case USAGE(kPageDigitizer, kUsageDig_ContactID):    return HIDTouchFieldContactID;
+        case USAGE(kPageDigitizer, kUsageDig_Width):        return HIDTouchFieldWidth;
+        case USAGE(kPageDigitizer, kUsageDig_Height):       return HIDTouchFieldHeight;
+        case USAGE(kPageDigitizer, kUsageDig_Azimuth):      return HIDTouchFieldAzimuth;
+        default:                                            return -1;
+    }
+}
+
+
+static bool IsTouchApplicationUsage(uint32_t usage) {
+    return usage == USAGE(kPageDigitizer, kUsageDig_TouchScreen)
+        || usage == USAGE(kPageDigitizer, kUsageDig_Touch)
+        || usage == USAGE(kPageDigitizer, kUsageDig_TouchPad);
+}
+
+
+
+#pragma mark - Parser State
+
+#define MAX_LOCAL_USAGES    32
+#define MAX_GLOBAL_STACK     4
+#define MAX_COLLECTION_DEPTH 8
+
+typedef struct {
+    uint32_t usagePage;
+    int32_t  logicalMin;
+    uint32_t logicalMaxRaw;
+    uint8_t  logicalMaxSize;
+    uint32_t reportSize;
+    uint32_t reportCount;
+    uint8_t  reportID;
+} GlobalState;
+
+
+typedef struct {
+    uint32_t usages[MAX_LOCAL_USAGES];
+    uint32_t numUsages;
+    uint32_t usageMin;
+    uint32_t usageMax;
+    bool     hasUsageRange;
+} LocalState;
+
+
+typedef struct {
+    uint8_t  type;
+    uint32_t usage;
+} CollectionEntry;
+
+
+typedef struct {
+    HIDReportDecoder *decoder;
+
+    GlobalState global;
+    GlobalState globalStack[MAX_GLOBAL_STACK];
+    int globalStackDepth;
+
+    LocalState local;
+
+    CollectionEntry collections[MAX_COLLECTION_DEPTH];
+    int collectionDepth;
+
+    int applicationDepth;           // depth of the enclosing touch application collection, -1 if none
+    int touchCollectionDepth;       // depth of the open finger collection, -1 if none
+    uint8_t touchCollectionReportID;
+    HIDTouchCollectionLayout touchCollection;
+    bool touchCollectionHasFields;
+
+    uint32_t inputBits[256];        // running bit position per report ID
+} ParserState;
+
+
+
+static HIDTouchReportLayout *LayoutForReportID(ParserState *state, uint8_t reportID) {
+    HIDReportDecoder *decoder = state->decoder;
+
+    for (uint8_t i = 0; i < decoder->numReports; i++) {
+        if (decoder->reports[i].reportID == reportID) {
+            return &decoder->reports[i];
+        }
+    }
+
+    if (decoder->numReports >= HID_DECODER_MAX_REPORTS) {
+        return NULL;
+    }
+
+    HIDTouchReportLayout *layout = &decoder->reports[decoder->numReports++];
+    memset(layout, 0, sizeof(*layout));
+    layout->reportID = reportID;
+    return layout;
+}
+
+
+static uint32_t UsageForIndex(const LocalState *local, uint32_t index) {
+    if (local->hasUsageRange) {
+        uint32_t usage = local->usageMin + index;
+        return usage > local->usageMax ? local->usageMax : usage;
+    }
+    if (local->numUsages == 0) {
+        return 0;
+    }
+    // the last usage applies to all remaining values
+    return local->usages[index < local->numUsages ? index : local->numUsages - 1];
+}
+
+
+static void MakeField(HIDReportField *field, const GlobalState *global, uint32_t bitOffset) {
+    int32_t logicalMin = global->logicalMin;
+    int32_t logicalMax;
+
+    // a negative minimum means the maximum is signed as well, otherwise it is read as unsigned
+    if (logicalMin < 0 && global->logicalMaxSize > 0 && global->logicalMaxSize < 4) {
+        uint32_t signBit = 1u << (global->logicalMaxSize * 8 - 1);
+        logicalMax = (int32_t)((global->logicalMaxRaw ^ signBit) - signBit);
+    } else {
+        logicalMax = (int32_t)global->logicalMaxRaw;
+    }
+
+    field->bitOffset  = bitOffset;
+    field->bitSize    = (uint8_t)(global->reportSize > 32 ? 32 : global->reportSize);
+    field->isSigned   = logicalMin < 0;
+    field->logicalMin = logicalMin;
+    field->logicalMax = logicalMax;
+
+    float range = (float)logicalMax - (float)logicalMin;
+    field->scale  = range != 0 ? 1.0f / range : 0;
+    field->offset = -(float)logicalMin * field->scale;
+}
+
+
+static void HandleInputItem(ParserState *state, uint32_t flags) {
+    GlobalState *global = &state->global;
+    uint32_t *bitPosition = &state->inputBits[global->reportID];
+
+    bool isConstant = flags & 0x01;
+    bool isVariable = flags & 0x02;
+
+    for (uint32_t i = 0; i < global->reportCount; i++) {
+        uint32_t bitOffset = *bitPosition;
+        *bitPosition += global->reportSize;
+
+        if (isConstant || !isVariable || state->applicationDepth < 0) {
+            continue;
+        }
+
+        uint32_t usage = UsageForIndex(&state->local, i);
+
+        if (state->touchCollectionDepth >= 0) {
+            int fieldIndex = TouchFieldForUsage(usage);
+            if (fieldIndex < 0) {
+                continue;
+            }
+            HIDReportField *field = &state->touchCollection.fields[fieldIndex];
+            if (field->bitSize == 0) {
+                MakeField(field, global, bitOffset);
+                state->touchCollectionReportID = global->reportID;
+                state->touchCollectionHasFields = true;
+            }
+
+        } else if (usage == USAGE(kPageDigitizer, kUsageDig_ContactCount)
+                   || usage == USAGE(kPageDigitizer, kUsageDig_ScanTime)) {
+            HIDTouchReportLayout *layout = LayoutForReportID(state, global->reportID);
+            if (!layout) {
+                continue;
+            }
+            HIDReportField *field = usage == USAGE(kPageDigitizer, kUsageDig_ContactCount) ? &layout->contactCount : &layout->scanTime;
+            if (field->bitSize == 0) {
+                MakeField(field, global, bitOffset);
+            }
+        }
+    }
+}
+
+
+static void OpenCollection(ParserState *state, uint8_t type) {
+    uint32_t usage = UsageForIndex(&state->local, 0);
+
+    if (state->collectionDepth < MAX_COLLECTION_DEPTH) {
+        state->collections[state->collectionDepth].type  = type;
+        state->collections[state->collectionDepth].usage = usage;
+    }
+    int depth = state->collectionDepth++;
+
+    // 0x01 application
+    if (type == 0x01 && state->applicationDepth < 0 && IsTouchApplicationUsage(usage)) {
+        state->applicationDepth = depth;
+        return;
+    }
+
+    // 0x02 logical, 0x00 physical: the per finger collection of the touch application
+    if (state->applicationDepth >= 0 && state->touchCollectionDepth < 0
+        && (type == 0x02 || (type == 0x00 && usage == USAGE(kPageDigitizer, kUsageDig_Finger)))) {
+        state->touchCollectionDepth = depth;
+        state->touchCollectionHasFields = false;
+        memset(&state->touchCollection, 0, sizeof(state->touchCollection));
+    }
+}
+
+
+static void CloseCollection(ParserState *state) {
+    if (state->collectionDepth == 0) {
+        return;
+    }
+    int depth = --state->collectionDepth;
+
+    if (depth == state->touchCollectionDepth) {
+        state->touchCollectionDepth = -1;
+
+        // collections without position are e.g. vendor specific and not of interest
+        bool hasPosition = state->touchCollection.fields[HIDTouchFieldX].bitSize > 0
+                        && state->touchCollection.fields[HIDTouchFieldY].bitSize > 0;
+
+        if (state->touchCollectionHasFields && hasPosition) {
+            HIDTouchReportLayout *layout = LayoutForReportID(state, state->touchCollectionReportID);
+            if (layout && layout->numCollections < HID_DECODER_MAX_COLLECTIONS) {
+                layout->collections[layout->numCollections++] = state->touchCollection;
+            }
+        }
+
+    } else if (depth == state->applicationDepth) {
+        state->applicationDepth = -1;
+    }
+}
+
+
+static void OffsetField(HIDReportField *field, uint32_t bits) {
+    if (field->bitSize > 0) {
+        field->bitOffset += bits;
+    }
+}
+
+
+
+/**
+ Checks whether a field repeats at a fixed byte stride with identical size and range in all collections.
+ */
+static void PrepareBatchField(HIDTouchReportLayout *layout, int f) {
+    HIDBatchField *batch = &layout->batchFields[f];
+    const HIDReportField *first = &layout->collections[0].fields[f];
+
+    memset(batch, 0, sizeof(*batch));
+
+    if (first->bitSize == 0 || first->bitSize > 25) {
+        return;
+    }
+
+    uint32_t strideBits = 0;
+    if (layout->numCollections > 1) {
+        const HIDReportField *second = &layout->collections[1].fields[f];
+        if (second->bitOffset <= first->bitOffset) {
+            return;
+        }
+        strideBits = second->bitOffset - first->bitOffset;
+    }
+
+    if (strideBits % 8 != 0) {
+        return;
+    }
+
+    for (uint8_t c = 1; c < layout->numCollections; c++) {
+        const HIDReportField *field = &layout->collections[c].fields[f];
+        if (field->bitOffset != first->bitOffset + c * strideBits
+            || field->bitSize != first->bitSize
+            || field->isSigned != first->isSigned
+            || field->logicalMin != first->logicalMin
+            || field->logicalMax != first->logicalMax) {
+            return;
+        }
+    }
+
+    batch->isUniform   = true;
+    batch->firstByte   = first->bitOffset >> 3;
+    batch->shift       = first->bitOffset & 7;
+    batch->strideBytes = strideBits / 8;
+    batch->bitSize     = first->bitSize;
+    batch->isSigned    = first->isSigned;
+    batch->scale       = first->scale;
+    batch->offset      = first->offset;
+}
+
+
+
+#pragma mark - Compile
+
+bool HIDReportDecoderCompile(HIDReportDecoder *decoder, const uint8_t *descriptor, size_t length) {
+    memset(decoder, 0, sizeof(*decoder));
+
+    if (!descriptor || length == 0) {
+        return false;
+    }
+
+    ParserState state;
+    memset(&state, 0, sizeof(state));
+    state.decoder = decoder;
+    state.applicationDepth = -1;
+    state.touchCollectionDepth = -1;
+
+    size_t pos = 0;
+    while (pos < length) {
+        uint8_t prefix = descriptor[pos++];
+
+        // long items are reserved and carry no information for us
+        if (prefix == 0xFE) {
+            if (pos + 2 > length) {
+                return false;
+            }
+            pos += 2 + descriptor[pos];
+            continue;
+        }
+
+        uint8_t size = prefix & 0x03;
+        if (size == 3) {
+            size = 4;
+        }
+        uint8_t type = (prefix >> 2) & 0x03;
+        uint8_t tag  = (prefix >> 4) & 0x0F;
+
+        if (pos + size > length) {
+            return false;
+        }
+
+        uint32_t data = 0;
+        for (uint8_t i = 0; i < size; i++) {
+            data |= (uint32_t)descriptor[pos + i] << (8 * i);
+        }
+        int32_t signedData = (int32_t)data;
+        if (size == 1) {
+            signedData = (int8_t)data;
+        } else if (size == 2) {
+            signedData = (int16_t)data;
+        }
+        pos += size;
+
+        if (type == 0) {
+            // main items
+            switch (tag) {
+                case 0x8: // input
+                    HandleInputItem(&state, data);
+                    break;
+                case 0xA: // collection
+                    OpenCollection(&state, (uint8_t)data);
+                    break;
+                case 0xC: // end collection
+                    CloseCollection(&state);
+                    break;
+                default:  // output, feature
+                    break;
+            }
+            memset(&state.local, 0, sizeof(state.local));
+
+        } else if (type == 1) {
+            // global items
+            switch (tag) {
+                case 0x0: state.global.usagePage = data; break;
+                case 0x1: state.global.logicalMin = signedData; break;
+                case 0x2:
+                    state.global.logicalMaxRaw = data;
+                    state.global.logicalMaxSize = size;
+                    break;
+                case 0x7: state.global.reportSize = data; break;
+                case 0x8:
+                    state.global.reportID = (uint8_t)data;
+                    decoder->usesReportIDs = true;
+                    break;
+                case 0x9: state.global.reportCount = data; break;
+                case 0xA: // push
+                    if (state.globalStackDepth < MAX_GLOBAL_STACK) {
+                        state.globalStack[state.globalStackDepth++] = state.global;
+                    }
+                    break;
+                case 0xB: // pop
+                    if (state.globalStackDepth > 0) {
+                        state.global = state.globalStack[--state.globalStackDepth];
+                    }
+                    break;
+                default:  // physical range, unit, exponent
+                    break;
+            }
+
+        } else if (type == 2) {
+            // local items, usages without page inherit the current usage page
+            uint32_t usage = size == 4 ? data : USAGE(state.global.usagePage, data);
+            switch (tag) {
+                case 0x0:
+                    if (state.local.numUsages < MAX_LOCAL_USAGES) {
+                        state.local.usages[state.local.numUsages++] = usage;
+                    }
+                    break;
+                case 0x1:
+                    state.local.usageMin = usage;
+                    state.local.hasUsageRange = true;
+                    break;
+                case 0x2:
+                    state.local.usageMax = usage;
+                    break;
+                default:
+                    break;
+            }
+        }
+    }
+
+    // finalize: drop reports without touch collections, account for the report ID byte
+    uint8_t kept = 0;
+    for (uint8_t i = 0; i < decoder->numReports; i++) {
+        HIDTouchReportLayout *layout = &decoder->reports[i];
+        if (layout->numCollections == 0) {
+            continue;
+        }
+
+        uint32_t idBits = decoder->usesReportIDs ? 8 : 0;
+        layout->byteLength = (state.inputBits[layout->reportID] + 7) / 8 + idBits / 8;
+
+        OffsetField(&layout->contactCount, idBits);
+        OffsetField(&layout->scanTime, idBits);
+        for (uint8_t c = 0; c < layout->numCollections; c++) {
+            for (int f = 0; f < HIDTouchFieldCount; f++) {
+                OffsetField(&layout->collections[c].fields[f], idBits);
+            }
+        }
+
+        for (int f = 0; f < HID_BATCH_FIELD_COUNT; f++) {
+            PrepareBatchField(layout, f);
+        }
+
+        if (kept != i) {
+            decoder->reports[kept] = *layout;
+        }
+        kept++;
+    }
+    decoder->numReports = kept;
+
+    return kept > 0;
+}
+
+
+
+#pragma mark - Decode
+
+int32_t HIDReportFieldRead(const HIDReportField *field, const uint8_t *report, size_t length) {
+    uint32_t byteIndex = field->bitOffset >> 3;
+    uint32_t shift     = field->bitOffset & 7;
+    uint32_t numBytes  = (shift + field->bitSize + 7) >> 3;
+
+    uint64_t raw = 0;
+    for (uint32_t i = 0; i < numBytes && byteIndex + i < length; i++) {
+        raw |= (uint64_t)report[byteIndex + i] << (8 * i);
+    }
+    raw >>= shift;
+
+    if (field->bitSize >= 32) {
+        return (int32_t)(uint32_t)raw;
+    }
+
+    uint32_t value = (uint32_t)raw & ((1u << field->bitSize) - 1);
+    if (field->isSigned && (value & (1u << (field->bitSize - 1)))) {
+        value |= ~((1u << field->bitSize) - 1);
+    }
+    return (int32_t)value;
+}
+
+
+static inline int32_t ReadOptional(const HIDReportField *field, const uint8_t *report, size_t length, int32_t fallback) {
+    return field->bitSize ? HIDReportFieldRead(field, report, length) : fallback;
+}
+
+
+const HIDTouchReportLayout *HIDReportDecoderLayoutForReport(const HIDReportDecoder *decoder, const uint8_t *report, size_t length) {
+    if (!report || length == 0) {
+        return NULL;
+    }
+
+    if (!decoder->usesReportIDs) {
+        return decoder->numReports > 0 ? &decoder->reports[0] : NULL;
+    }
+
+    for (uint8_t i = 0; i < decoder->numReports; i++) {
+        if (decoder->reports[i].reportID == report[0]) {
+            return &decoder->reports[i];
+        }
+    }
+    return NULL;
+}
+
+
+#pragma mark - Batch Decode
+
+/**
+ Little endian 32 bit load that reads zeros beyond the end of the buffer.
+ */
+static inline uint32_t Load32(const uint8_t *report, size_t length, uint32_t byteIndex) {
+    if ((size_t)byteIndex + 4 <= length) {
+        uint32_t value;
+        memcpy(&value, report + byteIndex, 4);
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+        value = __builtin_bswap32(value);
+#endif
+        return value;
+    }
+
+    uint32_t value = 0;
+    for (uint32_t i = 0; i < 4 && byteIndex + i < length; i++) {
+        value |= (uint32_t)report[byteIndex + i] << (8 * i);
+    }
+    return value;
+}
+
+
+/**
+ Loads the 32 bit words containing the field for 4 consecutive collections.
+ The byte offsets differ per collection, so this part stays scalar (SSE2 and NEON have no gather).
+ Lanes beyond `count` are not loaded, they would mostly lie past the end of the report and take the slow path of Load32.
+ */
+static inline void LoadLanes(const HIDBatchField *field, const uint8_t *report, size_t length, uint32_t collection, uint32_t count,
+                             uint32_t lanes[4]) {
+    uint32_t byteIndex = field->firstByte + collection * field->strideBytes;
+    for (uint32_t k = 0; k < 4; k++) {
+        lanes[k] = collection + k < count ? Load32(report, length, byteIndex + k * field->strideBytes) : 0;
+    }
+}
+
+
+/**
+ Extracts a uniform field as integers for `count` collections, 4 per iteration.
+ The output must have room for `count` rounded up to a multiple of 4.
+ */
+static void ExtractIntegers(const HIDBatchField *field, const uint8_t *report, size_t length, uint32_t count, int32_t *out) {
+    uint32_t lanes[4];
+    uint32_t signShift = 32 - field->bitSize;
+    uint32_t mask = (1u << field->bitSize) - 1;
+
+    for (uint32_t i = 0; i < count; i += 4) {
+        LoadLanes(field, report, length, i, count, lanes);
+
+#if defined(__SSE2__)
+        __m128i v = _mm_loadu_si128((const __m128i *)lanes);
+        v = _mm_srl_epi32(v, _mm_cvtsi32_si128(field->shift));
+        if (field->isSigned) {
+            v = _mm_sra_epi32(_mm_sll_epi32(v, _mm_cvtsi32_si128(signShift)), _mm_cvtsi32_si128(signShift));
+        } else {
+            v = _mm_and_si128(v, _mm_set1_epi32((int32_t)mask));
+        }
+        _mm_storeu_si128((__m128i *)&out[i], v);
+
+#elif defined(__ARM_NEON)
+        uint32x4_t v = vshlq_u32(vld1q_u32(lanes), vdupq_n_s32(-(int32_t)field->shift));
+        int32x4_t result;
+        if (field->isSigned) {
+            result = vshlq_s32(vreinterpretq_s32_u32(vshlq_u32(v, vdupq_n_s32((int32_t)signShift))), vdupq_n_s32(-(int32_t)signShift));
+        } else {
+            result = vreinterpretq_s32_u32(vandq_u32(v, vdupq_n_u32(mask)));
+        }
+        vst1q_s32(&out[i], result);
+
+#else
+        for (int k = 0; k < 4; k++) {
+            uint32_t value = lanes[k] >> field->shift;
+            out[i + k] = field->isSigned ? ((int32_t)(value << signShift) >> signShift) : (int32_t)(value & mask);
+        }
+#endif
+    }
+}
+
+
+/**
+ Extracts a uniform field and normalizes it in the same pass: raw * scale + offset.
+ */
+static void ExtractNormalized(const HIDBatchField *field, const uint8_t *report, size_t length, uint32_t count, float *out) {
+#if defined(__SSE2__) || defined(__ARM_NEON)
+    uint32_t lanes[4];
+    uint32_t signShift = 32 - field->bitSize;
+    uint32_t mask = (1u << field->bitSize) - 1;
+
+    for (uint32_t i = 0; i < count; i += 4) {
+        LoadLanes(field, report, length, i, count, lanes);
+
+#if defined(__SSE2__)
+        __m128i v = _mm_loadu_si128((const __m128i *)lanes);
+        v = _mm_srl_epi32(v, _mm_cvtsi32_si128(field->shift));
+        if (field->isSigned) {
+            v = _mm_sra_epi32(_mm_sll_epi32(v, _mm_cvtsi32_si128(signShift)), _mm_cvtsi32_si128(signShift));
+        } else {
+            v = _mm_and_si128(v, _mm_set1_epi32((int32_t)mask));
+        }
+        __m128 f = _mm_add_ps(_mm_mul_ps(_mm_cvtepi32_ps(v), _mm_set1_ps(field->scale)), _mm_set1_ps(field->offset));
+        _mm_storeu_ps(&out[i], f);
+#else
+        uint32x4_t v = vshlq_u32(vld1q_u32(lanes), vdupq_n_s32(-(int32_t)field->shift));
+        int32x4_t value;
+        if (field->isSigned) {
+            value = vshlq_s32(vreinterpretq_s32_u32(vshlq_u32(v, vdupq_n_s32((int32_t)signShift))), vdupq_n_s32(-(int32_t)signShift));
+        } else {
+            value = vreinterpretq_s32_u32(vandq_u32(v, vdupq_n_u32(mask)));
+        }
+        float32x4_t f = vmlaq_f32(vdupq_n_f32(field->offset), vcvtq_f32_s32(value), vdupq_n_f32(field->scale));
+        vst1q_f32(&out[i], f);
+#endif
+    }
+#else
+    int32_t values[HID_DECODER_MAX_COLLECTIONS];
+    ExtractIntegers(field, report, length, count, values);
+    for (uint32_t i = 0; i < count; i++) {
+        out[i] = (float)values[i] * field->scale + field->offset;
+    }
+#endif
+}
+
+
+// below this many collections a group of 4 lanes is mostly empty and reading field by field is faster (see Tools/hid-decoder-bench.c)
+#define kMinLaneCollections 4
+
+
+void HIDReportDecoderDecodeBatch(const HIDTouchReportLayout *layout, const uint8_t *report, size_t length, HIDContactBatch *batch) {
+    uint32_t count = layout->numCollections;
+    batch->count = layout->numCollections;
+
+    const HIDBatchField *fields = layout->batchFields;
+    int32_t values[HID_DECODER_MAX_COLLECTIONS];
+    bool usesLanes = count >= kMinLaneCollections;
+
+    // X and Y: collections without position read as -1 like in the queue path
+    float *positions[2] = { batch->x, batch->y };
+    for (int f = HIDTouchFieldX; f <= HIDTouchFieldY; f++) {
+        if (usesLanes && fields[f].isUniform) {
+            ExtractNormalized(&fields[f], report, length, count, positions[f]);
+        } else {
+            for (uint32_t i = 0; i < count; i++) {
+                const HIDReportField *field = &layout->collections[i].fields[f];
+                positions[f][i] = field->bitSize ? (float)HIDReportFieldRead(field, report, length) * field->scale + field->offset : -1;
+            }
+        }
+    }
+
+    if (usesLanes && fields[HIDTouchFieldContactID].isUniform) {
+        ExtractIntegers(&fields[HIDTouchFieldContactID], report, length, count, batch->contactID);
+    } else {
+        for (uint32_t i = 0; i < count; i++) {
+            batch->contactID[i] = ReadOptional(&layout->collections[i].fields[HIDTouchFieldContactID], report, length, 0);
+        }
+    }
+
+    // tip and valid are single bits, they are narrowed to bytes after extraction
+    uint8_t *flags[2] = { batch->tipSwitch, batch->isValid };
+    for (int f = HIDTouchFieldTip; f <= HIDTouchFieldValid; f++) {
+        uint8_t *out = flags[f - HIDTouchFieldTip];
+        if (usesLanes && fields[f].isUniform) {
+            ExtractIntegers(&fields[f], report, length, count, values);
+            for (uint32_t i = 0; i < count; i++) {
+                out[i] = (uint8_t)values[i];
+            }
+        } else {
+            for (uint32_t i = 0; i < count; i++) {
+                out[i] = (uint8_t)ReadOptional(&layout->collections[i].fields[f], report, length, 0);
+            }
+        }
+    }
+}
+
+
+
+bool HIDReportDecoderDecode(const HIDReportDecoder *decoder, const uint8_t *report, size_t length, HIDDecodedReport *outReport) {
+    const HIDTouchReportLayout *layout = HIDReportDecoderLayoutForReport(decoder, report, length);
+    if (!layout || length < layout->byteLength) {
+        return false;
+    }
+
+    outReport->reportID     = layout->reportID;
+    outReport->contactCount = ReadOptional(&layout->contactCount, report, length, kHIDDecoderValueAbsent);
+    outReport->scanTime     = ReadOptional(&layout->scanTime, report, length, kHIDDecoderValueAbsent);
+    outReport->numContacts  = layout->numCollections;
+
+    HIDContactBatch batch;
+    HIDReportDecoderDecodeBatch(layout, report, length, &batch);
+
+    for (uint8_t i = 0; i < layout->numCollections; i++) {
+        const HIDReportField *fields = layout->collections[i].fields;
+        HIDDecodedContact *contact = &outReport->contacts[i];
+
+        contact->x = batch.x[i];
+        contact->y = batch.y[i];
+
+        contact->contactID = batch.contactID[i];
+        contact->tipSwitch = batch.tipSwitch[i];
+        contact->isValid   = batch.isValid[i];
+
+        contact->width   = ReadOptional(&fields[HIDTouchFieldWidth], report, length, kHIDDecoderValueAbsent);
+        contact->height  = ReadOptional(&fields[HIDTouchFieldHeight], report, length, kHIDDecoderValueAbsent);
+        contact->azimuth = ReadOptional(&fields[HIDTouchFieldAzimuth], report, length, kHIDDecoderValueAbsent);
+
+        // a size is a length, the logical minimum does not shift it
+        contact->relativeWidth  = contact->width  != kHIDDecoderValueAbsent ? (float)contact->width  * fields[HIDTouchFieldWidth].scale  : -1;
+        contact->relativeHeight = contact->height != kHIDDecoderValueAbsent ? (float)contact->height * fields[HIDTouchFieldHeight].scale : -1;
+        contact->timestamp = 0;
+    }
+
+    return true;
+}
@@ -0,0 +1,174 @@
+//
+//  HIDReportDecoder.h
+//  Touch Up Core
+//
+//  Created by Touch Up contributors on 16.10.26.
+//
+
+#ifndef HIDReportDecoder_h
+#define HIDReportDecoder_h
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ Platform neutral decoder for digitizer input reports.
+
+ The report descriptor is parsed once when a device connects. The result is a flat table that stores for every touch collection
+ (the logical "Finger" collections of a touch screen) where each field lives in the report: bit offset, bit width and logical range.
+ Incoming reports are then decoded straight from their byte buffer in one pass, without going through IOKit element and value objects.
+
+ This file must not depend on IOKit or CoreFoundation, so it can be compiled and fed with captured descriptors on any platform.
+ */
+
+
+#define HID_DECODER_MAX_COLLECTIONS 20   // touch collections per report, multiple of 4 (SIMD lanes)
+#define HID_DECODER_MAX_REPORTS      4   // distinct touch report IDs per device
+
+// used for optional values that are not part of a report
+#define kHIDDecoderValueAbsent INT32_MIN
+
+
+typedef enum {
+    HIDTouchFieldX = 0,
+    HIDTouchFieldY,
+    HIDTouchFieldTip,
+    HIDTouchFieldValid,
+    HIDTouchFieldContactID,
+    HIDTouchFieldWidth,
+    HIDTouchFieldHeight,
+    HIDTouchFieldAzimuth,
+    HIDTouchFieldCount
+} HIDTouchField;
+
+
+/**
+ Location of a single value inside a report. A `bitSize` of 0 means the field does not exist.
+ `scale` and `offset` map the logical range to 0...1: normalized = raw * scale + offset
+ */
+typedef struct {
+    uint32_t bitOffset;     // counted from the first byte of the report buffer (including the report ID byte)
+    uint8_t  bitSize;
+    bool     isSigned;
+    int32_t  logicalMin;
+    int32_t  logicalMax;
+    float    scale;
+    float    offset;
+} HIDReportField;
+
+
+typedef struct {
+    HIDReportField fields[HIDTouchFieldCount];
+} HIDTouchCollectionLayout;
+
+
+// X, Y, Tip, Valid and Contact ID are unpacked for all collections at once (the first fields of HIDTouchField)
+#define HID_BATCH_FIELD_COUNT (HIDTouchFieldContactID + 1)
+
+/**
+ A field that sits at the same bit position of every touch collection, the collections repeating every `strideBytes`.
+ This holds for all screens we know, as their descriptor declares the finger collection once and repeats it.
+ Such a field is extracted for 4 collections at a time with SIMD instructions, otherwise field by field.
+ */
+typedef struct {
+    bool     isUniform;
+    uint32_t firstByte;     // byte of the field in the first collection
+    uint32_t strideBytes;
+    uint8_t  shift;         // bit position inside the byte, identical for all collections
+    uint8_t  bitSize;       // at most 25, so one unaligned 32 bit load covers the field
+    bool     isSigned;
+    float    scale;
+    float    offset;
+} HIDBatchField;
+
+
+typedef struct {
+    uint8_t  reportID;
+    uint32_t byteLength;        // expected length of the report buffer (including the report ID byte)
+
+    HIDReportField contactCount;
+    HIDReportField scanTime;
+
+    uint8_t  numCollections;
+    HIDTouchCollectionLayout collections[HID_DECODER_MAX_COLLECTIONS];
+
+    HIDBatchField batchFields[HID_BATCH_FIELD_COUNT];
+} HIDTouchReportLayout;
+
+
+typedef struct {
+    bool    usesReportIDs;
+    uint8_t numReports;
+    HIDTouchReportLayout reports[HID_DECODER_MAX_REPORTS];
+} HIDReportDecoder;
+
+
+typedef struct {
+    int32_t contactID;
+    float   x;              // normalized 0...1
+    float   y;              // normalized 0...1
+    uint8_t tipSwitch;
+    uint8_t isValid;
+    int32_t width;          // logical units, kHIDDecoderValueAbsent if not reported
+    int32_t height;
+    int32_t azimuth;
+    float   relativeWidth;  // width and height normalized like x and y (raw * scale of their field), -1 if not reported
+    float   relativeHeight;
+    uint64_t timestamp;     // sample time on the host timeline in ns, filled in by the caller (see HIDDeviceClock)
+} HIDDecodedContact;
+
+
+/**
+ All touch collections of one report as structure of arrays. X and Y are already normalized to 0...1.
+ */
+typedef struct {
+    uint8_t count;
+    float   x[HID_DECODER_MAX_COLLECTIONS];
+    float   y[HID_DECODER_MAX_COLLECTIONS];
+    int32_t contactID[HID_DECODER_MAX_COLLECTIONS];
+    uint8_t tipSwitch[HID_DECODER_MAX_COLLECTIONS];
+    uint8_t isValid[HID_DECODER_MAX_COLLECTIONS];
+} HIDContactBatch;
+
+
+typedef struct {
+    uint8_t reportID;
+    int32_t contactCount;   // kHIDDecoderValueAbsent if the report has no Contact Count
+    int32_t scanTime;       // kHIDDecoderValueAbsent if the report has no Relative Scan Time
+
+    uint8_t numContacts;    // one entry per touch collection of the report, including empty slots
+    HIDDecodedContact contacts[HID_DECODER_MAX_COLLECTIONS];
+} HIDDecodedReport;
+
+
+
+/**
+ Parses the report descriptor of a digitizer and fills the layout table.
+ Returns false if the descriptor is malformed or does not describe any touch collection.
+ */
+bool HIDReportDecoderCompile(HIDReportDecoder *decoder, const uint8_t *descriptor, size_t length);
+
+/**
+ Returns the layout matching the report ID of the given buffer or NULL if the report does not carry touch data.
+ */
+const HIDTouchReportLayout *HIDReportDecoderLayoutForReport(const HIDReportDecoder *decoder, const uint8_t *report, size_t length);
+
+/**
+ Decodes all touch collections of one input report. Returns false if the report is unknown or too short.
+ */
+bool HIDReportDecoderDecode(const HIDReportDecoder *decoder, const uint8_t *report, size_t length, HIDDecodedReport *outReport);
+
+/**
+ Unpacks X, Y, tip, valid and contact ID of all touch collections of the report in one pass (SSE2 / NEON, scalar otherwise).
+ Reports with fewer than 4 collections, like the hybrid reports of our ELAN screens, are read field by field.
+ `layout` must be the layout of the report, see HIDReportDecoderLayoutForReport.
+ */
+void HIDReportDecoderDecodeBatch(const HIDTouchReportLayout *layout, const uint8_t *report, size_t length, HIDContactBatch *batch);
+
+/**
+ Reads a single field from a report buffer. Bits beyond the end of the buffer read as zero.
+ */
+int32_t HIDReportFieldRead(const HIDReportField *field, const uint8_t *report, size_t length);
+
+#endif /* HIDReportDecoder_h */
@@ -0,0 +1,126 @@
+//
+//  HIDValueStore.c
+//  Touch Up Core
+//
+//  Created by Touch Up contributors on 16.10.26.
+//
+
+#include "HIDValueStore.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+
+static uint32_t NumberOfWords(const HIDValueStore *store) {
+    return (store->capacity + 63) / 64;
+}
+
+
+bool HIDValueStoreCreate(HIDValueStore *store, uint32_t maxCookie) {
+    HIDValueStoreDestroy(store);
+
+    uint32_t capacity = maxCookie + 1;
+    uint32_t words = (capacity + 63) / 64;
+
+    store->values     = calloc(capacity, sizeof(int64_t));
+    store->storedBits = calloc(words, sizeof(uint64_t));
+    store->seenBits   = calloc(words, sizeof(uint64_t));
+
+    if (!store->values || !store->storedBits || !store->seenBits) {
+        HIDValueStoreDestroy(store);
+        return false;
+    }
+
+    store->capacity = capacity;
+    return true;
+}
+
+
+void HIDValueStoreDestroy(HIDValueStore *store) {
+    free(store->values);
+    free(store->storedBits);
+    free(store->seenBits);
+
+    store->values     = NULL;
+    store->storedBits = NULL;
+    store->seenBits   = NULL;
+    store->capacity   = 0;
+}
+
+
+void HIDValueStoreReset(HIDValueStore *store) {
+    if (store->capacity == 0) {
+        return;
+    }
+    memset(store->storedBits, 0, NumberOfWords(store) * sizeof(uint64_t));
+    memset(store->seenBits, 0, NumberOfWords(store) * sizeof(uint64_t));
+}
+
+
+void HIDValueStoreBeginFrame(HIDValueStore *store) {
+    if (store->capacity == 0) {
+        return;
+    }
+    memset(store->seenBits, 0, NumberOfWords(store) * sizeof(uint64_t));
+}
+
+
+
+#pragma mark - Touch Collections
+
+void HIDTouchCollectionMapInit(HIDTouchCollectionMap *map) {
+    for (int i = 0; i < HIDTouchFieldCount; i++) {
+        map->slots[i] = kHIDValueStoreNoSlot;
+    }
+    map->xScale  = 0;
+    map->xOffset = -1;
+    map->yScale  = 0;
+    map->yOffset = -1;
+    map->widthScale  = 0;
+    map->heightScale = 0;
+}
+
+
+void HIDTouchCollectionMapSetRange(HIDTouchCollectionMap *map, HIDTouchField field, int64_t logicalMin, int64_t logicalMax) {
+    float range  = (float)(logicalMax - logicalMin);
+    float scale  = range != 0 ? 1.0f / range : 0;
+    float offset = -(float)logicalMin * scale;
+
+    if (field == HIDTouchFieldX) {
+        map->xScale  = scale;
+        map->xOffset = offset;
+    } else if (field == HIDTouchFieldY) {
+        map->yScale  = scale;
+        map->yOffset = offset;
+    } else if (field == HIDTouchFieldWidth) {
+        map->widthScale  = scale;
+    } else if (field == HIDTouchFieldHeight) {
+        map->heightScale = scale;
+    }
+}
+
+
+static inline int64_t ReadSlot(const HIDValueStore *store, uint32_t slot, int64_t fallback) {
+    int64_t value;
+    return HIDValueStoreGet(store, slot, &value) ? value : fallback;
+}
+
+
+void HIDValueStoreReadContact(const HIDValueStore *store, const HIDTouchCollectionMap *map, HIDDecodedContact *contact) {
+    int64_t value;
+
+    contact->x = HIDValueStoreGet(store, map->slots[HIDTouchFieldX], &value) ? (float)value * map->xScale + map->xOffset : -1;
+    contact->y = HIDValueStoreGet(store, map->slots[HIDTouchFieldY], &value) ? (float)value * map->yScale + map->yOffset : -1;
+
+    contact->contactID = (int32_t)ReadSlot(store, map->slots[HIDTouchFieldContactID], 0);
+    contact->tipSwitch = (uint8_t)ReadSlot(store, map->slots[HIDTouchFieldTip], 0);
+    contact->isValid   = (uint8_t)ReadSlot(store, map->slots[HIDTouchFieldValid], 0);
+
+    contact->width   = (int32_t)ReadSlot(store, map->slots[HIDTouchFieldWidth], kHIDDecoderValueAbsent);
+    contact->height  = (int32_t)ReadSlot(store, map->slots[HIDTouchFieldHeight], kHIDDecoderValueAbsent);
+    contact->azimuth = (int32_t)ReadSlot(store, map->slots[HIDTouchFieldAzimuth], kHIDDecoderValueAbsent);
+
+    contact->relativeWidth  = contact->width  != kHIDDecoderValueAbsent ? (float)contact->width  * map->widthScale  : -1;
+    contact->relativeHeight = contact->height != kHIDDecoderValueAbsent ? (float)contact->height * map->heightScale : -1;
+    contact->timestamp = 0;
+}
@@ -0,0 +1,105 @@
+//
+//  HIDValueStore.h
+//  Touch Up Core
+//
+//  Created by Touch Up contributors on 16.10.26.
+//
+
+#ifndef HIDValueStore_h
+#define HIDValueStore_h
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#include "HIDReportDecoder.h"
+
+/*
+ Latest value per HID element, indexed directly by the element cookie.
+
+ The arrays are allocated once when the element tree is identified. Storing and reading values afterwards are plain array
+ accesses without any heap traffic. Besides the last value every slot has two bits:
+ - stored: the element received a value at least once (values persist across reports, which hybrid mode relies on)
+ - seen:   the element received a value during the current frame, cleared by HIDValueStoreBeginFrame
+ */
+
+typedef struct {
+    int64_t  *values;
+    uint64_t *storedBits;
+    uint64_t *seenBits;
+    uint32_t  capacity;     // highest cookie + 1
+} HIDValueStore;
+
+
+#define kHIDValueStoreNoSlot UINT32_MAX
+
+/**
+ Precompiled description of one touch collection, built once when the element tree is identified:
+ which slot of the store holds which field and how X and Y are normalized (normalized = raw * scale + offset).
+ Width and height are scaled without offset.
+ */
+typedef struct {
+    uint32_t slots[HIDTouchFieldCount];     // cookie per field, kHIDValueStoreNoSlot if the collection lacks it
+    float    xScale;
+    float    xOffset;
+    float    yScale;
+    float    yOffset;
+    float    widthScale;
+    float    heightScale;
+} HIDTouchCollectionMap;
+
+
+
+/**
+ Allocates slots for the cookies 0...maxCookie. An existing allocation of the store is released first.
+ */
+bool HIDValueStoreCreate(HIDValueStore *store, uint32_t maxCookie);
+
+void HIDValueStoreDestroy(HIDValueStore *store);
+
+/**
+ Forgets all values, keeps the allocation.
+ */
+void HIDValueStoreReset(HIDValueStore *store);
+
+/**
+ Clears the seen bits. Call after a report was dispatched completely.
+ */
+void HIDValueStoreBeginFrame(HIDValueStore *store);
+
+
+
+static inline void HIDValueStoreSet(HIDValueStore *store, uint32_t cookie, int64_t value) {
+    if (cookie >= store->capacity) {
+        return;
+    }
+    store->values[cookie] = value;
+    store->storedBits[cookie >> 6] |= 1ull << (cookie & 63);
+    store->seenBits[cookie >> 6]   |= 1ull << (cookie & 63);
+}
+
+static inline bool HIDValueStoreGet(const HIDValueStore *store, uint32_t cookie, int64_t *value) {
+    if (cookie >= store->capacity || !(store->storedBits[cookie >> 6] & (1ull << (cookie & 63)))) {
+        return false;
+    }
+    *value = store->values[cookie];
+    return true;
+}
+
+static inline bool HIDValueStoreWasSeen(const HIDValueStore *store, uint32_t cookie) {
+    return cookie < store->capacity && (store->seenBits[cookie >> 6] & (1ull << (cookie & 63)));
+}
+
+/**
+ Initializes a map with no fields. Set the slots and call HIDTouchCollectionMapSetRange for X, Y, width and height afterwards.
+ */
+void HIDTouchCollectionMapInit(HIDTouchCollectionMap *map);
+
+void HIDTouchCollectionMapSetRange(HIDTouchCollectionMap *map, HIDTouchField field, int64_t logicalMin, int64_t logicalMax);
+
+/**
+ Reads the latest values of one touch collection. Fields without value read like in HIDReportDecoderDecode:
+ position and relative size -1, contact ID, tip and valid 0, size and azimuth kHIDDecoderValueAbsent.
+ */
+void HIDValueStoreReadContact(const HIDValueStore *store, const HIDTouchCollectionMap *map, HIDDecodedContact *contact);
+
+#endif /* HIDValueStore_h */
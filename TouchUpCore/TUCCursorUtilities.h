@@ -7,6 +7,8 @@
 
 #import <Cocoa/Cocoa.h>
 
+#import "TUCEventSink.h"
+
 NS_ASSUME_NONNULL_BEGIN
 
 @interface TUCCursorUtilities : NSObject
@@ -16,8 +18,34 @@ NS_ASSUME_NONNULL_BEGIN
 
 @property CGFloat doubleClickTolerance;
 
+/**
+ Sample time of the touch the next moves answer, seconds on the mach_absolute_time timeline. Set by the touch manager before it
+ performs a gesture, only used for the latency in the output report of the `TUCOutputScheduler`.
+ */
+@property NSTimeInterval inputTimestamp;
+
+/**
+ Where the events go, by default to the system (`TUCSystemEventSink`). Set a `TUCMemoryEventSink` or `TUCFileEventSink` to run
+ the gesture pipeline without moving the real cursor.
+ */
+@property (strong) id<TUCEventSink> eventSink;
+
+/**
+ Where the cursor is after the events posted so far. Only asks the system again after `resynchronizeCursorState`.
+ */
 - (CGPoint)currentCursorLocation;
 
+/**
+ Marks the cursor model (location, button state, click count) as stale, the next event reads it from the system again.
+ Focus changes and events of other mouse devices do this already; call it after anything else that moves the cursor.
+ */
+- (void)resynchronizeCursorState;
+
+/**
+ Posts a move to where the cursor already is, e.g. to make the system ask for the accessibility permission.
+ */
+- (void)postCursorLocation;
+
 - (void)bringWindowToFrontAt:(CGPoint)aLocation;
 
 - (void)moveCursorTo:(CGPoint)aLocation;
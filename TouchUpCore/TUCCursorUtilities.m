@@ -7,7 +7,25 @@
 
 #import "TUCCursorUtilities.h"
 
-@interface TUCCursorUtilities ()
+#import <os/lock.h>
+
+#import "TUCLog.h"
+#import "TUCMomentumScroller.h"
+#import "TUCOutputScheduler.h"
+
+@interface TUCCursorUtilities () {
+    // fed on the inputQueue, stepped on the frame clock of the output scheduler
+    os_unfair_lock _momentumLock;
+    TUCMomentumScroller _momentumScroller;
+}
+
+@property (strong) TUCOutputScheduler *outputScheduler;
+
+// shadow of the system cursor, kept up to date by every posted event instead of asking the window server
+@property CGPoint cursorLocation;
+@property BOOL needsCursorResync;       // set on the main thread by the triggers, consumed with the next event
+@property BOOL hasExternalClick;        // a mouse clicked in between, the next click starts a new click sequence
+@property (strong) id externalMouseMonitor;
 
 @property NSInteger cursorClickCount;
 @property NSDate *timeOfLastClick;
@@ -15,9 +33,6 @@
 
 @property BOOL isLeftMouseDown;
 
-@property CGPoint momentumScrollTranslation;
-@property (strong) NSTimer *momentumScrollTimer;
-
 @property BOOL isMagnifying;
 @property CGFloat lastPinchDistance;
 
@@ -31,10 +46,17 @@
     dispatch_once(&onceToken, ^{
         if (!sharedInstance) {
             sharedInstance = [[TUCCursorUtilities alloc] init];
+            sharedInstance.outputScheduler = [[TUCOutputScheduler alloc] init];
             sharedInstance.isLeftMouseDown = NO;
             sharedInstance.cursorClickCount = 0;
             sharedInstance.timeOfLastClick = [NSDate dateWithTimeIntervalSince1970:0];
             sharedInstance.locationOfLastClick = CGPointZero;
+            sharedInstance.needsCursorResync = YES;
+            [sharedInstance setUpMomentumScroll];
+            
+            dispatch_async(dispatch_get_main_queue(), ^{
+                [sharedInstance observeExternalCursorChanges];
+            });
         }
     });
     return sharedInstance;
@@ -44,58 +66,133 @@
 
 
 
+#pragma mark - Cursor State
+
+- (id<TUCEventSink>)eventSink {
+    return self.outputScheduler.sink;
+}
+
+
+- (void)setEventSink:(id<TUCEventSink>)eventSink {
+    self.outputScheduler.sink = eventSink;
+    [self resynchronizeCursorState];
+}
+
+
+
 - (CGPoint)currentCursorLocation {
-    CGEventRef dummy = CGEventCreate(NULL);
-    CGPoint location = CGEventGetLocation(dummy);
-    CFRelease(dummy);
-    return location;
+    [self resynchronizeCursorStateIfNeeded];
+    return self.cursorLocation;
 }
 
 
+- (void)resynchronizeCursorState {
+    self.needsCursorResync = YES;
+}
 
-- (void)moveCursorTo:(CGPoint)aLocation {
-    printf("[CursorUtil] moveCursorTo REQUESTED: (%.1f, %.1f)\n", aLocation.x, aLocation.y);
+
+/**
+ Runs on the main thread: watches for everything that moves the cursor or changes the click sequence behind our back.
+ */
+- (void)observeExternalCursorChanges {
+    __weak TUCCursorUtilities *weakSelf = self;
+    pid_t ownProcessID = getpid();
+    NSEventMask mask = NSEventMaskMouseMoved | NSEventMaskLeftMouseDragged | NSEventMaskRightMouseDragged
+                     | NSEventMaskLeftMouseDown | NSEventMaskLeftMouseUp | NSEventMaskRightMouseDown | NSEventMaskRightMouseUp;
+    
+    self.externalMouseMonitor = [NSEvent addGlobalMonitorForEventsMatchingMask:mask handler:^(NSEvent *event) {
+        // our own events arrive here as well
+        CGEventRef cgEvent = event.CGEvent;
+        if (cgEvent != NULL && CGEventGetIntegerValueField(cgEvent, kCGEventSourceUnixProcessID) == ownProcessID) {
+            return;
+        }
+        
+        if (event.type == NSEventTypeLeftMouseDown || event.type == NSEventTypeRightMouseDown) {
+            weakSelf.hasExternalClick = YES;
+        }
+        weakSelf.needsCursorResync = YES;
+    }];
+    
+    [[[NSWorkspace sharedWorkspace] notificationCenter] addObserverForName:NSWorkspaceDidActivateApplicationNotification
+                                                                    object:nil queue:nil usingBlock:^(NSNotification *note) {
+        weakSelf.needsCursorResync = YES;
+    }];
+}
+
+
+/**
+ The only place that asks the window server, and only after a trigger.
+ */
+- (void)resynchronizeCursorStateIfNeeded {
+    if (!self.needsCursorResync) {
+        return;
+    }
+    self.needsCursorResync = NO;
     
-    // Teste: Wo ist der Cursor VOR dem Move?
-    CGEventRef dummyBefore = CGEventCreate(NULL);
-    CGPoint cursorBefore = CGEventGetLocation(dummyBefore);
-    CFRelease(dummyBefore);
-    printf("[CursorUtil]    -> Cursor VOR move: (%.1f, %.1f)\n", cursorBefore.x, cursorBefore.y);
+    if (!self.eventSink.movesSystemCursor) {
+        // recording or headless: the model is the only cursor there is
+        return;
+    }
+    
+    // the system position has to include our pending move
+    [self.outputScheduler flush];
+    
+    CGEventRef event = CGEventCreate(NULL);
+    self.cursorLocation = CGEventGetLocation(event);
+    CFRelease(event);
+    
+    // a button held on a mouse is not ours to release, only learn that ours went up
+    if (self.isLeftMouseDown && !CGEventSourceButtonState(kCGEventSourceStateCombinedSessionState, kCGMouseButtonLeft)) {
+        self.isLeftMouseDown = NO;
+    }
+    
+    if (self.hasExternalClick) {
+        // a click of the mouse must not count as the first half of a double click
+        self.hasExternalClick = NO;
+        self.cursorClickCount = 0;
+        self.timeOfLastClick = [NSDate dateWithTimeIntervalSince1970:0];
+    }
+    
+    TUCLogDebug(Cursor, "[CursorUtil] resynchronized: (%.1f, %.1f) mouseDown=%d",
+                self.cursorLocation.x, self.cursorLocation.y, self.isLeftMouseDown);
+}
+
+
+
+#pragma mark - Posting Events
+
+- (void)moveCursorTo:(CGPoint)aLocation {
+    TUCLogTrace(Cursor, "[CursorUtil] moveCursorTo REQUESTED: (%.1f, %.1f)", aLocation.x, aLocation.y);
     
     [self cancelMomentumScroll];
     [self stopDraggingCursor];
     
-    CGEventRef event = CGEventCreateMouseEvent(NULL, kCGEventMouseMoved, aLocation, kCGMouseButtonLeft);
-    CGEventSetIntegerValueField(event, kCGMouseEventClickState, 0);
-    CGEventPost(kCGHIDEventTap, event);
-    CFRelease(event);
+    CGPoint cursorBefore = [self currentCursorLocation];
+    if (CGPointEqualToPoint(aLocation, cursorBefore)) {
+        TUCLogTrace(Cursor, "[CursorUtil] moveCursorTo SKIPPED, cursor is already there");
+        return;
+    }
     
-    // Teste: Wo ist der Cursor NACH dem Move?
-    CGEventRef dummyAfter = CGEventCreate(NULL);
-    CGPoint cursorAfter = CGEventGetLocation(dummyAfter);
-    CFRelease(dummyAfter);
-    printf("[CursorUtil]    -> Cursor NACH move: (%.1f, %.1f)\n", cursorAfter.x, cursorAfter.y);
-    printf("[CursorUtil]    -> Delta: (%.1f, %.1f)\n", 
-           cursorAfter.x - aLocation.x, cursorAfter.y - aLocation.y);
-    printf("[CursorUtil] moveCursorTo COMPLETED\n");
+    // posted with the next display refresh, a newer move replaces it until then
+    [self.outputScheduler scheduleMoveOfType:kCGEventMouseMoved to:aLocation clickState:0 inputTimestamp:self.inputTimestamp];
+    self.cursorLocation = aLocation;
+    
+    TUCLogTrace(Cursor, "[CursorUtil] moveCursorTo COMPLETED: from (%.1f, %.1f)", cursorBefore.x, cursorBefore.y);
+}
+
+
+- (void)postCursorLocation {
+    [self.outputScheduler postMouseEventOfType:kCGEventMouseMoved at:[self currentCursorLocation] clickState:0];
 }
 
 
 
 - (void)bringWindowToFrontAt:(CGPoint)aLocation {
-    CGEventRef event = CGEventCreateMouseEvent(NULL, kCGEventLeftMouseDown, aLocation, kCGMouseButtonLeft);
-    CGEventSetIntegerValueField(event, kCGMouseEventClickState, 1);
-    CGEventTimestamp time = CGEventGetTimestamp(event);
-    CGEventSetTimestamp(event, time-1);
-    
-    CGEventPost(kCGHIDEventTap, event);
-    CGEventSetType(event, kCGEventLeftMouseDragged);
-    CGEventPost(kCGHIDEventTap, event);
-    CGEventSetLocation(event, aLocation);
-    CGEventSetType(event, kCGEventLeftMouseUp);
-    CGEventPost(kCGHIDEventTap, event);
+    [self.outputScheduler postMouseEventOfType:kCGEventLeftMouseDown at:aLocation clickState:1];
+    [self.outputScheduler postMouseEventOfType:kCGEventLeftMouseDragged at:aLocation clickState:1];
+    [self.outputScheduler postMouseEventOfType:kCGEventLeftMouseUp at:aLocation clickState:1];
     
-    CFRelease(event);
+    self.cursorLocation = aLocation;
     //    self.isLeftMouseDown = YES;
 }
 
@@ -103,19 +200,16 @@
  integrated double click support: needs checks time between clicks and spatial distance
  */
 - (void)performClickAt:(CGPoint)aLocation {
-    printf("[CursorUtil] performClickAt (%.1f, %.1f)\n", aLocation.x, aLocation.y);
+    TUCLogDebug(Cursor, "[CursorUtil] performClickAt (%.1f, %.1f)", aLocation.x, aLocation.y);
     [self updateCursorClickCountWithLocation:aLocation];
     
-    CGEventRef event = CGEventCreateMouseEvent(NULL, kCGEventLeftMouseDown, aLocation, kCGMouseButtonLeft);
-    CGEventSetIntegerValueField(event, kCGMouseEventClickState, self.cursorClickCount);
-    CGEventPost(kCGHIDEventTap, event);
-    CGEventSetType(event, kCGEventLeftMouseUp);
-    CGEventPost(kCGHIDEventTap, event);
-    CFRelease(event);
+    [self.outputScheduler postMouseEventOfType:kCGEventLeftMouseDown at:aLocation clickState:self.cursorClickCount];
+    [self.outputScheduler postMouseEventOfType:kCGEventLeftMouseUp at:aLocation clickState:self.cursorClickCount];
     
+    self.cursorLocation = aLocation;
     self.timeOfLastClick = [NSDate date];
     self.locationOfLastClick = aLocation;
-    printf("[CursorUtil] performClickAt COMPLETED (clickCount=%ld)\n", (long)self.cursorClickCount);
+    TUCLogDebug(Cursor, "[CursorUtil] performClickAt COMPLETED (clickCount=%ld)", (long)self.cursorClickCount);
 }
 
 
@@ -137,18 +231,16 @@
 
 
 - (void)performSecondaryClickAt:(CGPoint)aLocation {
-    CGEventRef event = CGEventCreateMouseEvent(NULL, kCGEventRightMouseDown, aLocation, kCGMouseButtonRight);
-    CGEventSetIntegerValueField(event, kCGMouseEventClickState, 1);
-    CGEventPost(kCGHIDEventTap, event);
-    CGEventSetType(event, kCGEventRightMouseUp);
-    CGEventPost(kCGHIDEventTap, event);
-    CFRelease(event);
+    [self.outputScheduler postMouseEventOfType:kCGEventRightMouseDown at:aLocation clickState:1];
+    [self.outputScheduler postMouseEventOfType:kCGEventRightMouseUp at:aLocation clickState:1];
+    
+    self.cursorLocation = aLocation;
 }
 
 
 
 - (void)dragCursorTo:(CGPoint)aLocation phase:(NSTouchPhase)phase  {
-    printf("[CursorUtil] dragCursorTo (%.1f, %.1f) phase=%ld mouseDown=%d\n", aLocation.x, aLocation.y, (long)phase, self.isLeftMouseDown);
+    TUCLogTrace(Cursor, "[CursorUtil] dragCursorTo (%.1f, %.1f) phase=%ld mouseDown=%d", aLocation.x, aLocation.y, (long)phase, self.isLeftMouseDown);
     if (phase == NSTouchPhaseEnded || phase == NSTouchPhaseCancelled) {
         [self stopDraggingCursor];
         return;
@@ -156,31 +248,27 @@
     
     
     if (self.isLeftMouseDown) {
-        CGEventRef event = CGEventCreateMouseEvent(NULL, kCGEventLeftMouseDragged, aLocation, kCGMouseButtonLeft);
-        CGEventSetIntegerValueField(event, kCGMouseEventClickState, self.cursorClickCount);
-        CGEventPost(kCGHIDEventTap, event);
-        CFRelease(event);
-        printf("[CursorUtil] dragCursorTo DRAGGING\n");
+        if (CGPointEqualToPoint(aLocation, [self currentCursorLocation])) {
+            return;
+        }
+        [self.outputScheduler scheduleMoveOfType:kCGEventLeftMouseDragged to:aLocation clickState:self.cursorClickCount
+                                  inputTimestamp:self.inputTimestamp];
+        self.cursorLocation = aLocation;
+        TUCLogTrace(Cursor, "[CursorUtil] dragCursorTo DRAGGING");
     } else {
         [self moveCursorTo:aLocation];
         [self updateCursorClickCountWithLocation:aLocation];
-        CGEventRef event = CGEventCreateMouseEvent(NULL, kCGEventLeftMouseDown, aLocation, kCGMouseButtonLeft);
-        CGEventSetIntegerValueField(event, kCGMouseEventClickState, self.cursorClickCount);
-        CGEventPost(kCGHIDEventTap, event);
-        CFRelease(event);
+        [self.outputScheduler postMouseEventOfType:kCGEventLeftMouseDown at:aLocation clickState:self.cursorClickCount];
         
         self.isLeftMouseDown = YES;
-        printf("[CursorUtil] dragCursorTo MOUSE_DOWN sent\n");
+        TUCLogDebug(Cursor, "[CursorUtil] dragCursorTo MOUSE_DOWN sent");
     }
 }
 
 
 - (void)stopDraggingCursor {
     if (self.isLeftMouseDown) {
-        CGEventRef event = CGEventCreateMouseEvent(NULL, kCGEventLeftMouseUp, [self currentCursorLocation], kCGMouseButtonLeft);
-        CGEventSetIntegerValueField(event, kCGMouseEventClickState, self.cursorClickCount);
-        CGEventPost(kCGHIDEventTap, event);
-        CFRelease(event);
+        [self.outputScheduler postMouseEventOfType:kCGEventLeftMouseUp at:[self currentCursorLocation] clickState:self.cursorClickCount];
         
         self.isLeftMouseDown = NO;
     }
@@ -191,44 +279,30 @@
 - (void)scroll:(CGPoint)translation phase:(NSTouchPhase)phase {
     [self stopDraggingCursor];
     
-    CGEventRef event = CGEventCreateScrollWheelEvent2(NULL, kCGScrollEventUnitPixel, 2, translation.y, translation.x, 0);
-    
-    CGEventPost(kCGHIDEventTap, event);
-    CFRelease(event);
+    [self.outputScheduler postScrollBy:translation];
     
-    if (phase == NSTouchPhaseEnded) {
-        // TODO: consider sampling rate of digitizer and screen refresh rate
-        [self cancelMomentumScroll];
-        
-        self.momentumScrollTimer = [NSTimer scheduledTimerWithTimeInterval:0.01 target:self selector:@selector(updateMomentumScroll) userInfo:nil repeats:YES];
+    os_unfair_lock_lock(&_momentumLock);
+    BOOL isCoasting = NO;
+    if (phase == NSTouchPhaseCancelled) {
+        TUCMomentumScrollerCancel(&_momentumScroller);
     } else {
-        self.momentumScrollTranslation = translation;
+        TUCMomentumScrollerAddSample(&_momentumScroller, translation.x, translation.y, self.inputTimestamp);
+        if (phase == NSTouchPhaseEnded) {
+            isCoasting = TUCMomentumScrollerRelease(&_momentumScroller, self.inputTimestamp);
+        }
     }
-}
-
-
-
-- (void)updateMomentumScroll {
-    self.momentumScrollTranslation = CGPointMake(self.momentumScrollTranslation.x * 0.985,
-                                                 self.momentumScrollTranslation.y * 0.985);
+    os_unfair_lock_unlock(&_momentumLock);
     
-    if (fabs(self.momentumScrollTranslation.x) < 0.1 && fabs(self.momentumScrollTranslation.y) < 0.1) {
-        [self cancelMomentumScroll];
+    if (isCoasting) {
+        __weak TUCCursorUtilities *weakSelf = self;
+        self.outputScheduler.frameHandler = ^BOOL(NSTimeInterval time) {
+            return [weakSelf updateMomentumScrollAt:time];
+        };
     }
-    
-    [self scroll:self.momentumScrollTranslation phase:NSTouchPhaseMoved];
 }
 
 
 
-- (void)cancelMomentumScroll {
-    if (self.momentumScrollTimer != nil) {
-        [self.momentumScrollTimer invalidate];
-        self.momentumScrollTimer = nil;
-    }
-}
-
-
 - (void)magnify:(CGFloat)magnification phase:(NSTouchPhase)phase {
     [self stopDraggingCursor];
     
@@ -237,35 +311,8 @@
         return;
     }
     
-    // start with a valid mouse event, as it has a valid timestamp
-    CGEventRef event = CGEventCreateMouseEvent(NULL, kCGEventMouseMoved, [self currentCursorLocation], kCGMouseButtonLeft);
-    
-    CGEventSetType(event, 29); // type gesture
-    CGEventSetFlags(event, 0);
-    
-    CGEventSetDoubleValueField(event, 113, magnification);
-    CGEventSetDoubleValueField(event, 114, magnification);
-    CGEventSetDoubleValueField(event, 116, magnification);
-    CGEventSetDoubleValueField(event, 118, magnification);
-    
-    // magic
-//    CGEventSetIntegerValueField(event, 55, 29); //if more touches on trackapd 30? about concurrent gestures???
-    CGEventSetIntegerValueField(event, 50, 248);
-    CGEventSetIntegerValueField(event, 101, 4);
-    CGEventSetIntegerValueField(event, 110, 8);
-    
-    
-    CGGesturePhase gesturePhase = kCGGesturePhaseEnded;
-    if (phase == NSTouchPhaseBegan) {
-        gesturePhase = kCGGesturePhaseBegan;
-    } else if (phase == NSTouchPhaseMoved || phase == NSTouchPhaseStationary) {
-        gesturePhase = kCGGesturePhaseChanged;
-    }
-    
-    CGEventSetIntegerValueField(event, 132, phase);
-    
-    CGEventPost(kCGHIDEventTap, event);
-    CFRelease(event);
+    // the gesture event with the private fields is prepared once in the TUCEventPool
+    [self.outputScheduler postMagnification:magnification phase:phase at:[self currentCursorLocation]];
 }
 
 
@@ -301,4 +348,41 @@
     }
 }
 
+
+
+#pragma mark - Momentum Scroll
+
+- (void)setUpMomentumScroll {
+    _momentumLock = OS_UNFAIR_LOCK_INIT;
+    TUCMomentumScrollerInit(&_momentumScroller);
+}
+
+
+/**
+ Runs on the frame clock, once per display refresh. Returns NO when the momentum has ended or was cancelled.
+ */
+- (BOOL)updateMomentumScrollAt:(NSTimeInterval)time {
+    os_unfair_lock_lock(&_momentumLock);
+    
+    double dx, dy;
+    BOOL isCoasting = TUCMomentumScrollerStep(&_momentumScroller, time, &dx, &dy);
+    if (dx != 0 || dy != 0) {
+        // under the lock, so nothing is posted after a cancel
+        [self.outputScheduler postScrollBy:CGPointMake(dx, dy)];
+    }
+    
+    os_unfair_lock_unlock(&_momentumLock);
+    return isCoasting;
+}
+
+
+/**
+ Cheap enough for every move, the frame handler removes itself on the next refresh.
+ */
+- (void)cancelMomentumScroll {
+    os_unfair_lock_lock(&_momentumLock);
+    TUCMomentumScrollerCancel(&_momentumScroller);
+    os_unfair_lock_unlock(&_momentumLock);
+}
+
 @end
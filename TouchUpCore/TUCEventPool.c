@@ -0,0 +1,153 @@
+//
+//  TUCEventPool.c
+//  Touch Up Core
+//
+//  Created by Touch Up contributors on 16.10.26.
+//
+
+#include "TUCEventPool.h"
+
+#include <mach/mach_time.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#define kScrollCalibrationPixels    100
+
+
+void TUCEventPoolInit(TUCEventPool *pool) {
+    memset(pool, 0, sizeof(TUCEventPool));
+
+    // stamp the reused events on the same clock a new event gets
+    CGEventRef probe = CGEventCreate(NULL);
+    uint64_t eventTime = CGEventGetTimestamp(probe);
+    uint64_t hostTime = mach_absolute_time();
+    uint64_t nanoseconds = clock_gettime_nsec_np(CLOCK_UPTIME_RAW);
+    pool->timestampIsHostTime = llabs((long long)(hostTime - eventTime)) < llabs((long long)(nanoseconds - eventTime));
+    CFRelease(probe);
+
+    // a pixel scroll also carries line and fixed point deltas, learn the factors once instead of guessing them
+    probe = CGEventCreateScrollWheelEvent2(NULL, kCGScrollEventUnitPixel, 1, kScrollCalibrationPixels, 0, 0);
+    pool->lineDeltaPerPixel = CGEventGetIntegerValueField(probe, kCGScrollWheelEventDeltaAxis1) / (double)kScrollCalibrationPixels;
+    pool->fixedPtDeltaPerPixel = CGEventGetDoubleValueField(probe, kCGScrollWheelEventFixedPtDeltaAxis1) / kScrollCalibrationPixels;
+    CFRelease(probe);
+
+    pool->numAllocations = 2;
+}
+
+
+void TUCEventPoolRelease(TUCEventPool *pool) {
+    for (int kind = 0; kind < TUCEventKindCount; kind++) {
+        if (pool->events[kind] != NULL) {
+            CFRelease(pool->events[kind]);
+            pool->events[kind] = NULL;
+        }
+    }
+}
+
+
+
+static CGEventRef CreateEvent(TUCEventKind kind) {
+    switch (kind) {
+        case TUCEventKindMouseMoved:
+            return CGEventCreateMouseEvent(NULL, kCGEventMouseMoved, CGPointZero, kCGMouseButtonLeft);
+        case TUCEventKindLeftMouseDown:
+            return CGEventCreateMouseEvent(NULL, kCGEventLeftMouseDown, CGPointZero, kCGMouseButtonLeft);
+        case TUCEventKindLeftMouseUp:
+            return CGEventCreateMouseEvent(NULL, kCGEventLeftMouseUp, CGPointZero, kCGMouseButtonLeft);
+        case TUCEventKindLeftMouseDragged:
+            return CGEventCreateMouseEvent(NULL, kCGEventLeftMouseDragged, CGPointZero, kCGMouseButtonLeft);
+        case TUCEventKindRightMouseDown:
+            return CGEventCreateMouseEvent(NULL, kCGEventRightMouseDown, CGPointZero, kCGMouseButtonRight);
+        case TUCEventKindRightMouseUp:
+            return CGEventCreateMouseEvent(NULL, kCGEventRightMouseUp, CGPointZero, kCGMouseButtonRight);
+
+        case TUCEventKindScroll:
+            return CGEventCreateScrollWheelEvent2(NULL, kCGScrollEventUnitPixel, 2, 0, 0, 0);
+
+        case TUCEventKindMagnify: {
+            CGEventRef event = CGEventCreateMouseEvent(NULL, kCGEventMouseMoved, CGPointZero, kCGMouseButtonLeft);
+            CGEventSetType(event, 29); // type gesture
+            CGEventSetFlags(event, 0);
+
+            // magic
+//            CGEventSetIntegerValueField(event, 55, 29); //if more touches on trackapd 30? about concurrent gestures???
+            CGEventSetIntegerValueField(event, 50, 248);
+            CGEventSetIntegerValueField(event, 101, 4);
+            CGEventSetIntegerValueField(event, 110, 8);
+            return event;
+        }
+
+        case TUCEventKindCount:
+            break;
+    }
+    return NULL;
+}
+
+
+/**
+ The event of this kind, created on first use and stamped with the current time.
+ */
+static CGEventRef Acquire(TUCEventPool *pool, TUCEventKind kind) {
+    CGEventRef event = pool->events[kind];
+    if (event == NULL) {
+        event = CreateEvent(kind);
+        pool->events[kind] = event;
+        pool->numAllocations++;
+    }
+
+    CGEventSetTimestamp(event, pool->timestampIsHostTime ? mach_absolute_time() : clock_gettime_nsec_np(CLOCK_UPTIME_RAW));
+    return event;
+}
+
+
+
+CGEventRef TUCEventPoolMouseEvent(TUCEventPool *pool, CGEventType type, CGPoint location, int64_t clickState) {
+    TUCEventKind kind;
+    switch (type) {
+        case kCGEventMouseMoved:        kind = TUCEventKindMouseMoved; break;
+        case kCGEventLeftMouseDown:     kind = TUCEventKindLeftMouseDown; break;
+        case kCGEventLeftMouseUp:       kind = TUCEventKindLeftMouseUp; break;
+        case kCGEventLeftMouseDragged:  kind = TUCEventKindLeftMouseDragged; break;
+        case kCGEventRightMouseDown:    kind = TUCEventKindRightMouseDown; break;
+        case kCGEventRightMouseUp:      kind = TUCEventKindRightMouseUp; break;
+        default:                        return NULL;
+    }
+
+    CGEventRef event = Acquire(pool, kind);
+    CGEventSetLocation(event, location);
+    CGEventSetIntegerValueField(event, kCGMouseEventClickState, clickState);
+    return event;
+}
+
+
+CGEventRef TUCEventPoolScrollEvent(TUCEventPool *pool, CGPoint translation) {
+    CGEventRef event = Acquire(pool, TUCEventKindScroll);
+
+    // truncated like the int32_t wheel arguments of CGEventCreateScrollWheelEvent2
+    int32_t pixelsY = (int32_t)translation.y;
+    int32_t pixelsX = (int32_t)translation.x;
+
+    CGEventSetIntegerValueField(event, kCGScrollWheelEventPointDeltaAxis1, pixelsY);
+    CGEventSetIntegerValueField(event, kCGScrollWheelEventPointDeltaAxis2, pixelsX);
+    CGEventSetIntegerValueField(event, kCGScrollWheelEventDeltaAxis1, lround(pixelsY * pool->lineDeltaPerPixel));
+    CGEventSetIntegerValueField(event, kCGScrollWheelEventDeltaAxis2, lround(pixelsX * pool->lineDeltaPerPixel));
+    CGEventSetDoubleValueField(event, kCGScrollWheelEventFixedPtDeltaAxis1, pixelsY * pool->fixedPtDeltaPerPixel);
+    CGEventSetDoubleValueField(event, kCGScrollWheelEventFixedPtDeltaAxis2, pixelsX * pool->fixedPtDeltaPerPixel);
+    return event;
+}
+
+
+CGEventRef TUCEventPoolMagnifyEvent(TUCEventPool *pool, CGPoint location, double magnification, int64_t phase) {
+    CGEventRef event = Acquire(pool, TUCEventKindMagnify);
+    CGEventSetLocation(event, location);
+
+    CGEventSetDoubleValueField(event, 113, magnification);
+    CGEventSetDoubleValueField(event, 114, magnification);
+    CGEventSetDoubleValueField(event, 116, magnification);
+    CGEventSetDoubleValueField(event, 118, magnification);
+
+    CGEventSetIntegerValueField(event, 132, phase);
+    return event;
+}
@@ -0,0 +1,70 @@
+//
+//  TUCEventPool.h
+//  Touch Up Core
+//
+//  Created by Touch Up contributors on 16.10.26.
+//
+
+#ifndef TUCEventPool_h
+#define TUCEventPool_h
+
+#include <CoreGraphics/CoreGraphics.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ Reusable events for the output path.
+
+ CGEventPost copies the event it is given, so one CGEventRef can be posted over and over. The pool keeps a pre-initialized
+ event per kind, created on its first use. A post only sets what changes (location, click state, deltas, magnification, phase)
+ and the timestamp, so a steady drag or scroll creates no events at all; `numAllocations` counts the ones that were created.
+ The events belong to the pool and stay valid until the next call for the same kind.
+ Not thread-safe, the TUCOutputScheduler only uses it while holding its lock.
+ */
+
+
+typedef enum {
+    TUCEventKindMouseMoved = 0,
+    TUCEventKindLeftMouseDown,
+    TUCEventKindLeftMouseUp,
+    TUCEventKindLeftMouseDragged,
+    TUCEventKindRightMouseDown,
+    TUCEventKindRightMouseUp,
+    TUCEventKindScroll,
+    TUCEventKindMagnify,
+    TUCEventKindCount,
+} TUCEventKind;
+
+
+typedef struct {
+    CGEventRef events[TUCEventKindCount];
+
+    bool timestampIsHostTime;       // CGEventTimestamp is mach_absolute_time on some systems, nanoseconds on others
+    double lineDeltaPerPixel;       // how CGEventCreateScrollWheelEvent2 derives the other deltas of a pixel scroll
+    double fixedPtDeltaPerPixel;
+
+    uint64_t numAllocations;
+} TUCEventPool;
+
+
+
+void TUCEventPoolInit(TUCEventPool *pool);
+
+void TUCEventPoolRelease(TUCEventPool *pool);
+
+/**
+ `type` is one of the mouse types of TUCEventKind, returns NULL for any other.
+ */
+CGEventRef TUCEventPoolMouseEvent(TUCEventPool *pool, CGEventType type, CGPoint location, int64_t clickState);
+
+/**
+ A pixel scroll, like `CGEventCreateScrollWheelEvent2(NULL, kCGScrollEventUnitPixel, 2, translation.y, translation.x, 0)`.
+ */
+CGEventRef TUCEventPoolScrollEvent(TUCEventPool *pool, CGPoint translation);
+
+/**
+ The private gesture event of a trackpad pinch. `phase` is written to field 132 as given.
+ */
+CGEventRef TUCEventPoolMagnifyEvent(TUCEventPool *pool, CGPoint location, double magnification, int64_t phase);
+
+#endif /* TUCEventPool_h */
@@ -0,0 +1,103 @@
+//
+//  TUCEventSink.h
+//  Touch Up Core
+//
+//  Created by Touch Up contributors on 16.10.26.
+//
+
+#import <Cocoa/Cocoa.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/*
+ Where the output of `TUCCursorUtilities` ends up.
+
+ The `TUCOutputScheduler` decides when an event is posted and hands it to a sink as a `TUCOutputEvent`. The default sink posts it
+ to the system. The others keep the pipeline from touching the real cursor, so it can run headless (without a display link every
+ move is posted right away), be benchmarked and be compared against a recording:
+ - TUCMemoryEventSink keeps the latest events in a ring,
+ - TUCFileEventSink writes every event to a compact binary file.
+ A sink is only called while the scheduler holds its lock, one event at a time.
+ */
+
+
+#define kTUCOutputEventMagnify      29          // type of the private gesture event of a pinch
+
+
+typedef struct {
+    uint64_t timestamp;             // ns on the mach_absolute_time timeline, when the scheduler posted it
+    uint32_t type;                  // CGEventType of a mouse event, kCGEventScrollWheel or kTUCOutputEventMagnify
+    int32_t value;                  // click state of a mouse event, NSTouchPhase of a magnification
+    double x, y;                    // location in screen coordinates, translation of a scroll
+    double magnification;
+} TUCOutputEvent;
+
+
+
+@protocol TUCEventSink <NSObject>
+
+- (void)postOutputEvent:(const TUCOutputEvent *)event;
+
+/**
+ YES if the events move the cursor of the system, only then `TUCCursorUtilities` resynchronizes its cursor model with it.
+ */
+@property (readonly) BOOL movesSystemCursor;
+
+@optional
+
+/**
+ Events the sink had to create, logged in the output report.
+ */
+@property (readonly) uint64_t numCreatedEvents;
+
+@end
+
+
+
+/**
+ Posts to the HID event tap, with the events of a `TUCEventPool`.
+ */
+@interface TUCSystemEventSink : NSObject <TUCEventSink>
+@end
+
+
+/**
+ Keeps the latest `capacity` events, for tests and benchmarks. Can be read from any thread.
+ */
+@interface TUCMemoryEventSink : NSObject <TUCEventSink>
+
+- (instancetype)initWithCapacity:(NSUInteger)capacity;
+
+@property (readonly) NSUInteger capacity;
+@property (readonly) uint64_t numPostedEvents;  // since init or the last `removeAllEvents`, including the overwritten ones
+
+/**
+ Copies the latest events, oldest first, and returns how many.
+ */
+- (NSUInteger)copyEvents:(TUCOutputEvent *)events maxCount:(NSUInteger)maxCount;
+
+- (void)removeAllEvents;
+
+@end
+
+
+/*
+ Recording format: a header of the magic "TUCE", the version and the size of a record (three uint32_t, host byte order),
+ followed by the TUCOutputEvent records as they are in memory.
+ */
+#define kTUCEventRecordingMagic     0x45435554  // "TUCE"
+#define kTUCEventRecordingVersion   1
+
+/**
+ Appends every event to a file. The writes are buffered, `close` (or dealloc) writes out the rest.
+ `close` can be called from any thread, also while the sink is still the active one: later events are ignored.
+ */
+@interface TUCFileEventSink : NSObject <TUCEventSink>
+
+- (nullable instancetype)initWithPath:(NSString *)path;
+
+- (void)close;
+
+@end
+
+NS_ASSUME_NONNULL_END
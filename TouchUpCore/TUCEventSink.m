@@ -0,0 +1,195 @@
+//
+//  TUCEventSink.m
+//  Touch Up Core
+//
+//  Created by Touch Up contributors on 16.10.26.
+//
+
+#import "TUCEventSink.h"
+
+#import <os/lock.h>
+#import <stdio.h>
+
+#import "TUCEventPool.h"
+#import "TUCLog.h"
+
+
+#pragma mark - System
+
+@interface TUCSystemEventSink () {
+    TUCEventPool _eventPool;
+}
+@end
+
+
+@implementation TUCSystemEventSink
+
+- (instancetype)init {
+    if (self = [super init]) {
+        TUCEventPoolInit(&_eventPool);
+    }
+    return self;
+}
+
+
+- (void)dealloc {
+    TUCEventPoolRelease(&_eventPool);
+}
+
+
+- (BOOL)movesSystemCursor {
+    return YES;
+}
+
+
+- (uint64_t)numCreatedEvents {
+    return _eventPool.numAllocations;
+}
+
+
+- (void)postOutputEvent:(const TUCOutputEvent *)event {
+    CGPoint point = CGPointMake(event->x, event->y);
+    CGEventRef cgEvent;
+    
+    if (event->type == kCGEventScrollWheel) {
+        cgEvent = TUCEventPoolScrollEvent(&_eventPool, point);
+    } else if (event->type == kTUCOutputEventMagnify) {
+        cgEvent = TUCEventPoolMagnifyEvent(&_eventPool, point, event->magnification, event->value);
+    } else {
+        cgEvent = TUCEventPoolMouseEvent(&_eventPool, event->type, point, event->value);
+    }
+    
+    if (cgEvent != NULL) {
+        CGEventPost(kCGHIDEventTap, cgEvent);
+    }
+}
+
+@end
+
+
+
+#pragma mark - Memory
+
+@interface TUCMemoryEventSink () {
+    os_unfair_lock _lock;
+    TUCOutputEvent *_events;
+}
+@end
+
+
+@implementation TUCMemoryEventSink
+
+- (instancetype)init {
+    return [self initWithCapacity:4096];
+}
+
+
+- (instancetype)initWithCapacity:(NSUInteger)capacity {
+    if (self = [super init]) {
+        _lock = OS_UNFAIR_LOCK_INIT;
+        _capacity = MAX(capacity, 1);
+        _events = calloc(_capacity, sizeof(TUCOutputEvent));
+    }
+    return self;
+}
+
+
+- (void)dealloc {
+    free(_events);
+}
+
+
+- (BOOL)movesSystemCursor {
+    return NO;
+}
+
+
+- (void)postOutputEvent:(const TUCOutputEvent *)event {
+    os_unfair_lock_lock(&_lock);
+    _events[_numPostedEvents % _capacity] = *event;
+    _numPostedEvents++;
+    os_unfair_lock_unlock(&_lock);
+}
+
+
+- (NSUInteger)copyEvents:(TUCOutputEvent *)events maxCount:(NSUInteger)maxCount {
+    os_unfair_lock_lock(&_lock);
+    
+    NSUInteger count = (NSUInteger)MIN(MIN(_numPostedEvents, (uint64_t)_capacity), (uint64_t)maxCount);
+    uint64_t first = _numPostedEvents - count;
+    for (NSUInteger i = 0; i < count; i++) {
+        events[i] = _events[(first + i) % _capacity];
+    }
+    
+    os_unfair_lock_unlock(&_lock);
+    return count;
+}
+
+
+- (void)removeAllEvents {
+    os_unfair_lock_lock(&_lock);
+    _numPostedEvents = 0;
+    os_unfair_lock_unlock(&_lock);
+}
+
+@end
+
+
+
+#pragma mark - File
+
+@interface TUCFileEventSink () {
+    // close may come from any thread while the scheduler posts, the lock keeps a write off a closed file
+    os_unfair_lock _lock;
+    FILE *_file;
+}
+@end
+
+
+@implementation TUCFileEventSink
+
+- (nullable instancetype)initWithPath:(NSString *)path {
+    if (self = [super init]) {
+        _lock = OS_UNFAIR_LOCK_INIT;
+        _file = fopen(path.fileSystemRepresentation, "wb");
+        if (_file == NULL) {
+            TUCLogError(Cursor, "[EventSink] cannot open recording %s", path.fileSystemRepresentation);
+            return nil;
+        }
+    
+        uint32_t header[3] = { kTUCEventRecordingMagic, kTUCEventRecordingVersion, sizeof(TUCOutputEvent) };
+        fwrite(header, sizeof(header), 1, _file);
+    }
+    return self;
+}
+
+
+- (void)dealloc {
+    [self close];
+}
+
+
+- (BOOL)movesSystemCursor {
+    return NO;
+}
+
+
+- (void)postOutputEvent:(const TUCOutputEvent *)event {
+    os_unfair_lock_lock(&_lock);
+    if (_file != NULL) {
+        fwrite(event, sizeof(TUCOutputEvent), 1, _file);
+    }
+    os_unfair_lock_unlock(&_lock);
+}
+
+
+- (void)close {
+    os_unfair_lock_lock(&_lock);
+    if (_file != NULL) {
+        fclose(_file);
+        _file = NULL;
+    }
+    os_unfair_lock_unlock(&_lock);
+}
+
+@end
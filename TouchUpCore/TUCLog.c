@@ -0,0 +1,502 @@
+//
+//  TUCLog.c
+//  Touch Up Core
+//
+//  Created by Touch Up contributors on 16.10.26.
+//
+
+#include "TUCLog.h"
+
+#include <mach/mach_time.h>
+#include <pthread.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+#include <sys/time.h>
+
+
+#define kTUCLogBufferCapacity   512         // records per thread, power of two
+#define kTUCLogMaxSites         4096
+#define kFlushInterval          20          // ms
+
+
+_Static_assert(sizeof(TUCLogRecord) == kTUCLogRecordSize, "record layout");
+_Static_assert((kTUCLogBufferCapacity & (kTUCLogBufferCapacity - 1)) == 0, "capacity must be a power of two");
+
+
+/**
+ Ring of one thread. The thread is the only producer, the flusher the only consumer.
+ When the thread exits the buffer is abandoned and handed to the next thread that logs.
+ */
+typedef struct TUCLogBuffer {
+    _Atomic uint32_t head;
+    _Atomic uint32_t tail;
+    _Atomic uint64_t numDropped;
+    _Atomic bool isAbandoned;
+    uint32_t threadID;
+    uint32_t flushHead;         // owned by the flusher, head at the time the records were collected
+
+    struct TUCLogBuffer *next;
+    TUCLogRecord records[kTUCLogBufferCapacity];
+} TUCLogBuffer;
+
+
+_Atomic uint8_t gTUCLogLevels[TUCLogCategoryCount] = {
+    TUCLogLevelInfo, TUCLogLevelInfo, TUCLogLevelInfo,
+    TUCLogLevelInfo, TUCLogLevelInfo, TUCLogLevelInfo,
+};
+
+static _Thread_local TUCLogBuffer *tBuffer = NULL;
+static pthread_key_t gBufferKey;
+static pthread_once_t gStartOnce = PTHREAD_ONCE_INIT;
+
+static _Atomic(TUCLogBuffer *) gBuffers = NULL;
+
+static pthread_mutex_t gRegisterLock = PTHREAD_MUTEX_INITIALIZER;
+static TUCLogSite *gSites[kTUCLogMaxSites];
+static uint16_t gNumSites = 0;
+
+static _Atomic bool gEchoToConsole = true;
+static _Atomic uint64_t gNumDropped = 0;
+
+// flusher, everything below is guarded by gFlushLock
+static pthread_mutex_t gFlushLock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t gFlushCondition = PTHREAD_COND_INITIALIZER;
+static FILE *gFile = NULL;
+static bool gIsSiteWritten[kTUCLogMaxSites];
+
+typedef struct {
+    const TUCLogRecord *record;
+    uint32_t order;
+} PendingRecord;
+
+static PendingRecord *gPending = NULL;
+static size_t gPendingCapacity = 0;
+
+
+
+#pragma mark - Flusher
+
+static void WriteSite(uint16_t id) {
+    TUCLogSite *site = gSites[id];
+    size_t length = strlen(site->format);
+
+    TUCLogSiteEntry entry = {
+        .id = id,
+        .level = site->level,
+        .category = site->category,
+        .formatLength = (uint16_t)(length < UINT16_MAX ? length : UINT16_MAX),
+    };
+
+    fputc(TUCLogEntrySite, gFile);
+    fwrite(&entry, sizeof(entry), 1, gFile);
+    fwrite(site->format, 1, entry.formatLength, gFile);
+
+    gIsSiteWritten[id] = true;
+}
+
+
+
+static void WriteRecord(const TUCLogRecord *record) {
+    if (!gIsSiteWritten[record->siteID]) {
+        WriteSite(record->siteID);
+    }
+
+    fputc(TUCLogEntryRecord, gFile);
+    fwrite(record, 1, kTUCLogRecordHeaderSize + record->payloadSize, gFile);
+
+    if (atomic_load_explicit(&gEchoToConsole, memory_order_relaxed)) {
+        char text[512];
+        TUCLogFormatPayload(text, sizeof(text), gSites[record->siteID]->format, record->payload, record->payloadSize);
+        printf("%s%s\n", text, (record->flags & kTUCLogRecordTruncated) ? " <truncated>" : "");
+    }
+}
+
+
+
+static void WriteDropped(uint32_t threadID, uint64_t count) {
+    TUCLogDroppedEntry entry = {
+        .threadID = threadID,
+        .time = mach_absolute_time(),
+        .count = count,
+    };
+
+    fputc(TUCLogEntryDropped, gFile);
+    fwrite(&entry, sizeof(entry), 1, gFile);
+
+    if (atomic_load_explicit(&gEchoToConsole, memory_order_relaxed)) {
+        printf("[TUCLog] %llu records of thread %u dropped\n", (unsigned long long)count, threadID);
+    }
+}
+
+
+
+static int ComparePending(const void *a, const void *b) {
+    const PendingRecord *first = a;
+    const PendingRecord *second = b;
+
+    if (first->record->time != second->record->time) {
+        return first->record->time < second->record->time ? -1 : 1;
+    }
+    // keeps the order within a thread
+    return first->order < second->order ? -1 : (first->order > second->order);
+}
+
+
+
+/**
+ Moves everything the threads have logged so far into the file, in time order. Called with gFlushLock held.
+ */
+static void FlushBuffers(void) {
+    size_t numPending = 0;
+
+    for (TUCLogBuffer *buffer = atomic_load_explicit(&gBuffers, memory_order_acquire); buffer; buffer = buffer->next) {
+        uint32_t tail = atomic_load_explicit(&buffer->tail, memory_order_relaxed);
+        uint32_t head = atomic_load_explicit(&buffer->head, memory_order_acquire);
+        buffer->flushHead = tail;
+
+        if (numPending + (head - tail) > gPendingCapacity) {
+            size_t capacity = gPendingCapacity * 2 + kTUCLogBufferCapacity;
+            PendingRecord *pending = realloc(gPending, capacity * sizeof(PendingRecord));
+            if (!pending) {
+                continue;
+            }
+            gPending = pending;
+            gPendingCapacity = capacity;
+        }
+        buffer->flushHead = head;
+
+        for (uint32_t i = tail; i != head; i++) {
+            gPending[numPending].record = &buffer->records[i & (kTUCLogBufferCapacity - 1)];
+            gPending[numPending].order = (uint32_t)numPending;
+            numPending++;
+        }
+    }
+
+    qsort(gPending, numPending, sizeof(PendingRecord), ComparePending);
+
+    for (size_t i = 0; i < numPending; i++) {
+        WriteRecord(gPending[i].record);
+    }
+
+    // hand the slots back
+    for (TUCLogBuffer *buffer = atomic_load_explicit(&gBuffers, memory_order_acquire); buffer; buffer = buffer->next) {
+        atomic_store_explicit(&buffer->tail, buffer->flushHead, memory_order_release);
+
+        uint64_t numDropped = atomic_exchange_explicit(&buffer->numDropped, 0, memory_order_relaxed);
+        if (numDropped > 0) {
+            WriteDropped(buffer->threadID, numDropped);
+        }
+    }
+
+    fflush(gFile);
+    if (atomic_load_explicit(&gEchoToConsole, memory_order_relaxed)) {
+        fflush(stdout);
+    }
+}
+
+
+
+static void *FlusherMain(void *argument) {
+    pthread_setname_np("de.schafe.TouchUp.log");
+
+    pthread_mutex_lock(&gFlushLock);
+
+    while (true) {
+        struct timeval now;
+        gettimeofday(&now, NULL);
+
+        long nanoseconds = now.tv_usec * 1000 + kFlushInterval * 1000000L;
+        struct timespec deadline = {
+            .tv_sec = now.tv_sec + nanoseconds / 1000000000L,
+            .tv_nsec = nanoseconds % 1000000000L,
+        };
+        pthread_cond_timedwait(&gFlushCondition, &gFlushLock, &deadline);
+
+        FlushBuffers();
+    }
+
+    return NULL;
+}
+
+
+
+#pragma mark - Setup
+
+static void AbandonBuffer(void *value) {
+    TUCLogBuffer *buffer = value;
+    atomic_store_explicit(&buffer->isAbandoned, true, memory_order_release);
+}
+
+
+
+static void Start(void) {
+    pthread_key_create(&gBufferKey, AbandonBuffer);
+
+    gFile = fopen(kTUCLogPath, "wb");
+    if (!gFile) {
+        return;
+    }
+
+    mach_timebase_info_data_t timebase;
+    mach_timebase_info(&timebase);
+
+    TUCLogFileHeader header = {
+        .timebaseNumer = timebase.numer,
+        .timebaseDenom = timebase.denom,
+    };
+    memcpy(header.magic, kTUCLogFileMagic, sizeof(header.magic));
+    fwrite(&header, sizeof(header), 1, gFile);
+
+    pthread_t thread;
+    if (pthread_create(&thread, NULL, FlusherMain, NULL) == 0) {
+        pthread_detach(thread);
+    }
+
+    atexit(TUCLogFlush);
+}
+
+
+
+static TUCLogBuffer *CreateThreadBuffer(void) {
+    pthread_once(&gStartOnce, Start);
+    if (!gFile) {
+        return NULL;
+    }
+
+    TUCLogBuffer *buffer = NULL;
+
+    // reuse the buffer of a thread that has exited
+    for (TUCLogBuffer *candidate = atomic_load_explicit(&gBuffers, memory_order_acquire); candidate; candidate = candidate->next) {
+        bool expected = true;
+        if (atomic_compare_exchange_strong_explicit(&candidate->isAbandoned, &expected, false,
+                                                    memory_order_acquire, memory_order_relaxed)) {
+            buffer = candidate;
+            break;
+        }
+    }
+
+    if (!buffer) {
+        buffer = calloc(1, sizeof(TUCLogBuffer));
+        if (!buffer) {
+            return NULL;
+        }
+
+        TUCLogBuffer *first = atomic_load_explicit(&gBuffers, memory_order_relaxed);
+        do {
+            buffer->next = first;
+        } while (!atomic_compare_exchange_weak_explicit(&gBuffers, &first, buffer,
+                                                        memory_order_release, memory_order_relaxed));
+    }
+
+    buffer->threadID = pthread_mach_thread_np(pthread_self());
+    pthread_setspecific(gBufferKey, buffer);
+    tBuffer = buffer;
+
+    return buffer;
+}
+
+
+
+static uint16_t RegisterSite(TUCLogSite *site) {
+    pthread_mutex_lock(&gRegisterLock);
+
+    uint16_t id = atomic_load_explicit(&site->id, memory_order_relaxed);
+    if (id == 0 && gNumSites + 1 < kTUCLogMaxSites) {
+        site->numArguments = TUCLogParseFormat(site->format, site->arguments);
+
+        id = ++gNumSites;
+        gSites[id] = site;
+        atomic_store_explicit(&site->id, id, memory_order_release);
+    }
+
+    pthread_mutex_unlock(&gRegisterLock);
+    return id;
+}
+
+
+
+#pragma mark - Logging
+
+/**
+ Copies the arguments into the payload as described by the parsed format.
+ */
+static uint8_t EncodeArguments(const TUCLogSite *site, uint8_t *payload, uint8_t *flags, va_list arguments) {
+    size_t position = 0;
+
+    for (uint8_t i = 0; i < site->numArguments; i++) {
+        uint8_t argument = site->arguments[i];
+        TUCLogArgumentLength length = TUCLogArgumentGetLength(argument);
+        uint64_t bits = 0;
+
+        switch (TUCLogArgumentGetKind(argument)) {
+            case TUCLogArgumentString: {
+                const char *string = va_arg(arguments, const char *);
+                if (!string) {
+                    string = "(null)";
+                }
+                if (position + 1 > kTUCLogPayloadSize) {
+                    *flags |= kTUCLogRecordTruncated;
+                    return (uint8_t)position;
+                }
+
+                // leave room for the arguments behind the string
+                size_t space = kTUCLogPayloadSize - position - 1;
+                size_t reserved = (size_t)(site->numArguments - i - 1) * sizeof(uint64_t);
+                space = space > reserved ? space - reserved : 0;
+
+                size_t stringLength = strnlen(string, space + 1);
+                if (stringLength > space) {
+                    stringLength = space;
+                    *flags |= kTUCLogRecordTruncated;
+                }
+
+                payload[position] = (uint8_t)stringLength;
+                memcpy(payload + position + 1, string, stringLength);
+                position += 1 + stringLength;
+                continue;
+            }
+
+            case TUCLogArgumentDouble: {
+                double number = va_arg(arguments, double);
+                memcpy(&bits, &number, sizeof(bits));
+                break;
+            }
+
+            case TUCLogArgumentPointer:
+                bits = (uintptr_t)va_arg(arguments, void *);
+                break;
+
+            case TUCLogArgumentInt:
+                switch (length) {
+                    case TUCLogLengthDefault:  bits = (uint64_t)(int64_t)va_arg(arguments, int); break;
+                    case TUCLogLengthLong:     bits = (uint64_t)(int64_t)va_arg(arguments, long); break;
+                    case TUCLogLengthLongLong: bits = (uint64_t)(int64_t)va_arg(arguments, long long); break;
+                    case TUCLogLengthIntMax:   bits = (uint64_t)(int64_t)va_arg(arguments, intmax_t); break;
+                    case TUCLogLengthSize:     bits = (uint64_t)va_arg(arguments, size_t); break;
+                    case TUCLogLengthPtrDiff:  bits = (uint64_t)(int64_t)va_arg(arguments, ptrdiff_t); break;
+                }
+                break;
+
+            case TUCLogArgumentUnsigned:
+                switch (length) {
+                    case TUCLogLengthDefault:  bits = va_arg(arguments, unsigned int); break;
+                    case TUCLogLengthLong:     bits = va_arg(arguments, unsigned long); break;
+                    case TUCLogLengthLongLong: bits = va_arg(arguments, unsigned long long); break;
+                    case TUCLogLengthIntMax:   bits = va_arg(arguments, uintmax_t); break;
+                    case TUCLogLengthSize:     bits = va_arg(arguments, size_t); break;
+                    case TUCLogLengthPtrDiff:  bits = (uint64_t)va_arg(arguments, ptrdiff_t); break;
+                }
+                break;
+        }
+
+        if (position + sizeof(bits) > kTUCLogPayloadSize) {
+            *flags |= kTUCLogRecordTruncated;
+            return (uint8_t)position;
+        }
+        memcpy(payload + position, &bits, sizeof(bits));
+        position += sizeof(bits);
+    }
+
+    return (uint8_t)position;
+}
+
+
+
+void TUCLogWrite(TUCLogSite *site, ...) {
+    TUCLogBuffer *buffer = tBuffer;
+    if (!buffer) {
+        buffer = CreateThreadBuffer();
+        if (!buffer) {
+            return;
+        }
+    }
+
+    uint16_t id = atomic_load_explicit(&site->id, memory_order_acquire);
+    if (id == 0) {
+        id = RegisterSite(site);
+        if (id == 0) {
+            return;
+        }
+    }
+
+    uint32_t head = atomic_load_explicit(&buffer->head, memory_order_relaxed);
+    uint32_t tail = atomic_load_explicit(&buffer->tail, memory_order_acquire);
+
+    if (head - tail >= kTUCLogBufferCapacity) {
+        atomic_fetch_add_explicit(&buffer->numDropped, 1, memory_order_relaxed);
+        atomic_fetch_add_explicit(&gNumDropped, 1, memory_order_relaxed);
+        return;
+    }
+
+    TUCLogRecord *record = &buffer->records[head & (kTUCLogBufferCapacity - 1)];
+    record->siteID = id;
+    record->flags = 0;
+    record->threadID = buffer->threadID;
+    record->time = mach_absolute_time();
+
+    va_list arguments;
+    va_start(arguments, site);
+    record->payloadSize = EncodeArguments(site, record->payload, &record->flags, arguments);
+    va_end(arguments);
+
+    atomic_store_explicit(&buffer->head, head + 1, memory_order_release);
+}
+
+
+
+#pragma mark - Configuration
+
+void TUCLogSetLevel(TUCLogCategory category, TUCLogLevel level) {
+    if (category < TUCLogCategoryCount) {
+        atomic_store_explicit(&gTUCLogLevels[category], (uint8_t)level, memory_order_relaxed);
+    }
+}
+
+
+void TUCLogSetLevelForAllCategories(TUCLogLevel level) {
+    for (int category = 0; category < TUCLogCategoryCount; category++) {
+        TUCLogSetLevel(category, level);
+    }
+}
+
+
+
+void TUCLogConfigureFromEnvironment(void) {
+    const char *value = getenv("TOUCHUP_LOG_LEVEL");
+    if (!value) {
+        return;
+    }
+
+    static const char *Names[] = { "trace", "debug", "info", "warning", "error", "off" };
+
+    for (int level = TUCLogLevelTrace; level <= TUCLogLevelOff; level++) {
+        if (strcasecmp(value, Names[level]) == 0) {
+            TUCLogSetLevelForAllCategories(level);
+            return;
+        }
+    }
+}
+
+
+
+void TUCLogSetEchoToConsole(bool echo) {
+    atomic_store_explicit(&gEchoToConsole, echo, memory_order_relaxed);
+}
+
+
+
+void TUCLogFlush(void) {
+    pthread_mutex_lock(&gFlushLock);
+    if (gFile) {
+        FlushBuffers();
+    }
+    pthread_mutex_unlock(&gFlushLock);
+}
+
+
+
+uint64_t TUCLogGetNumDropped(void) {
+    return atomic_load_explicit(&gNumDropped, memory_order_relaxed);
+}
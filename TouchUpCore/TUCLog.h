@@ -0,0 +1,140 @@
+//
+//  TUCLog.h
+//  Touch Up Core
+//
+//  Created by Touch Up contributors on 16.10.26.
+//
+
+#ifndef TUCLog_h
+#define TUCLog_h
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+
+#include "TUCLogFormat.h"
+
+/*
+ Asynchronous binary logger for the input path.
+
+ A log call does not format, lock or write anything. It copies the id of its call site, a timestamp and the raw
+ arguments into a fixed size record in a ring of the calling thread. A background thread collects the records of all
+ threads in time order and writes them to kTUCLogPath, together with the format string of every call site on its
+ first use. Tools/tuclog-decode.c turns such a file into text. If the echo is on, the background thread also prints
+ the formatted records to stdout.
+
+ Calls below TUC_LOG_COMPILE_LEVEL are removed by the compiler. The others cost one relaxed load and a compare
+ while their category is set to a higher level. If a ring is full the record is dropped and counted, the caller never waits.
+ */
+
+
+#define kTUCLogPath     "/tmp/touchup.tuclog"
+
+
+typedef enum {
+    TUCLogLevelTrace = 0,
+    TUCLogLevelDebug,
+    TUCLogLevelInfo,
+    TUCLogLevelWarning,
+    TUCLogLevelError,
+    TUCLogLevelOff,
+} TUCLogLevel;
+
+typedef enum {
+    TUCLogCategoryHID = 0,      // device setup, queues, reports
+    TUCLogCategoryFrame,        // contacts and frames
+    TUCLogCategoryTouch,        // touch lifecycle
+    TUCLogCategoryGesture,
+    TUCLogCategoryCursor,
+    TUCLogCategoryScreen,
+    TUCLogCategoryCount,
+} TUCLogCategory;
+
+
+#ifndef TUC_LOG_COMPILE_LEVEL
+#if DEBUG
+#define TUC_LOG_COMPILE_LEVEL TUCLogLevelDebug
+#else
+#define TUC_LOG_COMPILE_LEVEL TUCLogLevelInfo
+#endif
+#endif
+
+
+
+/**
+ One per call site, created by the macros. Registered on its first record.
+ */
+typedef struct {
+    const char *format;
+    uint8_t level;
+    uint8_t category;
+    _Atomic uint16_t id;        // 0 until registered
+
+    uint8_t numArguments;
+    uint8_t arguments[kTUCLogMaxArguments];
+} TUCLogSite;
+
+
+extern _Atomic uint8_t gTUCLogLevels[TUCLogCategoryCount];
+
+
+#define TUCLogIsEnabled(lvl, cat) \
+    ((lvl) >= TUC_LOG_COMPILE_LEVEL && (lvl) >= atomic_load_explicit(&gTUCLogLevels[cat], memory_order_relaxed))
+
+/**
+ Logs a printf style message, see TUCLogFormat.h for the supported conversions. Strings are copied into the record
+ and truncated if they do not fit. The format must be a string literal. The printf in the dead branch only lets the
+ compiler check the arguments.
+ */
+#define TUC_LOG(lvl, cat, fmt, ...) do { \
+    if (TUCLogIsEnabled(lvl, cat)) { \
+        static TUCLogSite tucLogSite = { fmt, lvl, cat, 0, 0, {0} }; \
+        TUCLogWrite(&tucLogSite, ##__VA_ARGS__); \
+    } \
+    if (0) { \
+        printf(fmt, ##__VA_ARGS__); \
+    } \
+} while (0)
+
+#define TUCLogTrace(cat, fmt, ...)   TUC_LOG(TUCLogLevelTrace,   TUCLogCategory##cat, fmt, ##__VA_ARGS__)
+#define TUCLogDebug(cat, fmt, ...)   TUC_LOG(TUCLogLevelDebug,   TUCLogCategory##cat, fmt, ##__VA_ARGS__)
+#define TUCLogInfo(cat, fmt, ...)    TUC_LOG(TUCLogLevelInfo,    TUCLogCategory##cat, fmt, ##__VA_ARGS__)
+#define TUCLogWarning(cat, fmt, ...) TUC_LOG(TUCLogLevelWarning, TUCLogCategory##cat, fmt, ##__VA_ARGS__)
+#define TUCLogError(cat, fmt, ...)   TUC_LOG(TUCLogLevelError,   TUCLogCategory##cat, fmt, ##__VA_ARGS__)
+
+
+
+/**
+ Copies one record into the ring of the calling thread. Use the macros instead.
+ */
+void TUCLogWrite(TUCLogSite *site, ...);
+
+/**
+ Lowest level that is recorded for a category, TUCLogLevelInfo by default.
+ Levels below TUC_LOG_COMPILE_LEVEL cannot be enabled at runtime.
+ */
+void TUCLogSetLevel(TUCLogCategory category, TUCLogLevel level);
+void TUCLogSetLevelForAllCategories(TUCLogLevel level);
+
+/**
+ Reads TOUCHUP_LOG_LEVEL (trace, debug, info, warning, error, off) from the environment, if set.
+ */
+void TUCLogConfigureFromEnvironment(void);
+
+/**
+ Whether the background thread prints the records to stdout as well. On by default.
+ */
+void TUCLogSetEchoToConsole(bool echo);
+
+/**
+ Writes all records logged so far and waits until they are in the file.
+ */
+void TUCLogFlush(void);
+
+/**
+ Number of records dropped because a ring was full.
+ */
+uint64_t TUCLogGetNumDropped(void);
+
+#endif /* TUCLog_h */
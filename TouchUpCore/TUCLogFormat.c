@@ -0,0 +1,199 @@
+//
+//  TUCLogFormat.c
+//  Touch Up Core
+//
+//  Created by Touch Up contributors on 16.10.26.
+//
+
+#include "TUCLogFormat.h"
+
+#include <stdio.h>
+#include <string.h>
+
+
+bool TUCLogNextConversion(const char *format, size_t *offset, size_t *specStart, size_t *specLength, uint8_t *argument) {
+    size_t i = *offset;
+
+    while (format[i] != '\0') {
+        if (format[i] != '%') {
+            i++;
+            continue;
+        }
+
+        size_t start = i++;
+        if (format[i] == '%') {
+            i++;
+            continue;
+        }
+
+        // flags, width, precision
+        while (format[i] != '\0' && strchr("-+ #0123456789.'", format[i])) {
+            i++;
+        }
+
+        TUCLogArgumentLength length = TUCLogLengthDefault;
+        switch (format[i]) {
+            case 'h':
+                i += (format[i + 1] == 'h') ? 2 : 1;
+                break;
+            case 'l':
+                if (format[i + 1] == 'l') {
+                    length = TUCLogLengthLongLong;
+                    i += 2;
+                } else {
+                    length = TUCLogLengthLong;
+                    i++;
+                }
+                break;
+            case 'q': length = TUCLogLengthLongLong; i++; break;
+            case 'j': length = TUCLogLengthIntMax;   i++; break;
+            case 'z': length = TUCLogLengthSize;     i++; break;
+            case 't': length = TUCLogLengthPtrDiff;  i++; break;
+        }
+
+        TUCLogArgumentKind kind;
+        switch (format[i]) {
+            case 'd': case 'i': case 'c':
+                kind = TUCLogArgumentInt;
+                break;
+            case 'u': case 'o': case 'x': case 'X':
+                kind = TUCLogArgumentUnsigned;
+                break;
+            case 'f': case 'F': case 'e': case 'E': case 'g': case 'G': case 'a': case 'A':
+                kind = TUCLogArgumentDouble;
+                break;
+            case 's':
+                kind = TUCLogArgumentString;
+                break;
+            case 'p':
+                kind = TUCLogArgumentPointer;
+                break;
+            default:
+                // not a conversion we know, print it as text
+                continue;
+        }
+        i++;
+
+        *offset = i;
+        *specStart = start;
+        *specLength = i - start;
+        *argument = TUCLogArgumentMake(kind, length);
+        return true;
+    }
+
+    *offset = i;
+    return false;
+}
+
+
+
+uint8_t TUCLogParseFormat(const char *format, uint8_t *arguments) {
+    size_t offset = 0, specStart, specLength;
+    uint8_t argument;
+    uint8_t count = 0;
+
+    while (count < kTUCLogMaxArguments && TUCLogNextConversion(format, &offset, &specStart, &specLength, &argument)) {
+        arguments[count++] = argument;
+    }
+    return count;
+}
+
+
+
+/**
+ Appends `length` characters of `text` to the output, `%%` becomes `%`.
+ */
+static void AppendText(char *out, size_t outSize, size_t *used, const char *text, size_t length) {
+    for (size_t i = 0; i < length && *used + 1 < outSize; i++) {
+        if (text[i] == '%' && i + 1 < length && text[i + 1] == '%') {
+            i++;
+        }
+        out[(*used)++] = text[i];
+    }
+    out[*used] = '\0';
+}
+
+
+
+void TUCLogFormatPayload(char *out, size_t outSize, const char *format, const uint8_t *payload, size_t payloadSize) {
+    if (outSize == 0) {
+        return;
+    }
+    out[0] = '\0';
+
+    size_t used = 0;
+    size_t offset = 0, literalStart = 0;
+    size_t specStart, specLength;
+    uint8_t argument;
+    size_t position = 0;
+
+    while (TUCLogNextConversion(format, &offset, &specStart, &specLength, &argument)) {
+        AppendText(out, outSize, &used, format + literalStart, specStart - literalStart);
+        literalStart = offset;
+
+        char spec[32];
+        if (specLength >= sizeof(spec)) {
+            continue;
+        }
+        memcpy(spec, format + specStart, specLength);
+        spec[specLength] = '\0';
+
+        char value[256];
+        TUCLogArgumentKind kind = TUCLogArgumentGetKind(argument);
+
+        if (kind == TUCLogArgumentString) {
+            if (position + 1 > payloadSize || position + 1 + payload[position] > payloadSize) {
+                snprintf(value, sizeof(value), "<?>");
+                position = payloadSize;
+            } else {
+                char string[256];
+                uint8_t stringLength = payload[position];
+                memcpy(string, payload + position + 1, stringLength);
+                string[stringLength] = '\0';
+                snprintf(value, sizeof(value), spec, string);
+                position += 1 + stringLength;
+            }
+
+        } else if (position + 8 > payloadSize) {
+            snprintf(value, sizeof(value), "<?>");
+            position = payloadSize;
+
+        } else {
+            uint64_t bits;
+            memcpy(&bits, payload + position, sizeof(bits));
+            position += 8;
+
+            switch (kind) {
+                case TUCLogArgumentDouble: {
+                    double number;
+                    memcpy(&number, &bits, sizeof(number));
+                    snprintf(value, sizeof(value), spec, number);
+                    break;
+                }
+                case TUCLogArgumentPointer:
+                    snprintf(value, sizeof(value), spec, (void *)(uintptr_t)bits);
+                    break;
+
+                default:
+                    // the stored value has 64 bits, it is passed in the type the length modifier asks for
+                    switch (TUCLogArgumentGetLength(argument)) {
+                        case TUCLogLengthDefault:  snprintf(value, sizeof(value), spec, (int)bits); break;
+                        case TUCLogLengthLong:     snprintf(value, sizeof(value), spec, (long)bits); break;
+                        case TUCLogLengthLongLong: snprintf(value, sizeof(value), spec, (long long)bits); break;
+                        case TUCLogLengthIntMax:   snprintf(value, sizeof(value), spec, (intmax_t)bits); break;
+                        case TUCLogLengthSize:     snprintf(value, sizeof(value), spec, (size_t)bits); break;
+                        case TUCLogLengthPtrDiff:  snprintf(value, sizeof(value), spec, (ptrdiff_t)bits); break;
+                    }
+                    break;
+            }
+        }
+
+        size_t valueLength = strlen(value);
+        for (size_t i = 0; i < valueLength && used + 1 < outSize; i++) {
+            out[used++] = value[i];
+        }
+        out[used] = '\0';
+    }
+
+    AppendText(out, outSize, &used, format + literalStart, strlen(format + literalStart));
+}
@@ -0,0 +1,125 @@
+//
+//  TUCLogFormat.h
+//  Touch Up Core
+//
+//  Created by Touch Up contributors on 16.10.26.
+//
+
+#ifndef TUCLogFormat_h
+#define TUCLogFormat_h
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/*
+ printf format strings as used by TUCLog: which arguments a format takes, and how the arguments of a binary record are
+ formatted into text again. Shared by the logger (its console echo) and the offline decoder Tools/tuclog-decode.c,
+ so this file only depends on the C library.
+
+ Supported are the conversions d i u o x X c f F e E g G a A s p with the length modifiers hh h l ll q j z t.
+ A `*` width or precision is not supported.
+ */
+
+
+#define kTUCLogMaxArguments 16
+
+
+typedef enum {
+    TUCLogArgumentInt = 1,
+    TUCLogArgumentUnsigned,
+    TUCLogArgumentDouble,
+    TUCLogArgumentString,       // stored inline: 1 byte length + characters, truncated to fit the record
+    TUCLogArgumentPointer,
+} TUCLogArgumentKind;
+
+typedef enum {
+    TUCLogLengthDefault = 0,    // int, also for hh and h (promoted)
+    TUCLogLengthLong,
+    TUCLogLengthLongLong,
+    TUCLogLengthIntMax,
+    TUCLogLengthSize,
+    TUCLogLengthPtrDiff,
+} TUCLogArgumentLength;
+
+// kind in the low nibble, length in the high nibble
+#define TUCLogArgumentMake(kind, length)  ((uint8_t)((kind) | ((length) << 4)))
+#define TUCLogArgumentGetKind(argument)   ((TUCLogArgumentKind)((argument) & 0x0F))
+#define TUCLogArgumentGetLength(argument) ((TUCLogArgumentLength)((argument) >> 4))
+
+
+
+#pragma mark - File
+
+/*
+ A log file starts with TUCLogFileHeader, followed by entries of one tag byte and the struct for that tag:
+   'S'  TUCLogSiteEntry and formatLength characters, before the first record of that call site
+   'R'  the first kTUCLogRecordHeaderSize bytes of a TUCLogRecord and payloadSize bytes of payload
+   'D'  TUCLogDroppedEntry
+ All numbers in host byte order.
+ */
+
+#define kTUCLogFileMagic            "TUCLOG01"
+#define kTUCLogRecordSize           128
+#define kTUCLogRecordHeaderSize     16
+#define kTUCLogPayloadSize          (kTUCLogRecordSize - kTUCLogRecordHeaderSize)
+
+#define kTUCLogRecordTruncated      0x01        // flag: not all arguments fit into the payload
+
+typedef enum {
+    TUCLogEntrySite     = 'S',
+    TUCLogEntryRecord   = 'R',
+    TUCLogEntryDropped  = 'D',
+} TUCLogEntryTag;
+
+typedef struct {
+    char     magic[8];
+    uint32_t timebaseNumer;     // mach_timebase_info, time × numer / denom = ns
+    uint32_t timebaseDenom;
+} TUCLogFileHeader;
+
+typedef struct {
+    uint16_t id;
+    uint8_t  level;
+    uint8_t  category;
+    uint16_t formatLength;
+} TUCLogSiteEntry;
+
+typedef struct {
+    uint16_t siteID;
+    uint8_t  payloadSize;
+    uint8_t  flags;
+    uint32_t threadID;
+    uint64_t time;              // mach_absolute_time
+    uint8_t  payload[kTUCLogPayloadSize];
+} TUCLogRecord;
+
+typedef struct {
+    uint32_t threadID;
+    uint32_t reserved;
+    uint64_t time;
+    uint64_t count;             // records of this thread lost since the last entry
+} TUCLogDroppedEntry;
+
+
+
+/**
+ Finds the next conversion in `format` at or after `*offset`. `%%` is skipped.
+ On return `*specStart` and `*specLength` describe the conversion including the `%`, `*offset` points behind it.
+ Returns false if there is no further conversion.
+ */
+bool TUCLogNextConversion(const char *format, size_t *offset, size_t *specStart, size_t *specLength, uint8_t *argument);
+
+/**
+ Parses the arguments a format takes into `arguments` (see TUCLogArgumentMake). Returns their number,
+ at most kTUCLogMaxArguments.
+ */
+uint8_t TUCLogParseFormat(const char *format, uint8_t *arguments);
+
+/**
+ Formats the encoded arguments in `payload` with `format` into `out`, which is always terminated.
+ Arguments missing from a truncated payload are printed as `<?>`.
+ */
+void TUCLogFormatPayload(char *out, size_t outSize, const char *format, const uint8_t *payload, size_t payloadSize);
+
+#endif /* TUCLogFormat_h */
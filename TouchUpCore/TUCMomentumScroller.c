@@ -0,0 +1,125 @@
+//
+//  TUCMomentumScroller.c
+//  Touch Up Core
+//
+//  Created by Touch Up contributors on 16.10.26.
+//
+
+#include "TUCMomentumScroller.h"
+
+#include <math.h>
+#include <string.h>
+
+
+void TUCMomentumScrollerInit(TUCMomentumScroller *scroller) {
+    memset(scroller, 0, sizeof(TUCMomentumScroller));
+}
+
+
+void TUCMomentumScrollerCancel(TUCMomentumScroller *scroller) {
+    scroller->isCoasting = false;
+}
+
+
+
+void TUCMomentumScrollerAddSample(TUCMomentumScroller *scroller, double dx, double dy, double time) {
+    scroller->isCoasting = false;
+
+    scroller->positionX += dx;
+    scroller->positionY += dy;
+
+    int i = scroller->next;
+    scroller->time[i] = time;
+    scroller->x[i] = scroller->positionX;
+    scroller->y[i] = scroller->positionY;
+
+    scroller->next = (i + 1) % TUC_MOMENTUM_SCROLLER_CAPACITY;
+    if (scroller->numSamples < TUC_MOMENTUM_SCROLLER_CAPACITY) {
+        scroller->numSamples++;
+    }
+}
+
+
+bool TUCMomentumScrollerRelease(TUCMomentumScroller *scroller, double time) {
+    // least-squares slope over the samples of the last moments before the release
+    double sumT = 0, sumX = 0, sumY = 0;
+    int count = 0;
+    for (int k = 0; k < scroller->numSamples; k++) {
+        if (time - scroller->time[k] <= kTUCMomentumScrollerMaxSampleAge) {
+            sumT += scroller->time[k];
+            sumX += scroller->x[k];
+            sumY += scroller->y[k];
+            count++;
+        }
+    }
+
+    double vx = 0, vy = 0;
+    if (count >= 2) {
+        double meanT = sumT / count;
+        double meanX = sumX / count;
+        double meanY = sumY / count;
+        double sumTT = 0, sumTX = 0, sumTY = 0;
+
+        for (int k = 0; k < scroller->numSamples; k++) {
+            if (time - scroller->time[k] <= kTUCMomentumScrollerMaxSampleAge) {
+                double t = scroller->time[k] - meanT;
+                sumTT += t * t;
+                sumTX += t * (scroller->x[k] - meanX);
+                sumTY += t * (scroller->y[k] - meanY);
+            }
+        }
+
+        // all samples of the same frame tell nothing about the speed
+        if (sumTT > 0) {
+            vx = sumTX / sumTT;
+            vy = sumTY / sumTT;
+        }
+    }
+
+    scroller->numSamples = 0;
+    scroller->next = 0;
+
+    scroller->isCoasting = sqrt(vx * vx + vy * vy) >= kTUCMomentumScrollerMinSpeed;
+    scroller->vx = vx;
+    scroller->vy = vy;
+    scroller->stepTime = time;
+    scroller->remainderX = 0;
+    scroller->remainderY = 0;
+    return scroller->isCoasting;
+}
+
+
+
+bool TUCMomentumScrollerStep(TUCMomentumScroller *scroller, double time, double *dx, double *dy) {
+    *dx = 0;
+    *dy = 0;
+
+    if (!scroller->isCoasting) {
+        return false;
+    }
+
+    double dt = time - scroller->stepTime;
+    if (dt <= 0) {
+        return true;
+    }
+
+    // v(t) = v0 * e^(-t/tau), the distance is its integral over the frame
+    double decay = exp(-dt / kTUCMomentumScrollerTimeConstant);
+    double distance = kTUCMomentumScrollerTimeConstant * (1 - decay);
+
+    scroller->remainderX += scroller->vx * distance;
+    scroller->remainderY += scroller->vy * distance;
+    scroller->vx *= decay;
+    scroller->vy *= decay;
+    scroller->stepTime = time;
+
+    *dx = trunc(scroller->remainderX);
+    *dy = trunc(scroller->remainderY);
+    scroller->remainderX -= *dx;
+    scroller->remainderY -= *dy;
+
+    if (sqrt(scroller->vx * scroller->vx + scroller->vy * scroller->vy) < kTUCMomentumScrollerMinSpeed) {
+        scroller->isCoasting = false;
+    }
+    return true;
+}
@@ -0,0 +1,71 @@
+//
+//  TUCMomentumScroller.h
+//  Touch Up Core
+//
+//  Created by Touch Up contributors on 16.10.26.
+//
+
+#ifndef TUCMomentumScroller_h
+#define TUCMomentumScroller_h
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ Momentum of a scroll after the fingers were lifted.
+
+ While the fingers scroll, every translation is recorded with the sample time of its touch. On release, the velocity is the
+ slope of a least-squares line through the recent samples, so a single short or long step (the digitizer does not report at an
+ even rate) does not decide it. The momentum then decays exponentially in time, not per step: the distance between two frames
+ is the integral of the velocity between their times, so the scroll travels the same way at any frame or digitizer rate.
+ Scroll events only carry whole pixels, the fractions are carried over to the next frame instead of being lost.
+ Translations are pixels, times are seconds on the host timeline. Like the decoder, this file does not depend on AppKit.
+ */
+
+
+#define TUC_MOMENTUM_SCROLLER_CAPACITY      8           // samples the release velocity is fitted to
+
+#define kTUCMomentumScrollerMaxSampleAge    0.1         // s before the release, older samples do not describe the flick
+#define kTUCMomentumScrollerTimeConstant    0.66        // s until the speed fell to 1/e, like the former 0.985 per 10 ms
+#define kTUCMomentumScrollerMinSpeed        10.0        // pixels per second, slower flicks and momentum stop
+
+
+typedef struct {
+    // ring of the latest samples: time and the scroll position (sum of all translations) after it
+    double time[TUC_MOMENTUM_SCROLLER_CAPACITY];
+    double x[TUC_MOMENTUM_SCROLLER_CAPACITY];
+    double y[TUC_MOMENTUM_SCROLLER_CAPACITY];
+    int numSamples;
+    int next;
+    double positionX, positionY;
+
+    bool isCoasting;
+    double vx, vy;                  // pixels per second at `stepTime`
+    double stepTime;
+    double remainderX, remainderY;  // fractions of a pixel not posted yet
+} TUCMomentumScroller;
+
+
+
+void TUCMomentumScrollerInit(TUCMomentumScroller *scroller);
+
+/**
+ Records a translation of the fingers. Stops the momentum, the fingers are back on the surface.
+ */
+void TUCMomentumScrollerAddSample(TUCMomentumScroller *scroller, double dx, double dy, double time);
+
+/**
+ The fingers were lifted at `time`: starts the momentum, if the recent samples were fast enough. Returns whether it started.
+ The samples are forgotten.
+ */
+bool TUCMomentumScrollerRelease(TUCMomentumScroller *scroller, double time);
+
+void TUCMomentumScrollerCancel(TUCMomentumScroller *scroller);
+
+/**
+ Advances the momentum to `time` and returns the whole pixels to scroll by in `dx`, `dy`.
+ Returns false once the momentum has ended, then there is nothing to post.
+ */
+bool TUCMomentumScrollerStep(TUCMomentumScroller *scroller, double time, double *dx, double *dy);
+
+#endif /* TUCMomentumScroller_h */
@@ -0,0 +1,79 @@
+//
+//  TUCMotionPredictor.c
+//  Touch Up Core
+//
+//  Created by Touch Up contributors on 16.10.26.
+//
+
+#include "TUCMotionPredictor.h"
+
+#include <math.h>
+#include <string.h>
+
+
+void TUCMotionPredictorInit(TUCMotionPredictor *predictor) {
+    memset(predictor, 0, sizeof(TUCMotionPredictor));
+}
+
+
+void TUCMotionPredictorReset(TUCMotionPredictor *predictor, int slot) {
+    predictor->hasSampleMask &= ~(1ull << slot);
+}
+
+
+
+void TUCMotionPredictorUpdate(TUCMotionPredictor *predictor, int slot, double x, double y, double time) {
+    uint64_t bit = 1ull << slot;
+    double dt = time - predictor->time[slot];
+
+    if (!(predictor->hasSampleMask & bit) || dt > kTUCMotionPredictorMaxGap) {
+        predictor->hasSampleMask |= bit;
+        predictor->x[slot] = x;
+        predictor->y[slot] = y;
+        predictor->vx[slot] = 0;
+        predictor->vy[slot] = 0;
+        predictor->time[slot] = time;
+        return;
+    }
+
+    if (dt <= 0) {
+        // repeated sample of the same frame, nothing to learn about the velocity
+        predictor->x[slot] = x;
+        predictor->y[slot] = y;
+        return;
+    }
+
+    double predictedX = predictor->x[slot] + predictor->vx[slot] * dt;
+    double predictedY = predictor->y[slot] + predictor->vy[slot] * dt;
+    double residualX = x - predictedX;
+    double residualY = y - predictedY;
+
+    predictor->x[slot] = predictedX + kTUCMotionPredictorAlpha * residualX;
+    predictor->y[slot] = predictedY + kTUCMotionPredictorAlpha * residualY;
+    predictor->vx[slot] += kTUCMotionPredictorBeta * residualX / dt;
+    predictor->vy[slot] += kTUCMotionPredictorBeta * residualY / dt;
+    predictor->time[slot] = time;
+}
+
+
+
+void TUCMotionPredictorPredict(const TUCMotionPredictor *predictor, int slot, double time, double *x, double *y) {
+    if (!(predictor->hasSampleMask & (1ull << slot))) {
+        return;
+    }
+
+    double lookahead = fmin(fmax(time - predictor->time[slot], 0), kTUCMotionPredictorMaxLookahead);
+    double dx = predictor->vx[slot] * lookahead;
+    double dy = predictor->vy[slot] * lookahead;
+
+    // error clamping: scale the step down to the maximal distance
+    double distance = sqrt(dx * dx + dy * dy);
+    if (distance > kTUCMotionPredictorMaxDistance) {
+        dx *= kTUCMotionPredictorMaxDistance / distance;
+        dy *= kTUCMotionPredictorMaxDistance / distance;
+    }
+
+    // predict from the last sample, not from the filtered position, so standing still shows no offset
+    *x = fmin(fmax(*x + dx, 0), 1);
+    *y = fmin(fmax(*y + dy, 0), 1);
+}
@@ -0,0 +1,60 @@
+//
+//  TUCMotionPredictor.h
+//  Touch Up Core
+//
+//  Created by Touch Up contributors on 16.10.26.
+//
+
+#ifndef TUCMotionPredictor_h
+#define TUCMotionPredictor_h
+
+#include <stdbool.h>
+#include <stdint.h>
+
+/*
+ Predicts where a finger will be a moment from now, so the cursor does not trail behind it.
+
+ Every contact runs an alpha-beta filter: the position follows the samples closely, the velocity is smoothed over a few of them.
+ A prediction extrapolates the last position with that velocity. The look-ahead and the predicted distance are clamped, a wrong
+ prediction (the finger stopped or turned) can never throw the cursor far. Positions are relative screen coordinates (0...1),
+ times are seconds on the host timeline. The state is indexed by the slots of the touch table.
+ Like the decoder, this file does not depend on AppKit or CoreFoundation.
+ */
+
+
+#define TUC_MOTION_PREDICTOR_CAPACITY       64          // kTUCTouchTableCapacity
+
+#define kTUCMotionPredictorAlpha            0.85        // weight of a new sample for the position
+#define kTUCMotionPredictorBeta             0.3         // weight of a new sample for the velocity
+#define kTUCMotionPredictorMaxLookahead     0.05        // s, never extrapolate further than this
+#define kTUCMotionPredictorMaxDistance      0.02        // relative, never move the prediction further from the last sample
+#define kTUCMotionPredictorMaxGap           0.1         // s, after a longer pause the velocity starts at 0 again
+
+
+typedef struct {
+    uint64_t hasSampleMask;     // one bit per slot
+
+    double x[TUC_MOTION_PREDICTOR_CAPACITY];
+    double y[TUC_MOTION_PREDICTOR_CAPACITY];
+    double vx[TUC_MOTION_PREDICTOR_CAPACITY];   // per second
+    double vy[TUC_MOTION_PREDICTOR_CAPACITY];
+    double time[TUC_MOTION_PREDICTOR_CAPACITY]; // of the last sample
+} TUCMotionPredictor;
+
+
+
+void TUCMotionPredictorInit(TUCMotionPredictor *predictor);
+
+/**
+ Forgets a slot, call it when a new touch takes the slot.
+ */
+void TUCMotionPredictorReset(TUCMotionPredictor *predictor, int slot);
+
+void TUCMotionPredictorUpdate(TUCMotionPredictor *predictor, int slot, double x, double y, double time);
+
+/**
+ Moves the last sample of the contact in `x`, `y` to where it is expected at `time`. Without samples they are left untouched.
+ */
+void TUCMotionPredictorPredict(const TUCMotionPredictor *predictor, int slot, double time, double *x, double *y);
+
+#endif /* TUCMotionPredictor_h */
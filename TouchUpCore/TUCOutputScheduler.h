@@ -0,0 +1,61 @@
+//
+//  TUCOutputScheduler.h
+//  Touch Up Core
+//
+//  Created by Touch Up contributors on 16.10.26.
+//
+
+#import <Cocoa/Cocoa.h>
+
+#import "TUCEventSink.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ Posts the events of `TUCCursorUtilities` in time with the display.
+
+ A digitizer reports a moving finger up to a few hundred times per second, the screen shows 60 or 120 frames. Moves and drags are
+ therefore not posted when they arrive: a new one replaces the pending one, and a display link posts the latest once per refresh.
+ All other events (buttons, clicks, scrolling, gestures) are posted immediately, right after the pending move, so the order in
+ which they were requested never changes. The display link only runs while the cursor moves or a `frameHandler` animates.
+ What is posted goes to the `sink`, by default a `TUCSystemEventSink`.
+
+ Every second with output, the rate of posted events, the events created and the latency from the touch sample to the posted
+ move are logged.
+ Can be called from any thread.
+ */
+@interface TUCOutputScheduler : NSObject
+
+/**
+ Replacing it does not post the pending move, it goes to the new sink.
+ */
+@property (strong) id<TUCEventSink> sink;
+
+/**
+ The frame clock for animations such as the momentum of a scroll. While set, it is called once per display refresh on the display
+ link thread, with the time the frame will be shown (seconds on the mach_absolute_time timeline). Return NO when there is nothing
+ left to animate, the handler is then removed. Without a display link a 60 Hz timer calls it instead, and only while it is set.
+ */
+@property (copy, nullable) BOOL (^frameHandler)(NSTimeInterval time);
+
+/**
+ Replaces the pending move. `type` is `kCGEventMouseMoved` or `kCGEventLeftMouseDragged`. `inputTimestamp` is the sample time
+ of the touch that caused the move, seconds on the mach_absolute_time timeline.
+ */
+- (void)scheduleMoveOfType:(CGEventType)type to:(CGPoint)location clickState:(int64_t)clickState inputTimestamp:(NSTimeInterval)inputTimestamp;
+
+/**
+ Post the pending move, then the event.
+ */
+- (void)postMouseEventOfType:(CGEventType)type at:(CGPoint)location clickState:(int64_t)clickState;
+- (void)postScrollBy:(CGPoint)translation;
+- (void)postMagnification:(CGFloat)magnification phase:(NSTouchPhase)phase at:(CGPoint)location;
+
+/**
+ Posts the pending move now, e.g. before the system is asked where the cursor is.
+ */
+- (void)flush;
+
+@end
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,427 @@
+//
+//  TUCOutputScheduler.m
+//  Touch Up Core
+//
+//  Created by Touch Up contributors on 16.10.26.
+//
+
+#import "TUCOutputScheduler.h"
+
+#import <CoreVideo/CoreVideo.h>
+#import <mach/mach_time.h>
+#import <os/lock.h>
+#import <time.h>
+
+#import "TUCLog.h"
+
+/**
+ Set to 0 to post every move when it arrives, as before, e.g. to compare the rates and latencies of the output report.
+ */
+#define TUC_COALESCE_CURSOR_MOVES 1
+
+#define kIdleRefreshesBeforeStop    30      // the display link stops after this many refreshes without a move
+#define kFrameTimerInterval         (NSEC_PER_SEC / 60)
+#define kReportInterval             1.0     // s
+
+// touch sample to post latency in buckets of 250 µs, everything above 50 ms lands in the last bucket
+#define kLatencyBucketWidth         0.00025
+#define kLatencyNumBuckets          200
+
+
+typedef struct {
+    BOOL isPending;
+    CGEventType type;
+    CGPoint location;
+    int64_t clickState;
+    NSTimeInterval inputTimestamp;
+} TUCPendingMove;
+
+
+static NSTimeInterval CurrentTime(void) {
+    return (NSTimeInterval)clock_gettime_nsec_np(CLOCK_UPTIME_RAW) / NSEC_PER_SEC;
+}
+
+
+static NSTimeInterval HostTimeToSeconds(uint64_t hostTime) {
+    static mach_timebase_info_data_t timebase;
+    if (timebase.denom == 0) {
+        mach_timebase_info(&timebase);
+    }
+    return (NSTimeInterval)hostTime * timebase.numer / timebase.denom / NSEC_PER_SEC;
+}
+
+
+@interface TUCOutputScheduler () {
+    // guards everything below, posts happen while it is held so they keep their order
+    os_unfair_lock _lock;
+    
+    TUCPendingMove _pendingMove;
+    id<TUCEventSink> _sink;
+    
+    CVDisplayLinkRef _displayLink;
+    BOOL _isDisplayLinkRunning;
+    NSInteger _numIdleRefreshes;
+    
+    BOOL (^_frameHandler)(NSTimeInterval time);
+    dispatch_source_t _frameTimer;      // only without a display link
+    
+    // output report
+    NSTimeInterval _reportStart;
+    NSTimeInterval _lastPostTime;
+    uint32_t _numPostedEvents;
+    uint32_t _numCoalescedMoves;
+    uint64_t _numCreatedEventsAtReportStart;
+    uint32_t _latencyHistogram[kLatencyNumBuckets];
+    uint32_t _numLatencySamples;
+    NSTimeInterval _maxLatency;
+}
+
+- (void)displayDidRefreshAt:(NSTimeInterval)time;
+
+@end
+
+
+
+static CVReturn DisplayLinkCallback(CVDisplayLinkRef displayLink, const CVTimeStamp *now, const CVTimeStamp *outputTime,
+                                    CVOptionFlags flagsIn, CVOptionFlags *flagsOut, void *context) {
+    @autoreleasepool {
+        [(__bridge TUCOutputScheduler *)context displayDidRefreshAt:HostTimeToSeconds(outputTime->hostTime)];
+    }
+    return kCVReturnSuccess;
+}
+
+
+
+@implementation TUCOutputScheduler
+
+- (instancetype)init {
+    if (self = [super init]) {
+        _lock = OS_UNFAIR_LOCK_INIT;
+        _sink = [[TUCSystemEventSink alloc] init];
+    
+#if TUC_COALESCE_CURSOR_MOVES
+        // ticks with the main display, without a display link every move is posted right away
+        if (CVDisplayLinkCreateWithActiveCGDisplays(&_displayLink) == kCVReturnSuccess) {
+            CVDisplayLinkSetOutputCallback(_displayLink, DisplayLinkCallback, (__bridge void *)self);
+        } else {
+            _displayLink = NULL;
+            TUCLogWarning(Cursor, "[OutputScheduler] no display link, moves are posted without coalescing");
+        }
+#endif
+    }
+    return self;
+}
+
+
+- (void)dealloc {
+    if (_displayLink != NULL) {
+        CVDisplayLinkStop(_displayLink);
+        CVDisplayLinkRelease(_displayLink);
+    }
+}
+
+
+
+#pragma mark - Posting
+
+- (id<TUCEventSink>)sink {
+    os_unfair_lock_lock(&_lock);
+    id<TUCEventSink> sink = _sink;
+    os_unfair_lock_unlock(&_lock);
+    return sink;
+}
+
+
+- (void)setSink:(id<TUCEventSink>)sink {
+    os_unfair_lock_lock(&_lock);
+    _sink = sink;
+    [self resetReportAt:CurrentTime()];
+    os_unfair_lock_unlock(&_lock);
+}
+
+
+- (void)scheduleMoveOfType:(CGEventType)type to:(CGPoint)location clickState:(int64_t)clickState inputTimestamp:(NSTimeInterval)inputTimestamp {
+    os_unfair_lock_lock(&_lock);
+    
+    if (_pendingMove.isPending && _pendingMove.type != type) {
+        // a move never replaces a drag or the other way around
+        [self postPendingMove];
+    } else if (_pendingMove.isPending) {
+        _numCoalescedMoves++;
+    }
+    
+    _pendingMove = (TUCPendingMove){
+        .isPending = YES,
+        .type = type,
+        .location = location,
+        .clickState = clickState,
+        .inputTimestamp = inputTimestamp,
+    };
+    
+    BOOL shouldStartDisplayLink = NO;
+    if (_displayLink == NULL) {
+        [self postPendingMove];
+    } else {
+        shouldStartDisplayLink = [self keepDisplayLinkRunning];
+    }
+    
+    os_unfair_lock_unlock(&_lock);
+    
+    if (shouldStartDisplayLink) {
+        CVDisplayLinkStart(_displayLink);
+    }
+}
+
+
+- (void)postMouseEventOfType:(CGEventType)type at:(CGPoint)location clickState:(int64_t)clickState {
+    os_unfair_lock_lock(&_lock);
+    [self postPendingMove];
+    [self post:(TUCOutputEvent){ .type = type, .value = (int32_t)clickState, .x = location.x, .y = location.y }];
+    os_unfair_lock_unlock(&_lock);
+}
+
+
+- (void)postScrollBy:(CGPoint)translation {
+    os_unfair_lock_lock(&_lock);
+    [self postPendingMove];
+    [self post:(TUCOutputEvent){ .type = kCGEventScrollWheel, .x = translation.x, .y = translation.y }];
+    os_unfair_lock_unlock(&_lock);
+}
+
+
+- (void)postMagnification:(CGFloat)magnification phase:(NSTouchPhase)phase at:(CGPoint)location {
+    os_unfair_lock_lock(&_lock);
+    [self postPendingMove];
+    [self post:(TUCOutputEvent){
+        .type = kTUCOutputEventMagnify, .value = (int32_t)phase, .x = location.x, .y = location.y, .magnification = magnification }];
+    os_unfair_lock_unlock(&_lock);
+}
+
+
+- (void)flush {
+    os_unfair_lock_lock(&_lock);
+    [self postPendingMove];
+    os_unfair_lock_unlock(&_lock);
+}
+
+
+/**
+ _lock must be held.
+ */
+- (void)postPendingMove {
+    if (!_pendingMove.isPending) {
+        return;
+    }
+    _pendingMove.isPending = NO;
+    
+    [self post:(TUCOutputEvent){
+        .type = _pendingMove.type, .value = (int32_t)_pendingMove.clickState, .x = _pendingMove.location.x, .y = _pendingMove.location.y }];
+    
+    if (_pendingMove.inputTimestamp > 0) {
+        [self recordLatency:_lastPostTime - _pendingMove.inputTimestamp];
+    }
+}
+
+
+/**
+ _lock must be held.
+ */
+- (void)post:(TUCOutputEvent)event {
+    event.timestamp = clock_gettime_nsec_np(CLOCK_UPTIME_RAW);
+    [_sink postOutputEvent:&event];
+    
+    NSTimeInterval now = (NSTimeInterval)event.timestamp / NSEC_PER_SEC;
+    
+    if (now - _lastPostTime > kReportInterval) {
+        // the cursor rested, start a new report instead of averaging over the pause
+        [self resetReportAt:now];
+    }
+    _lastPostTime = now;
+    _numPostedEvents++;
+    
+    if (now - _reportStart >= kReportInterval) {
+        TUCLogInfo(Cursor, "Output report -> %.0f events/s posted, %u moves coalesced, %llu events created, move latency p50 %.2f ms, p99 %.2f ms, max %.2f ms (%s)",
+                   _numPostedEvents / (now - _reportStart), _numCoalescedMoves, [self numCreatedEvents] - _numCreatedEventsAtReportStart,
+                   [self latencyPercentile:0.5], [self latencyPercentile:0.99], _maxLatency * 1000,
+                   _displayLink != NULL ? "display link" : "immediate");
+        [self resetReportAt:now];
+    }
+}
+
+
+
+#pragma mark - Display Link
+
+- (BOOL (^)(NSTimeInterval))frameHandler {
+    os_unfair_lock_lock(&_lock);
+    BOOL (^frameHandler)(NSTimeInterval) = _frameHandler;
+    os_unfair_lock_unlock(&_lock);
+    return frameHandler;
+}
+
+
+- (void)setFrameHandler:(BOOL (^)(NSTimeInterval))frameHandler {
+    BOOL shouldStartDisplayLink = NO;
+    
+    os_unfair_lock_lock(&_lock);
+    _frameHandler = [frameHandler copy];
+    if (frameHandler != nil && _displayLink != NULL) {
+        shouldStartDisplayLink = [self keepDisplayLinkRunning];
+    } else if (frameHandler != nil && _frameTimer == nil) {
+        [self startFrameTimer];
+    } else if (frameHandler == nil) {
+        [self stopFrameTimer];
+    }
+    os_unfair_lock_unlock(&_lock);
+    
+    if (shouldStartDisplayLink) {
+        CVDisplayLinkStart(_displayLink);
+    }
+}
+
+
+/**
+ Runs on the display link thread once per refresh, or on the frame timer. `time` is when the frame will be shown.
+ */
+- (void)displayDidRefreshAt:(NSTimeInterval)time {
+    BOOL shouldStopDisplayLink = NO;
+    
+    os_unfair_lock_lock(&_lock);
+    BOOL (^frameHandler)(NSTimeInterval) = _frameHandler;
+    if (_pendingMove.isPending) {
+        [self postPendingMove];
+        _numIdleRefreshes = 0;
+    } else if (frameHandler != nil) {
+        _numIdleRefreshes = 0;
+    } else if (++_numIdleRefreshes >= kIdleRefreshesBeforeStop && _isDisplayLinkRunning) {
+        _isDisplayLinkRunning = NO;
+        shouldStopDisplayLink = YES;
+    }
+    os_unfair_lock_unlock(&_lock);
+    
+    // outside the lock, the handler posts through the scheduler
+    if (frameHandler != nil && !frameHandler(time)) {
+        os_unfair_lock_lock(&_lock);
+        if (_frameHandler == frameHandler) {
+            _frameHandler = nil;
+            [self stopFrameTimer];
+        }
+        os_unfair_lock_unlock(&_lock);
+    }
+    
+    if (shouldStopDisplayLink) {
+        // stopping the display link from its own callback can deadlock
+        dispatch_async(dispatch_get_global_queue(QOS_CLASS_USER_INTERACTIVE, 0), ^{
+            [self stopDisplayLink];
+        });
+    }
+}
+
+
+- (void)stopDisplayLink {
+    CVDisplayLinkStop(_displayLink);
+    
+    // a move scheduled since the last refresh found the link still running and did not start it
+    os_unfair_lock_lock(&_lock);
+    BOOL isNeeded = _isDisplayLinkRunning;
+    os_unfair_lock_unlock(&_lock);
+    
+    if (isNeeded) {
+        CVDisplayLinkStart(_displayLink);
+    }
+}
+
+
+/**
+ _lock must be held. Returns YES if the caller has to start the display link, after releasing the lock.
+ */
+- (BOOL)keepDisplayLinkRunning {
+    BOOL shouldStart = !_isDisplayLinkRunning;
+    _isDisplayLinkRunning = YES;
+    _numIdleRefreshes = 0;
+    return shouldStart;
+}
+
+
+/**
+ _lock must be held.
+ */
+- (void)startFrameTimer {
+    __weak TUCOutputScheduler *weakSelf = self;
+    _frameTimer = dispatch_source_create(DISPATCH_SOURCE_TYPE_TIMER, 0, 0, dispatch_get_global_queue(QOS_CLASS_USER_INTERACTIVE, 0));
+    dispatch_source_set_timer(_frameTimer, dispatch_time(DISPATCH_TIME_NOW, kFrameTimerInterval), kFrameTimerInterval, kFrameTimerInterval / 10);
+    dispatch_source_set_event_handler(_frameTimer, ^{
+        [weakSelf displayDidRefreshAt:CurrentTime()];
+    });
+    dispatch_resume(_frameTimer);
+}
+
+
+/**
+ _lock must be held.
+ */
+- (void)stopFrameTimer {
+    if (_frameTimer != nil) {
+        dispatch_source_cancel(_frameTimer);
+        _frameTimer = nil;
+    }
+}
+
+
+
+#pragma mark - Output Report
+
+/**
+ _lock must be held.
+ */
+- (void)recordLatency:(NSTimeInterval)latency {
+    NSInteger bucket = (NSInteger)(fmax(latency, 0) / kLatencyBucketWidth);
+    _latencyHistogram[bucket < kLatencyNumBuckets ? bucket : kLatencyNumBuckets - 1]++;
+    _numLatencySamples++;
+    if (latency > _maxLatency) {
+        _maxLatency = latency;
+    }
+}
+
+
+/**
+ In milliseconds, _lock must be held.
+ */
+- (double)latencyPercentile:(double)percentile {
+    if (_numLatencySamples == 0) {
+        return 0;
+    }
+    uint32_t rank = (uint32_t)(_numLatencySamples * percentile);
+    uint32_t count = 0;
+    for (int i = 0; i < kLatencyNumBuckets; i++) {
+        count += _latencyHistogram[i];
+        if (count > rank) {
+            return (i + 1) * kLatencyBucketWidth * 1000;
+        }
+    }
+    return kLatencyNumBuckets * kLatencyBucketWidth * 1000;
+}
+
+
+/**
+ _lock must be held.
+ */
+- (uint64_t)numCreatedEvents {
+    return [_sink respondsToSelector:@selector(numCreatedEvents)] ? _sink.numCreatedEvents : 0;
+}
+
+
+/**
+ _lock must be held.
+ */
+- (void)resetReportAt:(NSTimeInterval)now {
+    _reportStart = now;
+    _numPostedEvents = 0;
+    _numCoalescedMoves = 0;
+    _numCreatedEventsAtReportStart = [self numCreatedEvents];
+    memset(_latencyHistogram, 0, sizeof(_latencyHistogram));
+    _numLatencySamples = 0;
+    _maxLatency = 0;
+}
+
+@end
@@ -12,7 +12,7 @@ NS_ASSUME_NONNULL_BEGIN
 /**
  The `TUCScreen` augments `NSScreen` with access to additional screen layout properties and information on the conversion of digitizer coordinate system to pixels.
  */
-@interface TUCScreen : NSObject
+@interface TUCScreen : NSObject <NSCopying>
 
 @property NSUInteger id;
 @property (strong) NSString *name;
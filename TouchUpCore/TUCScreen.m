@@ -7,6 +7,8 @@
 
 #import "TUCScreen.h"
 
+#import "TUCLog.h"
+
 @implementation TUCScreen
 
 - (instancetype)initWithScreen:(NSScreen *)screen frameOfFirstScreen:(CGRect)firstFrame {
@@ -46,6 +48,26 @@
     return self;
 }
 
+- (id)copyWithZone:(NSZone *)zone {
+    TUCScreen *copy = [[TUCScreen allocWithZone:zone] init];
+    copy.id = self.id;
+    copy.name = self.name;
+    copy.rotation = self.rotation;
+    copy.physicalSize = self.physicalSize;
+    copy.frame = self.frame;
+    
+    copy.calibrationTouchA = self.calibrationTouchA;
+    copy.calibrationTouchB = self.calibrationTouchB;
+    copy.calibrationTouchC = self.calibrationTouchC;
+    copy.calibrationTouchD = self.calibrationTouchD;
+    copy.calibrationScreenA = self.calibrationScreenA;
+    copy.calibrationScreenB = self.calibrationScreenB;
+    copy.calibrationScreenC = self.calibrationScreenC;
+    copy.calibrationScreenD = self.calibrationScreenD;
+    copy.isCalibrated = self.isCalibrated;
+    return copy;
+}
+
 - (nullable NSScreen *)systemScreen {
     NSArray *screens = [NSScreen screens];
     
@@ -129,15 +151,15 @@
         
         absLoc = CGPointMake(screenX, screenY);
         
-        printf("[TUCScreen] ✅ LINEAR MAPPING (ID=%u):\n", (unsigned int)self.id);
-        printf("            RAW touch=(%.4f, %.4f)\n", relativePoint.x, relativePoint.y);
-        printf("            Touch range: X[%.4f - %.4f], Y[%.4f - %.4f]\n", 
-               touchMinX, touchMaxX, touchMinY, touchMaxY);
-        printf("            Screen range: X[%.0f - %.0f], Y[%.0f - %.0f]\n",
-               screenMinX, screenMaxX, screenMinY, screenMaxY);
-        printf("            Display bounds: X[%.0f - %.0f], Y[%.0f - %.0f]\n",
-               displayMinX, displayMaxX, displayMinY, displayMaxY);
-        printf("            → Screen=(%.1f, %.1f)\n", screenX, screenY);
+        TUCLogTrace(Screen, "[TUCScreen] ✅ LINEAR MAPPING (ID=%u):", (unsigned int)self.id);
+        TUCLogTrace(Screen, "            RAW touch=(%.4f, %.4f)", relativePoint.x, relativePoint.y);
+        TUCLogTrace(Screen, "            Touch range: X[%.4f - %.4f], Y[%.4f - %.4f]",
+                    touchMinX, touchMaxX, touchMinY, touchMaxY);
+        TUCLogTrace(Screen, "            Screen range: X[%.0f - %.0f], Y[%.0f - %.0f]",
+                    screenMinX, screenMaxX, screenMinY, screenMaxY);
+        TUCLogTrace(Screen, "            Display bounds: X[%.0f - %.0f], Y[%.0f - %.0f]",
+                    displayMinX, displayMaxX, displayMinY, displayMaxY);
+        TUCLogTrace(Screen, "            → Screen=(%.1f, %.1f)", screenX, screenY);
     } else {
         // Fallback ohne Kalibrierung
         absLoc = CGPointMake(
@@ -145,8 +167,8 @@
             screenOrigin.y + (relativePoint.y * screenSize.height)
         );
         
-        printf("[TUCScreen] ❌ NO CALIBRATION (ID=%u): touch(%.4f, %.4f) -> screen(%.0f, %.0f)\n",
-               (unsigned int)self.id, relativePoint.x, relativePoint.y, absLoc.x, absLoc.y);
+        TUCLogTrace(Screen, "[TUCScreen] ❌ NO CALIBRATION (ID=%u): touch(%.4f, %.4f) -> screen(%.0f, %.0f)",
+                    (unsigned int)self.id, relativePoint.x, relativePoint.y, absLoc.x, absLoc.y);
     }
     
     return absLoc;
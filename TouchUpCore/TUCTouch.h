@@ -45,7 +45,7 @@ typedef NS_ENUM(NSUInteger, TUCCursorAction) {
 @property BOOL isOnSurface; //tip
 @property BOOL confidenceFlag;
 
-@property CGSize size;
+@property CGSize size;   // relative to the screen, zero if the touchscreen does not report it
 @property CGFloat azimuth;
 
 @property (nonatomic) NSTouchPhase phase;
@@ -54,11 +54,16 @@ typedef NS_ENUM(NSUInteger, TUCCursorAction) {
 @property (nonatomic) CGPoint location;
 @property CGPoint previousLocation;
 
+@property NSTimeInterval timestamp; // when the digitizer sampled the touch, in seconds on the mach_absolute_time timeline
+@property NSTimeInterval previousTimestamp;
+@property (readonly) CGVector velocity; // digitizer units per second, based on the sample spacing of the device
+
 @property NSInteger lastUpdated; // the page ID during last update
 
 
 - (instancetype)initWithContactID:(NSInteger)contactID ;
 
+- (void)setLocation:(CGPoint)location timestamp:(NSTimeInterval)timestamp;
 
 
 - (BOOL)isActive;
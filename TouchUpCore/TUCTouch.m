@@ -6,6 +6,7 @@
 //
 
 #import "TUCTouch.h"
+#import "TUCTouchTable.h"
 
 @implementation TUCTouch
 
@@ -33,6 +34,10 @@
         
         _location = CGPointZero;
         _previousLocation = CGPointZero;
+        
+        _timestamp = 0;
+        _previousTimestamp = 0;
+        _velocity = CGVectorMake(0, 0);
     }
     return self;
 }
@@ -64,6 +69,41 @@
 }
 
 
+- (void)setLocation:(CGPoint)location timestamp:(NSTimeInterval)timestamp {
+    BOOL hasPreviousSample = _timestamp > 0;
+    
+    [self setLocation:location];
+    _previousTimestamp = _timestamp;
+    _timestamp = timestamp;
+    
+    // the first sample has no velocity, neither has a repeated sample of the same frame
+    NSTimeInterval dt = _timestamp - _previousTimestamp;
+    if (hasPreviousSample && dt > 0) {
+        _velocity = CGVectorMake((_location.x - _previousLocation.x) / dt,
+                                 (_location.y - _previousLocation.y) / dt);
+    }
+}
+
+
+
+- (void)updateWithTouchRecord:(const TUCTouchRecord *)record {
+    _isOnSurface = record->isOnSurface;
+    _confidenceFlag = record->confidenceFlag;
+    _size = record->size;
+    _azimuth = record->azimuth;
+    
+    _phase = record->phase;
+    _previousPhase = record->previousPhase;
+    _location = record->location;
+    _previousLocation = record->previousLocation;
+    _timestamp = record->timestamp;
+    _previousTimestamp = record->previousTimestamp;
+    _velocity = record->velocity;
+    
+    _lastUpdated = record->lastUpdated;
+}
+
+
 
 #pragma mark - Gesture Detection
 
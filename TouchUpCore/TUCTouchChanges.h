@@ -0,0 +1,30 @@
+//
+//  TUCTouchChanges.h
+//  Touch Up Core
+//
+//  Created by Touch Up contributors on 16.10.26.
+//
+
+#import <Foundation/Foundation.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/**
+ What happened to the touches during one frame, passed to `touchesDidChange:`. The sets hold the contact IDs of the touches.
+ */
+@interface TUCTouchChanges : NSObject
+
+@property (readonly) NSIndexSet *addedContactIDs;   // touches that began
+@property (readonly) NSIndexSet *movedContactIDs;   // touches whose location changed, stationary ones are not listed
+@property (readonly) NSIndexSet *endedContactIDs;   // touches that were lifted or cancelled, they stay in `touchSet` for a few frames
+
+/**
+ No changes, e.g. for a frame in which ended touches only left `touchSet`.
+ */
+- (instancetype)init;
+
+- (instancetype)initWithAddedContactIDs:(NSIndexSet *)added movedContactIDs:(NSIndexSet *)moved endedContactIDs:(NSIndexSet *)ended;
+
+@end
+
+NS_ASSUME_NONNULL_END
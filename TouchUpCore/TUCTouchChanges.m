@@ -0,0 +1,27 @@
+//
+//  TUCTouchChanges.m
+//  Touch Up Core
+//
+//  Created by Touch Up contributors on 16.10.26.
+//
+
+#import "TUCTouchChanges.h"
+
+@implementation TUCTouchChanges
+
+- (instancetype)init {
+    return [self initWithAddedContactIDs:[NSIndexSet indexSet] movedContactIDs:[NSIndexSet indexSet] endedContactIDs:[NSIndexSet indexSet]];
+}
+
+
+- (instancetype)initWithAddedContactIDs:(NSIndexSet *)added movedContactIDs:(NSIndexSet *)moved endedContactIDs:(NSIndexSet *)ended {
+    if (self = [super init]) {
+        _addedContactIDs = [added copy];
+        _movedContactIDs = [moved copy];
+        _endedContactIDs = [ended copy];
+    }
+    return self;
+}
+
+
+@end
@@ -8,18 +8,25 @@
 #import <AppKit/AppKit.h>
 #import <CoreGraphics/CoreGraphics.h>
 #import "TUCTouch.h"
+#import "TUCTouchChanges.h"
 #import "TUCScreen.h"
 
 NS_ASSUME_NONNULL_BEGIN
 
+/**
+ Every method is called on the main thread. Touches are processed on the inputQueue of the input manager, which never calls
+ the delegate: `touchscreen` and `actionForGesture:` are asked in `-[TUCTouchInputManager reloadConfiguration]`, and the
+ input manager works with a copy of the answers until the next reload. So the delegate may answer from state it changes on the
+ main thread, but it has to call `reloadConfiguration` after the change.
+ */
 @protocol TUCTouchDelegate <NSObject>
 
 #pragma mark - Touch Data
 /**
- 
- This method is called every time after the `touchSet` was updated
+ Called on the main thread after a frame was published, at most once per frame: only if touches were added, moved
+ or ended, or ended touches left the set. `changes` lists the contact IDs of the frame.
  */
-- (void)touchesDidChange;
+- (void)touchesDidChange:(TUCTouchChanges *)changes;
 
 
 
@@ -33,12 +40,13 @@ NS_ASSUME_NONNULL_BEGIN
 #pragma mark - Mouse Control
 
 /**
- Specifies which screen corresponds to the touch screen.
+ Specifies which screen corresponds to the touch screen. The input manager keeps a copy, later changes to the returned object,
+ like a new calibration, only take effect with the next `reloadConfiguration`.
  */
 - (nullable TUCScreen *)touchscreen;
 
 /**
- Used to customize which mouse events are posted by the input manager.
+ Used to customize which mouse events are posted by the input manager. Asked once for every gesture per `reloadConfiguration`.
  */
 - (TUCCursorAction)actionForGesture:(TUCCursorGesture)gesture;
 
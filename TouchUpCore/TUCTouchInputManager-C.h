@@ -10,11 +10,36 @@
 #ifndef TUCTouchInputManager_C_h
 #define TUCTouchInputManager_C_h
 
-void TouchInputManagerUpdateTouchPosition(void *self, CFIndex contactID, CGFloat x, CGFloat y, Boolean onSurface, Boolean isValid);
+// touchscreens the touch manager keeps apart, see TouchInputManagerProcessFrame
+#define kTouchInputManagerMaxDevices 4
+
+/**
+ One contact of a frame for TouchInputManagerProcessFrame.
+ */
+typedef struct {
+    CFIndex  contactID;
+    CGFloat  x;             // digitizer coordinates 0...1
+    CGFloat  y;
+    CGFloat  width;         // relative to the screen, negative if the device does not report it
+    CGFloat  height;
+    CGFloat  azimuth;
+    uint64_t timestamp;     // time the contact was sampled by the digitizer, host timeline in ns
+    Boolean  onSurface;     // tip, a contact without it ends its touch
+    Boolean  isValid;
+} TouchInputManagerContact;
+
+// a whole frame in one call: updates the touches in the order of the array, then runs the frame logic once
+// device: the touchscreen that sent the frame, 0 ..< kTouchInputManagerMaxDevices. Touches only time out by frames of their own screen.
+// timestamp: sample time of the frame, host timeline in ns
+void TouchInputManagerProcessFrame(void *self, CFIndex device, const TouchInputManagerContact *contacts, CFIndex count, uint64_t timestamp);
+
+// timestamp: time the contact was sampled by the digitizer, host timeline in ns (mach_absolute_time based)
+void TouchInputManagerUpdateTouchPosition(void *self, CFIndex contactID, CGFloat x, CGFloat y, Boolean onSurface, Boolean isValid, uint64_t timestamp);
 
 void TouchInputManagerUpdateTouchSize(void *self, CFIndex contactID, CGFloat width, CGFloat height, CGFloat azimuth);
 
-// called after a full report (no partials in hybrid modes) was handled
+// called after a full report (no partials in hybrid modes) was handled, not needed with TouchInputManagerProcessFrame
+// the touches of these calls belong to device 0
 void TouchInputManagerDidProcessReport(void *self);
 
 void TouchInputManagerDidConnectTouchscreen(void *self);
@@ -9,16 +9,53 @@
 #import "TUCTouchInputManager-C.h"
 #import "TUCTouchDelegate.h"
 #import "TUCTouch.h"
+#import "TUCTouchSnapshot.h"
+#import "TUCEventSink.h"
 
 NS_ASSUME_NONNULL_BEGIN
 
 
+typedef NS_ENUM(NSUInteger, TUCInputDropPolicy) {
+    TUCInputDropPolicyPreserveAll = 0,  // every frame reaches the gestures, input waits if they fall behind
+    TUCInputDropPolicyDropOldest,       // stale reports and frames superseded before the gestures got to them are skipped, input never waits
+};
+
+/**
+ Health of the input pipeline since the manager was started.
+ */
+typedef struct {
+    NSUInteger queueDepth;              // values the HID queue holds, 0 if the touchscreen is decoded from its raw reports
+    NSUInteger numQueueOverflows;       // times the HID queue was found full, values were probably lost
+    NSUInteger numStaleReports;         // reports older than 100 ms when they were processed
+    NSUInteger numDroppedFrames;        // frames skipped by TUCInputDropPolicyDropOldest
+    NSUInteger numStalls;               // times the input thread waited for the gesture processing
+    NSUInteger numSuppressedMoves;      // samples of resting fingers the jitter filter held in place, each one a move event less
+    NSUInteger numRejectedOversized;    // touches too large for a finger (palms, forearms), never passed to the gestures
+    NSUInteger numRejectedLowConfidence;    // touches the touchscreen itself flagged as no finger
+} TUCInputStatistics;
+
+
 
 @interface TUCTouchInputManager : NSObject
 
 @property (weak, nonatomic) id<TUCTouchDelegate> delegate;
 
-@property (strong, atomic) NSMutableSet<TUCTouch *> *touchSet;
+/**
+ The touches after the latest frame, published once per frame. Acquiring is wait-free and copies nothing, the snapshot stays
+ untouched until the next call. Call it from one thread only, the main thread, like `touchSet`.
+ */
+- (const TUCTouchSnapshot *)acquireTouchSnapshot;
+
+/**
+ Compatibility view of the latest snapshot as `TUCTouch` objects, main thread only. It is rebuilt on the first access after a
+ frame; a `TUCTouch` keeps its UUID while the touch lives.
+ */
+@property (readonly) NSSet<TUCTouch *> *touchSet;
+
+/**
+ Serial queue the touches are tracked and the gestures are evaluated on. The touch state of the manager is confined to it.
+ */
+@property (strong, readonly) dispatch_queue_t inputQueue;
 
 /**
  Allows to deactiate that the framework processes touches to post them as mouse events.
@@ -26,6 +63,12 @@ NS_ASSUME_NONNULL_BEGIN
  */
 @property BOOL postMouseEvents;
 
+/**
+ Where the mouse events go, by default to the system. A `TUCMemoryEventSink` or `TUCFileEventSink` lets the gestures run
+ without moving the real cursor, e.g. for benchmarks or to record the output of a touch sequence.
+ */
+@property (strong) id<TUCEventSink> eventSink;
+
 
 /**
  The maximal distance in mm that two taps may be apart from each other to count as double click
@@ -37,8 +80,15 @@ NS_ASSUME_NONNULL_BEGIN
  */
 @property NSTimeInterval holdDuration;
 
+/**
+ How far ahead of the current time (in seconds) moving fingers are predicted before the cursor follows them, e.g. the time until
+ the next display refresh. 0 disables the prediction, which is the default value. The look-ahead is limited to 50 ms.
+ */
+@property NSTimeInterval predictionHorizon;
+
 /**
  If a touch is no longer reported by the screen, wait for this number of incoming reports bevore deleting it from the touch set.
+ Only reports of the touch's own screen count, with several screens connected.
  */
 @property NSInteger errorResistance;
 
@@ -74,6 +124,13 @@ NS_ASSUME_NONNULL_BEGIN
  */
 @property BOOL isClickOnLiftEnabled;
 
+/**
+ What happens to input that arrives faster than the gestures are processed. The default value is TUCInputDropPolicyPreserveAll.
+ */
+@property (nonatomic) TUCInputDropPolicy inputDropPolicy;
+
+@property (nonatomic, readonly) TUCInputStatistics inputStatistics;
+
 
 - (void)start;
 
@@ -81,6 +138,18 @@ NS_ASSUME_NONNULL_BEGIN
 
 
 
+/**
+ Asks the delegate for the touchscreen and the action of every gesture, and AppKit for the menu bar height, and hands the
+ answers to the inputQueue, which never calls the delegate itself. Main thread only. Setting the delegate and `start` reload
+ it; call it again whenever one of the answers changes: screens were rearranged, another touchscreen was chosen or
+ calibrated, or a setting the actions depend on was changed.
+ */
+- (void)reloadConfiguration;
+
+
+/**
+ Converts with the touchscreen of the last reloadConfiguration, on the inputQueue.
+ */
 - (CGPoint)convertScreenPointRelativeToAbsolute:(CGPoint)relativePoint;
 
 
@@ -8,18 +8,95 @@
 #import "TUCTouchInputManager.h"
 
 #import "HIDInterpreter.h"
+#import "TUCLog.h"
 #import "TUCCursorUtilities.h"
+#import "TUCTouchTable.h"
+#import "TUCTouchChanges.h"
+#import "TUCMotionPredictor.h"
 
-@interface TUCTouchInputManager ()
+#import <stdatomic.h>
+#import <time.h>
+
+_Static_assert(TUC_MOTION_PREDICTOR_CAPACITY == kTUCTouchTableCapacity, "the predictor is indexed by the slots of the touch table");
+_Static_assert(kTUCTouchSnapshotCapacity == kTUCTouchTableCapacity, "a snapshot holds every slot of the touch table");
+
+
+// ended touches stay in the table for a few frames, the gestures may still look at them (about 0.1 s at 100 frames/s)
+#define kEndedTouchRetireFrames 10
+
+// triple buffer of the snapshots: the exchange slot holds a buffer index, the flag tells the reader it was not acquired yet
+#define kSnapshotIndexMask      0x3u
+#define kSnapshotFresh          0x4u
+
+// one action per TUCCursorGesture bit, index 0 for _TUCCursorGestureNone
+#define kGestureActionCount     9
+
+typedef struct {
+    TUCCursorAction actions[kGestureActionCount];
+} TUCGestureActionMap;
+
+static inline NSUInteger GestureActionIndex(TUCCursorGesture gesture) {
+    return gesture == _TUCCursorGestureNone ? 0 : (NSUInteger)__builtin_ctzl(gesture);
+}
+
+static inline TUCCursorGesture GestureOfActionIndex(NSUInteger index) {
+    return index == 0 ? _TUCCursorGestureNone : (TUCCursorGesture)1 << index;
+}
+
+@interface TUCTouchInputManager () {
+    /**
+     The touches the gestures are evaluated on. Only accessed on the inputQueue, readers see the snapshots.
+     */
+    TUCTouchTable _touchTable;
+    
+    /**
+     Triple buffer: the inputQueue writes _snapshots[_snapshotWriteIndex], the reader owns _snapshots[_snapshotReadIndex],
+     the third one waits in the exchange. Both sides swap their buffer with the exchange, neither ever waits.
+     */
+    TUCTouchSnapshot _snapshots[3];
+    uint32_t _snapshotWriteIndex;
+    uint32_t _snapshotReadIndex;
+    _Atomic uint32_t _snapshotExchange;
+    
+    // touchSet compatibility view, main thread: TUCTouch per serial, so an object keeps its UUID while the touch lives
+    NSDictionary<NSNumber *, TUCTouch *> *_compatibilityTouches;
+    NSSet<TUCTouch *> *_touchSet;
+    NSInteger _touchSetFrameID;
+    
+    // velocity per slot for predictionHorizon
+    TUCMotionPredictor _motionPredictor;
+    
+    // what happened since the last touchesDidChange:, collected per slot and published once per frame
+    TUCTouchMask _addedSlots;
+    TUCTouchMask _movedSlots;
+    TUCTouchMask _endedSlots;
+    
+    /**
+     Frames per touchscreen, the touch timeout counts only frames of the screen a touch is on: an idle panel must not see its
+     touches age while the other one reports. _frameDevice is the screen of the frame in progress.
+     */
+    NSInteger _deviceFrameIDs[kTouchInputManagerMaxDevices];
+    NSInteger _frameDevice;
+    
+    /**
+     What the gestures need to know about the screen and the settings, owned by the inputQueue. The main thread asks the
+     delegate and AppKit in reloadConfiguration and hands the answers over, the inputQueue never calls either of them.
+     */
+    TUCScreen *_screen;                 // a copy, the delegate's screen is changed on the main thread
+    CGFloat _menuBarHeight;
+    TUCGestureActionMap _gestureActions;
+}
 
 @property NSInteger currentFrameID;
+@property NSTimeInterval frameTimestamp; // sample time of the frame in progress, seconds on the mach_absolute_time timeline
 
-@property (weak, nullable) TUCTouch *cursorTouch;
-@property (weak, nullable) TUCTouch *gestureAdditionalTouch;
+// slots in the touch table, kTUCTouchTableNoSlot if none
+@property NSInteger cursorSlot;
+@property NSInteger gestureAdditionalSlot;
 
 @property BOOL cursorTouchQualifiedForTap; // if the cursor entered moving state once it can no longer be interpreted as tap
 @property BOOL cursorTouchDidHold; //
-@property (strong) NSDate *cursorTouchStationarySinceDate;
+@property NSTimeInterval cursorTouchStationarySince; // sample time of the cursor touch when it stopped moving, 0 while moving
 
 @property CGFloat pinchDistance;
 
@@ -36,16 +113,14 @@
     // KRITISCH: Stelle sicher dass postMouseEvents TRUE ist
     self.postMouseEvents = YES;
     
-    printf("[TUCTouchInputManager start] postMouseEvents=%d (FORCED TO YES)\n", self.postMouseEvents);
+    TUCLogInfo(Gesture, "[TUCTouchInputManager start] postMouseEvents=%d (FORCED TO YES)", self.postMouseEvents);
     
-    __weak id weakSelf = self;
+    [self reloadConfiguration];
     
-    // needs to run on main anyway
-//    [NSThread detachNewThreadWithBlock:^{
-//        [NSThread setThreadPriority:1];
-        OpenHIDManager((__bridge void *)(weakSelf));
-//    }];
+    __weak id weakSelf = self;
     
+    // the HID thread decodes the reports, touches and gestures are processed on the inputQueue
+    OpenHIDManager((__bridge void *)(weakSelf), self.inputQueue);
 }
 
 - (void)stop {
@@ -54,83 +129,95 @@
 
 
 - (void)didConnectTouchscreen {
-    [self.delegate touchscreenDidConnect];
+    dispatch_async(dispatch_get_main_queue(), ^{
+        [self.delegate touchscreenDidConnect];
+    });
 }
 
 - (void)didDisconnectTouchscreen {
-    [self.delegate touchscreenDidDisconnect];
+    dispatch_async(dispatch_get_main_queue(), ^{
+        [self.delegate touchscreenDidDisconnect];
+    });
 }
 
 
 
 #pragma mark - Reacting to HID Events
 
+/**
+ A whole frame from the HID layer in one call: updates all touches in the order of the array, then runs the frame logic once.
+ */
+- (void)processFrame:(const TouchInputManagerContact *)contacts count:(NSInteger)count device:(NSInteger)device timestamp:(NSTimeInterval)timestamp {
+    NSAssert(device >= 0 && device < kTouchInputManagerMaxDevices, @"device %ld out of range", (long)device);
+    _frameDevice = device;
+    
+    for (NSInteger i = 0; i < count; i++) {
+        const TouchInputManagerContact *contact = &contacts[i];
+        
+        [self updateTouch:contact->contactID withLocation:CGPointMake(contact->x, contact->y) onSurface:contact->onSurface
+        tooLargeForFinger:contact->isValid timestamp:(NSTimeInterval)contact->timestamp / NSEC_PER_SEC];
+        
+        if (contact->onSurface && contact->width >= 0 && contact->height >= 0) {
+            [self updateTouch:contact->contactID withSize:CGSizeMake(contact->width, contact->height) azimuth:contact->azimuth];
+        }
+    }
+    
+    self.frameTimestamp = timestamp;
+    [self didProcessReport];
+    _frameDevice = 0;
+}
+
+
 - (void)didProcessReport {
-    // go through all touches: if the frame is not the latest one, the touch might be old and should be removed.
+    TUCTouchTable *table = &_touchTable;
+    
+    NSInteger device = _frameDevice;
+    NSInteger deviceFrameID = _deviceFrameIDs[device];
     
-    NSArray *touchesArray = [[self.touchSet copy] allObjects];
-    for (TUCTouch *touch in touchesArray) {
+    // go through the active touches of this frame's screen: if the frame is not the latest one, the touch might be old and should be removed.
+    for (TUCTouchMask mask = table->activeMask; mask != 0; mask &= mask - 1) {
+        NSInteger slot = TUCTouchMaskFirst(mask);
+        if (table->device[slot] != device) {
+            continue;
+        }
         
-        if (touch.lastUpdated + self.errorResistance < self.currentFrameID) {
-            printf("[TOUCH TIMEOUT] contactID=%ld lastUpdated=%ld currentFrame=%ld errorResistance=%ld\n",
-                   (long)touch.contactID, (long)touch.lastUpdated, (long)self.currentFrameID, (long)self.errorResistance);
-            [touch setPhase:NSTouchPhaseCancelled];
+        if (table->deviceFrame[slot] + self.errorResistance < deviceFrameID) {
+            TUCLogDebug(Touch, "[TOUCH TIMEOUT] contactID=%ld device=%ld lastUpdated=%ld currentFrame=%ld errorResistance=%ld",
+                        (long)table->contactID[slot], (long)device, (long)table->deviceFrame[slot], (long)deviceFrameID, (long)self.errorResistance);
+            TUCTouchTableSetPhase(table, slot, NSTouchPhaseCancelled);
+            _endedSlots |= 1ull << slot;
             
             // CRITICAL: Wenn dieser Touch der cursorTouch ist, müssen wir ihn auf nil setzen
-            if (self.cursorTouch && touch.uuid == self.cursorTouch.uuid) {
-                printf("[CURSOR CLEARED BY TIMEOUT] contactID=%ld - resetting cursorTouch\n", (long)touch.contactID);
-                self.cursorTouch = nil;
+            if (slot == self.cursorSlot) {
+                TUCLogDebug(Touch, "[CURSOR CLEARED BY TIMEOUT] contactID=%ld - resetting cursorTouch", (long)table->contactID[slot]);
+                self.cursorSlot = kTUCTouchTableNoSlot;
             }
             
             // CRITICAL: Auch gestureAdditionalTouch bereinigen
-            if (self.gestureAdditionalTouch && touch.uuid == self.gestureAdditionalTouch.uuid) {
-                printf("[GESTURE CLEARED BY TIMEOUT] contactID=%ld - resetting gestureAdditionalTouch\n", (long)touch.contactID);
-                self.gestureAdditionalTouch = nil;
+            if (slot == self.gestureAdditionalSlot) {
+                TUCLogDebug(Touch, "[GESTURE CLEARED BY TIMEOUT] contactID=%ld - resetting gestureAdditionalTouch", (long)table->contactID[slot]);
+                self.gestureAdditionalSlot = kTUCTouchTableNoSlot;
             }
             
-            [self removeTouch:touch now:NO];
+            [self retireTouchInSlot:slot];
         }
     }
     
-    if ([[self activeTouches] count] == 0) {
+    if (table->activeMask == 0) {
         [self stopCurrentGesture];
-        
-        // RADICAL FIX: Wenn KEINE aktiven Touches mehr → touchSet KOMPLETT leeren
-        // Das verhindert Ghost-Touches und garantiert sauberen Neustart
-        if ([self.touchSet count] > 0) {
-            printf("[RADICAL CLEANUP] Keine aktiven Touches → lösche ALLE %ld Touches aus touchSet\n", 
-                   (long)[self.touchSet count]);
-            [self.touchSet removeAllObjects];
-            [[self delegate] touchesDidChange];
-        }
     }
     
-    // CRITICAL FIX: Proaktive Bereinigung wenn touchSet zu groß wird
-    // Bei 10 Fingern kann das Set auf 20+ Touches wachsen wenn Removal nicht schnell genug ist
-    NSInteger touchSetSize = [self.touchSet count];
-    NSInteger activeCount = [[self activeTouches] count];
+    // the IDs of the touches that ended in this frame are collected before the sweep may free their slots
+    TUCTouchChanges *changes = [self takeTouchChanges];
+    BOOL didRemoveTouches = [self sweepRetiredTouches];
     
-    if (touchSetSize > 10 || (touchSetSize > activeCount + 3)) {
-        NSMutableArray *staleToRemove = [NSMutableArray array];
-        for (TUCTouch *t in self.touchSet) {
-            if (t.phase == NSTouchPhaseEnded || t.phase == NSTouchPhaseCancelled) {
-                [staleToRemove addObject:t];
-            }
-        }
-        
-        if ([staleToRemove count] > 0) {
-            printf("[PROACTIVE CLEANUP] touchSet zu groß (%ld total, %ld active) - entferne %ld ENDED/CANC: ",
-                   touchSetSize, activeCount, (long)[staleToRemove count]);
-            for (TUCTouch *t in staleToRemove) {
-                printf("ID=%ld ", (long)t.contactID);
-                [self.touchSet removeObject:t];
-            }
-            printf("\n");
-            [[self delegate] touchesDidChange];
-        }
+    [self publishTouchSnapshot];
+    if (changes || didRemoveTouches) {
+        [self notifyTouchesDidChange:changes ?: [[TUCTouchChanges alloc] init]];
     }
     
     ++self.currentFrameID;
+    ++_deviceFrameIDs[device];
     
     [self processTouchesForCursorInput];
     
@@ -149,14 +236,10 @@
 /**
  Most important event handling callback: it posts the events to the system where the touches need to go
  */
-- (void)updateTouch:(NSInteger)contactID withLocation:(CGPoint)digitizerPoint onSurface:(BOOL)isOnSurface tooLargeForFinger:(BOOL)confidenceFlag {
+- (void)updateTouch:(NSInteger)contactID withLocation:(CGPoint)digitizerPoint onSurface:(BOOL)isOnSurface tooLargeForFinger:(BOOL)confidenceFlag timestamp:(NSTimeInterval)timestamp {
     
-    // Debug: Zeige ALLE updateTouch Aufrufe
-    static int updateCount = 0;
-    if (++updateCount % 100 == 0) {
-        printf("[updateTouch] #%d contactID=%ld point=(%.2f,%.2f) onSurface=%d confidence=%d\n",
-               updateCount, (long)contactID, digitizerPoint.x, digitizerPoint.y, isOnSurface, confidenceFlag);
-    }
+    TUCLogTrace(Touch, "[updateTouch] contactID=%ld point=(%.2f,%.2f) onSurface=%d confidence=%d",
+                (long)contactID, digitizerPoint.x, digitizerPoint.y, isOnSurface, confidenceFlag);
     
     // assume that this is an erroneous message!!!
     if (self.ignoreOriginTouches && CGPointEqualToPoint(digitizerPoint, CGPointZero)) {
@@ -166,71 +249,93 @@
     CGPoint point = [self convertDigitizerPointToRelativeScreenPoint:digitizerPoint];
     
     BOOL isNewTouch = NO;
-    TUCTouch *touch = [self obtainTouchWithID:contactID isNew:&isNewTouch];
+    NSInteger slot = [self obtainTouchWithID:contactID isNew:&isNewTouch];
+    if (slot == kTUCTouchTableNoSlot) {
+        TUCLogWarning(Touch, "[TOUCH TABLE FULL] contactID=%ld ignored", (long)contactID);
+        return;
+    }
     
     if (isNewTouch) {
-        printf("[NEW TOUCH] contactID=%ld confidenceFlag=%d onSurface=%d\n", (long)contactID, confidenceFlag, isOnSurface);
+        TUCLogDebug(Touch, "[NEW TOUCH] contactID=%ld confidenceFlag=%d onSurface=%d", (long)contactID, confidenceFlag, isOnSurface);
+        _addedSlots |= 1ull << slot;
     }
     
     // CRITICAL FIX: KEINE cursorTouch-Zuweisung hier!
     // Das wird ausschließlich in processTouchesForCursorInput gemacht
     // Diese Logik hat zu "ID bleibt bei 1 stecken" geführt
     
-    [touch setLocation: point];
-    [touch setIsOnSurface:isOnSurface];
-    [touch setConfidenceFlag:confidenceFlag];
-    [touch setLastUpdated:self.currentFrameID];
+    TUCTouchTable *table = &_touchTable;
+    TUCTouchTableSetLocation(table, slot, point, timestamp);
+    TUCMotionPredictorUpdate(&_motionPredictor, (int)slot, point.x, point.y, timestamp);
+    table->isOnSurface[slot] = isOnSurface;
+    table->confidenceFlag[slot] = confidenceFlag;
+    table->lastUpdated[slot] = self.currentFrameID;
+    table->device[slot] = _frameDevice;
+    table->deviceFrame[slot] = _deviceFrameIDs[_frameDevice];
     
     if (!isOnSurface) {
-        [touch setPhase: NSTouchPhaseEnded];
+        TUCTouchTableSetPhase(table, slot, NSTouchPhaseEnded);
+        _endedSlots |= 1ull << slot;
         
         // Nicht hier cursorTouch auf nil setzen! Das wird in processTouchesForCursorInput gemacht
         // nachdem die ENDED-Phase verarbeitet wurde
-        if (touch.uuid == self.cursorTouch.uuid) {
-            printf("[CURSOR ENDING] contactID=%ld phase=ENDED (wird in processTouches verarbeitet)\n", (long)contactID);
+        if (slot == self.cursorSlot) {
+            TUCLogDebug(Touch, "[CURSOR ENDING] contactID=%ld phase=ENDED (wird in processTouches verarbeitet)", (long)contactID);
         }
         
         // Touch mit Verzögerung entfernen (damit Phasen-Tracking funktioniert)
-        [self removeTouch:touch now:NO];
-        [self.delegate touchesDidChange];
+        [self retireTouchInSlot:slot];
         return;
         
     }
     
-    if(touch.previousPhase != NSTouchPhaseEnded && !isNewTouch) {
+    if(table->previousPhase[slot] != NSTouchPhaseEnded && !isNewTouch) {
         // update to an existing touch... check if stationary or not
-        CGFloat digitizerRelDistance = sqrt(pow(touch.location.x - touch.previousLocation.x, 2) + pow(touch.location.y - touch.previousLocation.y, 2));
-        CGFloat screenSize = [self touchscreen].physicalSize.width;
-        BOOL isStationary = (digitizerRelDistance * screenSize) < 0.1;
-//        BOOL isStationary = CGPointEqualToPoint(touch.location, touch.previousLocation);
+        // less than 0.1 mm, compared squared
+        CGFloat dx = table->location[slot].x - table->previousLocation[slot].x;
+        CGFloat dy = table->location[slot].y - table->previousLocation[slot].y;
+        CGFloat threshold = 0.1 / [self touchscreen].physicalSize.width;
+        BOOL isStationary = dx * dx + dy * dy < threshold * threshold;
+//        BOOL isStationary = CGPointEqualToPoint(table->location[slot], table->previousLocation[slot]);
         
-        if (touch.uuid == self.cursorTouch.uuid) {
+        if (slot == self.cursorSlot) {
             if (!isStationary) {
                 self.cursorTouchQualifiedForTap = NO;
-                self.cursorTouchStationarySinceDate = nil;
+                self.cursorTouchStationarySince = 0;
+                
+            } else if (table->phase[slot] !=  NSTouchPhaseStationary) {
+                self.cursorTouchStationarySince = table->timestamp[slot];
                 
-            } else if (touch.phase !=  NSTouchPhaseStationary) {
-                self.cursorTouchStationarySinceDate = [NSDate date];
+            } else if (self.cursorTouchStationarySince > 0
+                       && table->timestamp[slot] - self.cursorTouchStationarySince >= self.holdDuration) {
+                // measured between device samples, so main run loop delays do not shorten or stretch the hold
+                self.cursorTouchDidHold = YES;
             }
         }
         
-        [touch setPhase:isStationary ? NSTouchPhaseStationary : NSTouchPhaseMoved];
+        TUCTouchTableSetPhase(table, slot, isStationary ? NSTouchPhaseStationary : NSTouchPhaseMoved);
+        if (!isStationary) {
+            _movedSlots |= 1ull << slot;
+        }
     }
     
-    
-    [self.delegate touchesDidChange];
-    
     return;
 }
 
 
+/**
+ Size relative to the screen. Only touches the position update has started get a size, it never starts a touch on its own.
+ */
 - (void)updateTouch:(NSInteger)contactID withSize:(CGSize)size azimuth:(CGFloat)azimuth {
-    BOOL isNewTouch = NO;
-    TUCTouch *touch = [self obtainTouchWithID:contactID isNew:&isNewTouch];
-    [touch setLastUpdated:self.currentFrameID];
+    NSInteger slot = [self findTouchWithID:contactID includingPastTouches:NO];
+    if (slot == kTUCTouchTableNoSlot) {
+        return;
+    }
     
-    [touch setSize:size];
-    [touch setAzimuth:azimuth];
+    _touchTable.lastUpdated[slot] = self.currentFrameID;
+    _touchTable.deviceFrame[slot] = _deviceFrameIDs[_touchTable.device[slot]];
+    _touchTable.size[slot] = size;
+    _touchTable.azimuth[slot] = azimuth;
 }
 
 
@@ -245,48 +350,51 @@
         return;
     }
     
-    NSSet *activeTouches = [self activeTouches];
-    NSInteger activeTouchCount = [activeTouches count];
-    NSInteger totalTouchCount = [self.touchSet count];
+    TUCTouchTable *table = &_touchTable;
+    TUCTouchMask activeTouches = table->activeMask;
+    NSInteger activeTouchCount = TUCTouchMaskCount(activeTouches);
+    NSInteger totalTouchCount = TUCTouchMaskCount(TUCTouchTableUsedMask(table));
     
     // DEBUG: Zeige ALLE Touches in touchSet + ihre Phasen
-    NSMutableString *touchSetDebug = [NSMutableString stringWithFormat:@"[TOUCHSET] %ld total, %ld active: ", totalTouchCount, activeTouchCount];
-    for (TUCTouch *t in self.touchSet) {
-        NSString *phaseStr;
-        switch (t.phase) {
-            case NSTouchPhaseBegan: phaseStr = @"BEGAN"; break;
-            case NSTouchPhaseStationary: phaseStr = @"STAT"; break;
-            case NSTouchPhaseMoved: phaseStr = @"MOVED"; break;
-            case NSTouchPhaseEnded: phaseStr = @"ENDED"; break;
-            case NSTouchPhaseCancelled: phaseStr = @"CANC"; break;
-            default: phaseStr = @"UNK"; break;
+    if (TUCLogIsEnabled(TUCLogLevelTrace, TUCLogCategoryGesture)) {
+        TUCLogTrace(Gesture, "[TOUCHSET] %ld total, %ld active", (long)totalTouchCount, (long)activeTouchCount);
+        for (TUCTouchMask mask = TUCTouchTableUsedMask(table); mask != 0; mask &= mask - 1) {
+            NSInteger slot = TUCTouchMaskFirst(mask);
+            const char *phaseStr;
+            switch (table->phase[slot]) {
+                case NSTouchPhaseBegan: phaseStr = "BEGAN"; break;
+                case NSTouchPhaseStationary: phaseStr = "STAT"; break;
+                case NSTouchPhaseMoved: phaseStr = "MOVED"; break;
+                case NSTouchPhaseEnded: phaseStr = "ENDED"; break;
+                case NSTouchPhaseCancelled: phaseStr = "CANC"; break;
+                default: phaseStr = "UNK"; break;
+            }
+            TUCLogTrace(Gesture, "[TOUCHSET]   ID=%ld:%s", (long)table->contactID[slot], phaseStr);
         }
-        [touchSetDebug appendFormat:@"(ID=%ld:%s) ", (long)t.contactID, [phaseStr UTF8String]];
     }
-    printf("%s\n", [touchSetDebug UTF8String]);
     
     // FORCE VALIDATION: Bei jedem Call überprüfen
     // Wenn cursorTouch nicht mehr in activeTouches ist → auf nil setzen
-    if (self.cursorTouch && ![activeTouches containsObject:self.cursorTouch]) {
-        printf("[VALIDATION FAIL] cursorTouch (ID=%ld) nicht in activeTouches - RESET\n", 
-               (long)self.cursorTouch.contactID);
-        self.cursorTouch = nil;
-        self.gestureAdditionalTouch = nil;
+    if (self.cursorSlot != kTUCTouchTableNoSlot && !TUCTouchTableIsActive(table, self.cursorSlot)) {
+        TUCLogDebug(Gesture, "[VALIDATION FAIL] cursorTouch (ID=%ld) nicht in activeTouches - RESET",
+                    (long)table->contactID[self.cursorSlot]);
+        self.cursorSlot = kTUCTouchTableNoSlot;
+        self.gestureAdditionalSlot = kTUCTouchTableNoSlot;
     }
     
     // Auch gestureAdditionalTouch validieren
-    if (self.gestureAdditionalTouch && ![activeTouches containsObject:self.gestureAdditionalTouch]) {
-        printf("[VALIDATION FAIL] gestureAdditionalTouch (ID=%ld) nicht in activeTouches - RESET\n", 
-               (long)self.gestureAdditionalTouch.contactID);
-        self.gestureAdditionalTouch = nil;
+    if (self.gestureAdditionalSlot != kTUCTouchTableNoSlot && !TUCTouchTableIsActive(table, self.gestureAdditionalSlot)) {
+        TUCLogDebug(Gesture, "[VALIDATION FAIL] gestureAdditionalTouch (ID=%ld) nicht in activeTouches - RESET",
+                    (long)table->contactID[self.gestureAdditionalSlot]);
+        self.gestureAdditionalSlot = kTUCTouchTableNoSlot;
     }
     
     // Wenn KEINE Touches aktiv sind → sofort komplett zurücksetzen
     if (activeTouchCount == 0) {
-        if (self.cursorTouch) {
-            printf("[NO TOUCHES] Alle Fingers hochgehoben - RESET cursorTouch\n");
-            self.cursorTouch = nil;
-            self.gestureAdditionalTouch = nil;
+        if (self.cursorSlot != kTUCTouchTableNoSlot) {
+            TUCLogDebug(Gesture, "[NO TOUCHES] Alle Fingers hochgehoben - RESET cursorTouch");
+            self.cursorSlot = kTUCTouchTableNoSlot;
+            self.gestureAdditionalSlot = kTUCTouchTableNoSlot;
         }
         return;
     }
@@ -294,71 +402,74 @@
     // CRITICAL FIX: Bei nur 1 aktivem Touch IMMER cursorTouch neu zuweisen
     // Das verhindert "ID bleibt bei 1 stecken" nach Multi-Touch
     if (activeTouchCount == 1) {
-        TUCTouch *onlyTouch = [activeTouches anyObject];
-        if (!self.cursorTouch || self.cursorTouch.contactID != onlyTouch.contactID) {
-            printf("[SINGLE TOUCH] Erzwinge cursorTouch=ID=%ld (war %s)\n", 
-                   (long)onlyTouch.contactID,
-                   self.cursorTouch ? [[NSString stringWithFormat:@"ID=%ld", (long)self.cursorTouch.contactID] UTF8String] : "nil");
-            self.cursorTouch = onlyTouch;
+        NSInteger onlySlot = TUCTouchMaskFirst(activeTouches);
+        if (self.cursorSlot == kTUCTouchTableNoSlot || table->contactID[self.cursorSlot] != table->contactID[onlySlot]) {
+            TUCLogDebug(Gesture, "[SINGLE TOUCH] Erzwinge cursorTouch=ID=%ld (war ID=%ld, -1 = nil)",
+                        (long)table->contactID[onlySlot],
+                        self.cursorSlot != kTUCTouchTableNoSlot ? (long)table->contactID[self.cursorSlot] : -1L);
+            self.cursorSlot = onlySlot;
             self.cursorTouchQualifiedForTap = YES;
             self.cursorTouchDidHold = NO;
-            self.cursorTouchStationarySinceDate = nil;
-            self.gestureAdditionalTouch = nil; // Kein zweiter Finger mehr
+            self.cursorTouchStationarySince = 0;
+            self.gestureAdditionalSlot = kTUCTouchTableNoSlot; // Kein zweiter Finger mehr
         }
         return;
     }
     
     // Wenn kein cursorTouch → assign den mit niedrigster contactID
-    if (!self.cursorTouch) {
-        TUCTouch *lowestIDTouch = nil;
+    if (self.cursorSlot == kTUCTouchTableNoSlot) {
+        NSInteger lowestIDSlot = kTUCTouchTableNoSlot;
         NSInteger minID = LLONG_MAX;
-        for (TUCTouch *touch in activeTouches) {
-            if (touch.contactID < minID) {
-                minID = touch.contactID;
-                lowestIDTouch = touch;
+        for (TUCTouchMask mask = activeTouches; mask != 0; mask &= mask - 1) {
+            NSInteger slot = TUCTouchMaskFirst(mask);
+            if (table->contactID[slot] < minID) {
+                minID = table->contactID[slot];
+                lowestIDSlot = slot;
             }
         }
         
-        if (lowestIDTouch) {
-            self.cursorTouch = lowestIDTouch;
+        if (lowestIDSlot != kTUCTouchTableNoSlot) {
+            self.cursorSlot = lowestIDSlot;
             self.cursorTouchQualifiedForTap = YES;
             self.cursorTouchDidHold = NO;
-            self.cursorTouchStationarySinceDate = nil;
-            printf("[NEW CURSOR] Zugewiesen contactID=%ld (lowest of %ld touches)\n", 
-                   (long)lowestIDTouch.contactID, (long)activeTouchCount);
+            self.cursorTouchStationarySince = 0;
+            TUCLogDebug(Gesture, "[NEW CURSOR] Zugewiesen contactID=%ld (lowest of %ld touches)",
+                        (long)minID, (long)activeTouchCount);
         }
         return;
     }
     
     // Jetzt haben wir definitiv einen gültigen cursorTouch
-    TUCTouch *cursorTouch = self.cursorTouch;
-    NSTouchPhase phase = cursorTouch.phase;
+    NSInteger cursorSlot = self.cursorSlot;
+    NSInteger cursorContactID = table->contactID[cursorSlot];
+    NSTouchPhase phase = table->phase[cursorSlot];
     
-    printf("[PROCESS] cursor=%ld phase=%ld activeTouches=%ld\n", 
-           (long)cursorTouch.contactID, (long)phase, activeTouchCount);
+    TUCLogTrace(Gesture, "[PROCESS] cursor=%ld phase=%ld activeTouches=%ld",
+                (long)cursorContactID, (long)phase, activeTouchCount);
     
     // Zwei-Finger-Gestenerkennung (wenn 2+ Finger aktiv und noch keine gestureAdditionalTouch)
-    if (activeTouchCount >= 2 && !self.gestureAdditionalTouch) {
-        for (TUCTouch *touch in activeTouches) {
-            if (touch.contactID != cursorTouch.contactID) {
-                self.gestureAdditionalTouch = touch;
-                printf("[GESTURE DETECTED] zweiter Finger erkannt: cursor=%ld, additional=%ld\n",
-                       (long)cursorTouch.contactID, (long)touch.contactID);
+    if (activeTouchCount >= 2 && self.gestureAdditionalSlot == kTUCTouchTableNoSlot) {
+        for (TUCTouchMask mask = activeTouches; mask != 0; mask &= mask - 1) {
+            NSInteger slot = TUCTouchMaskFirst(mask);
+            if (table->contactID[slot] != cursorContactID) {
+                self.gestureAdditionalSlot = slot;
+                TUCLogDebug(Gesture, "[GESTURE DETECTED] zweiter Finger erkannt: cursor=%ld, additional=%ld",
+                            (long)cursorContactID, (long)table->contactID[slot]);
                 break;
             }
         }
     }
     
     // Wenn weniger als 2 Finger → lösche gestureAdditionalTouch
-    if (activeTouchCount < 2 && self.gestureAdditionalTouch) {
-        printf("[GESTURE CLEARED] nur noch %ld Touch(es)\n", activeTouchCount);
-        self.gestureAdditionalTouch = nil;
+    if (activeTouchCount < 2 && self.gestureAdditionalSlot != kTUCTouchTableNoSlot) {
+        TUCLogDebug(Gesture, "[GESTURE CLEARED] nur noch %ld Touch(es)", activeTouchCount);
+        self.gestureAdditionalSlot = kTUCTouchTableNoSlot;
     }
     
     // ==== PHASE PROCESSING ====
     
     if (phase == NSTouchPhaseBegan) {
-        printf("[BEGAN] contactID=%ld\n", (long)cursorTouch.contactID);
+        TUCLogDebug(Gesture, "[BEGAN] contactID=%ld", (long)cursorContactID);
         self.cursorTouchQualifiedForTap = YES;
         return;
     }
@@ -369,45 +480,45 @@
     }
     
     else if (phase == NSTouchPhaseMoved) {
-        if (self.gestureAdditionalTouch && activeTouchCount >= 2) {
-            printf("[MOVED] zwei-finger drag\n");
+        if (self.gestureAdditionalSlot != kTUCTouchTableNoSlot && activeTouchCount >= 2) {
+            TUCLogTrace(Gesture, "[MOVED] zwei-finger drag");
             [self performMouseEventForGesture:TUCCursorGestureTwoFingerDrag];
         } else {
             self.cursorTouchQualifiedForTap = NO;
-            printf("[MOVED] ein-finger drag\n");
+            TUCLogTrace(Gesture, "[MOVED] ein-finger drag");
             [self performMouseEventForGesture:TUCCursorGestureDrag];
         }
         return;
     }
     
     else if (phase == NSTouchPhaseEnded) {
-        printf("[ENDED] contactID=%ld qualified=%d\n", (long)cursorTouch.contactID, self.cursorTouchQualifiedForTap);
+        TUCLogDebug(Gesture, "[ENDED] contactID=%ld qualified=%d", (long)cursorContactID, self.cursorTouchQualifiedForTap);
         
         // Sende das entsprechende Event
         if (self.cursorTouchQualifiedForTap) {
-            printf("        → sende TAP\n");
+            TUCLogDebug(Gesture, "        → sende TAP");
             [self performMouseEventForGesture:TUCCursorGestureTap];
         } else {
-            printf("        → sende DRAG END\n");
+            TUCLogDebug(Gesture, "        → sende DRAG END");
             [self performMouseEventForGesture:TUCCursorGestureDrag];
         }
         
         [self stopCurrentGesture];
         
         // KRITISCH: SOFORT cursorTouch auf nil, damit nächster Touch neu zugewiesen wird
-        self.cursorTouch = nil;
-        self.gestureAdditionalTouch = nil;
-        printf("        → cursorTouch RESET zu nil\n");
+        self.cursorSlot = kTUCTouchTableNoSlot;
+        self.gestureAdditionalSlot = kTUCTouchTableNoSlot;
+        TUCLogDebug(Gesture, "        → cursorTouch RESET zu nil");
         return;
     }
     
     else if (phase == NSTouchPhaseCancelled) {
-        printf("[CANCELLED] contactID=%ld\n", (long)cursorTouch.contactID);
+        TUCLogDebug(Gesture, "[CANCELLED] contactID=%ld", (long)cursorContactID);
         [self stopCurrentGesture];
         
-        self.cursorTouch = nil;
-        self.gestureAdditionalTouch = nil;
-        printf("        → cursorTouch RESET zu nil\n");
+        self.cursorSlot = kTUCTouchTableNoSlot;
+        self.gestureAdditionalSlot = kTUCTouchTableNoSlot;
+        TUCLogDebug(Gesture, "        → cursorTouch RESET zu nil");
         return;
     }
 }
@@ -420,116 +531,119 @@
 
 
 - (void)performMouseEventForGesture:(TUCCursorGesture)gesture {
-    // CRITICAL: Dies wird vom HID-Queue-Callback aufgerufen, welcher auf einem Background-Thread läuft.
-    // CGEventPost MUSS auf dem Main Thread ausgeführt werden!
+    // Läuft auf der inputQueue, direkt im Frame der die Geste ausgelöst hat.
+    // CGEventPost ist thread-safe, der Umweg über den Main Thread kostete bis zu einen Frame Latenz.
+    // Moves und Drags postet der TUCOutputScheduler einmal pro Display-Refresh, alles andere sofort.
     
-    __weak typeof(self) weakSelf = self;
+    NSInteger slot = self.cursorSlot;
+    NSInteger additionalSlot = self.gestureAdditionalSlot;
     
-    dispatch_async(dispatch_get_main_queue(), ^{
-        __strong typeof(weakSelf) strongSelf = weakSelf;
-        if (!strongSelf) return;
-        
-        TUCTouch *touch = strongSelf.cursorTouch;
-        
-        // CRITICAL: Null-check - wenn cursorTouch zwischen Aufruf und Dispatch gelöscht wurde
-        if (!touch) return;
-        
-        CGPoint screenLocation = [strongSelf convertScreenPointRelativeToAbsolute:touch.location];
-        CGPoint location2ndFinger = CGPointZero;
-        if (strongSelf.gestureAdditionalTouch) {
-            location2ndFinger = [strongSelf convertScreenPointRelativeToAbsolute:strongSelf.gestureAdditionalTouch.location];
-        }
-        
-        TUCCursorUtilities *utils = [TUCCursorUtilities sharedInstance];
-        
-        TUCCursorAction action = [strongSelf actionForGesture:gesture];
-       
-           // Log detected gestures  
-           NSString *actionName = @"Unknown";
-           switch (action) {
-               case TUCCursorActionNone:           actionName = @"None"; break;
-               case TUCCursorActionMove:           actionName = @"Move"; break;
-               case TUCCursorActionMoveClickIfNeeded: actionName = @"MoveClickIfNeeded"; break;
-               case TUCCursorActionPointAndClick:  actionName = @"PointAndClick"; break;
-               case TUCCursorActionDrag:           actionName = @"Drag"; break;
-               case TUCCursorActionClick:          actionName = @"Click"; break;
-               case TUCCursorActionSecondaryClick: actionName = @"SecondaryClick"; break;
-               case TUCCursorActionScroll:         actionName = @"Scroll"; break;
-               case TUCCursorActionMagnify:        actionName = @"Magnify"; break;
-           }
-       
-           if (action != TUCCursorActionMove && action != TUCCursorActionMoveClickIfNeeded) {
-               printf("[GESTURE] %s at (%.0f, %.0f)\n", [actionName UTF8String], screenLocation.x, screenLocation.y);
-           }
-        
-        CGFloat doubleClickSpan = strongSelf.doubleClickTolerance * [[strongSelf touchscreen] pixelsPerMM];
-        [[TUCCursorUtilities sharedInstance] setDoubleClickTolerance:doubleClickSpan];
-        
-        switch (action) {
-            case TUCCursorActionNone:
-                break;
-                
-            case TUCCursorActionMove:
-                [utils moveCursorTo:screenLocation];
-                break;
-                
-            case TUCCursorActionMoveClickIfNeeded:
-                [utils moveCursorTo:screenLocation];
-                if ([strongSelf isLocationOutsideFrontmostWindow:screenLocation]) {
-                    [utils performClickAt:screenLocation];
-                }
-                
-                break;
-                
-            case TUCCursorActionPointAndClick:
-                [utils moveCursorTo:screenLocation];
-                if (touch.phase == NSTouchPhaseEnded) {
-                    [utils performClickAt:screenLocation];
-                }
-                break;
-                
-            case TUCCursorActionDrag:
-                [utils dragCursorTo:screenLocation phase:touch.phase];
-                break;
-                
-            case TUCCursorActionClick:
-                [utils performClickAt:screenLocation];
-                break;
-                
-            case TUCCursorActionSecondaryClick:
-                [utils performSecondaryClickAt: screenLocation];
-                break;
-                
-            case TUCCursorActionScroll: {
-                CGPoint prevLocation = [strongSelf convertScreenPointRelativeToAbsolute:touch.previousLocation];
-                CGPoint translation = CGPointMake(screenLocation.x - prevLocation.x,
-                                                  screenLocation.y - prevLocation.y);
-                [utils scroll:translation phase:touch.phase];
+    // CRITICAL: Null-check - cursorTouch kann bereits entfernt sein
+    if (slot == kTUCTouchTableNoSlot) return;
+    
+    const TUCTouchTable *table = &_touchTable;
+    NSTouchPhase phase = table->phase[slot];
+    
+    CGPoint screenLocation = [self convertScreenPointRelativeToAbsolute:table->location[slot]];
+    CGPoint cursorLocation = [self convertScreenPointRelativeToAbsolute:[self predictedLocationForSlot:slot]];
+    CGPoint location2ndFinger = CGPointZero;
+    if (additionalSlot != kTUCTouchTableNoSlot) {
+        location2ndFinger = [self convertScreenPointRelativeToAbsolute:table->location[additionalSlot]];
+    }
+    
+    TUCCursorUtilities *utils = [TUCCursorUtilities sharedInstance];
+    utils.inputTimestamp = self.frameTimestamp;
+    
+    TUCCursorAction action = [self actionForGesture:gesture];
+   
+       // Log detected gestures  
+       const char *actionName = "Unknown";
+       switch (action) {
+           case TUCCursorActionNone:           actionName = "None"; break;
+           case TUCCursorActionMove:           actionName = "Move"; break;
+           case TUCCursorActionMoveClickIfNeeded: actionName = "MoveClickIfNeeded"; break;
+           case TUCCursorActionPointAndClick:  actionName = "PointAndClick"; break;
+           case TUCCursorActionDrag:           actionName = "Drag"; break;
+           case TUCCursorActionClick:          actionName = "Click"; break;
+           case TUCCursorActionSecondaryClick: actionName = "SecondaryClick"; break;
+           case TUCCursorActionScroll:         actionName = "Scroll"; break;
+           case TUCCursorActionMagnify:        actionName = "Magnify"; break;
+       }
+   
+       if (action != TUCCursorActionMove && action != TUCCursorActionMoveClickIfNeeded) {
+           TUCLogDebug(Gesture, "[GESTURE] %s at (%.0f, %.0f)", actionName, screenLocation.x, screenLocation.y);
+       }
+    
+    CGFloat doubleClickSpan = self.doubleClickTolerance * [[self touchscreen] pixelsPerMM];
+    [[TUCCursorUtilities sharedInstance] setDoubleClickTolerance:doubleClickSpan];
+    
+    switch (action) {
+        case TUCCursorActionNone:
+            break;
             
-            break; }
+        case TUCCursorActionMove:
+            [utils moveCursorTo:cursorLocation];
+            break;
             
-        case TUCCursorActionMagnify:
-            if (strongSelf.cursorTouch && strongSelf.gestureAdditionalTouch) {
-                [utils magnifyLocationA:screenLocation
-                              locationB:location2ndFinger
-                        relativeP1:strongSelf.cursorTouch.location relP2:strongSelf.gestureAdditionalTouch.location];
+        case TUCCursorActionMoveClickIfNeeded:
+            [utils moveCursorTo:cursorLocation];
+            if (![self isPointInMenuBar:screenLocation]) {
+                [self clickIfOutsideFrontmostWindow:screenLocation];
             }
             
-            if (touch.phase == NSTouchPhaseEnded || strongSelf.gestureAdditionalTouch.phase == NSTouchPhaseEnded) {
-                [utils stopMagnifying];
+            break;
+            
+        case TUCCursorActionPointAndClick:
+            [utils moveCursorTo:cursorLocation];
+            if (phase == NSTouchPhaseEnded) {
+                [utils performClickAt:screenLocation];
             }
             break;
+            
+        case TUCCursorActionDrag:
+            [utils dragCursorTo:cursorLocation phase:phase];
+            break;
+            
+        case TUCCursorActionClick:
+            [utils performClickAt:screenLocation];
+            break;
+            
+        case TUCCursorActionSecondaryClick:
+            [utils performSecondaryClickAt: screenLocation];
+            break;
+            
+        case TUCCursorActionScroll: {
+            CGPoint prevLocation = [self convertScreenPointRelativeToAbsolute:table->previousLocation[slot]];
+            CGPoint translation = CGPointMake(screenLocation.x - prevLocation.x,
+                                              screenLocation.y - prevLocation.y);
+            [utils scroll:translation phase:phase];
+        
+        break; }
+        
+    case TUCCursorActionMagnify:
+        if (additionalSlot != kTUCTouchTableNoSlot) {
+            [utils magnifyLocationA:screenLocation
+                          locationB:location2ndFinger
+                    relativeP1:table->location[slot] relP2:table->location[additionalSlot]];
         }
-    });
+        
+        if (phase == NSTouchPhaseEnded || (additionalSlot != kTUCTouchTableNoSlot && table->phase[additionalSlot] == NSTouchPhaseEnded)) {
+            [utils stopMagnifying];
+        }
+        break;
+    }
 }
 
 
 - (TUCCursorAction)actionForGesture:(TUCCursorGesture)gesture {
-    
-    if (self.delegate != nil) {
-        return [self.delegate actionForGesture:gesture];
-    }
-    
+    return _gestureActions.actions[GestureActionIndex(gesture)];
+}
+
+
+/**
+ Used if there is no delegate.
+ */
+- (TUCCursorAction)defaultActionForGesture:(TUCCursorGesture)gesture {
     // Vereinfachte Gesten: Klick, Ziehen, Zwei-Finger-Scroll
     switch(gesture) {
         case TUCCursorGestureTap:               return TUCCursorActionClick;
@@ -549,18 +663,120 @@
 }
 
 
+/**
+ Where the cursor should be for the touch in a slot (relative screen coordinates). A moving finger is extrapolated to the time the
+ event takes effect, now plus predictionHorizon. Clicks, scrolling and the last sample of a touch always use the measured location.
+ */
+- (CGPoint)predictedLocationForSlot:(NSInteger)slot {
+    CGPoint location = _touchTable.location[slot];
+    NSTimeInterval horizon = self.predictionHorizon;
+    
+    if (horizon <= 0 || _touchTable.phase[slot] != NSTouchPhaseMoved) {
+        return location;
+    }
+    
+    // the touch timestamps are on the mach_absolute_time timeline
+    NSTimeInterval now = (NSTimeInterval)clock_gettime_nsec_np(CLOCK_UPTIME_RAW) / NSEC_PER_SEC;
+    double x = location.x;
+    double y = location.y;
+    TUCMotionPredictorPredict(&_motionPredictor, (int)slot, now + horizon, &x, &y);
+    
+    return CGPointMake(x, y);
+}
+
+
+
 #pragma mark - Touch Set
 
 /**
- The `touchSet` can contain touches whose phase is ended or cancelled. activeTouches. filteres those out
+ The changes collected since the last call as contact IDs, nil if nothing happened.
  */
-- (NSSet<TUCTouch *> *)activeTouches {
-    NSPredicate *p1 = [NSPredicate predicateWithFormat:@"phase != %d", NSTouchPhaseEnded];
-    NSPredicate *p2 = [NSPredicate predicateWithFormat:@"phase != %d", NSTouchPhaseCancelled];
+- (nullable TUCTouchChanges *)takeTouchChanges {
+    if ((_addedSlots | _movedSlots | _endedSlots) == 0) {
+        return nil;
+    }
     
-    NSPredicate *predicate = [NSCompoundPredicate andPredicateWithSubpredicates:@[p1, p2]];
+    TUCTouchChanges *changes = [[TUCTouchChanges alloc] initWithAddedContactIDs:[self contactIDsOfSlots:_addedSlots]
+                                                                movedContactIDs:[self contactIDsOfSlots:_movedSlots & ~_endedSlots]
+                                                                endedContactIDs:[self contactIDsOfSlots:_endedSlots]];
+    _addedSlots = 0;
+    _movedSlots = 0;
+    _endedSlots = 0;
+    return changes;
+}
+
+
+- (NSIndexSet *)contactIDsOfSlots:(TUCTouchMask)slots {
+    NSMutableIndexSet *contactIDs = [NSMutableIndexSet indexSet];
+    for (TUCTouchMask mask = slots; mask != 0; mask &= mask - 1) {
+        [contactIDs addIndex:(NSUInteger)_touchTable.contactID[TUCTouchMaskFirst(mask)]];
+    }
+    return contactIDs;
+}
+
+
+/**
+ Writes the touches of this frame into the write buffer and hands it to the reader, once per frame on the inputQueue.
+ */
+- (void)publishTouchSnapshot {
+    TUCTouchSnapshot *snapshot = &_snapshots[_snapshotWriteIndex];
+    
+    snapshot->frameID = self.currentFrameID;
+    snapshot->timestamp = self.frameTimestamp;
+    snapshot->count = 0;
+    for (TUCTouchMask mask = TUCTouchTableUsedMask(&_touchTable); mask != 0; mask &= mask - 1) {
+        TUCTouchTableGetRecord(&_touchTable, TUCTouchMaskFirst(mask), &snapshot->touches[snapshot->count++]);
+    }
+    
+    // release: the records are visible before the reader can acquire the buffer
+    uint32_t previous = atomic_exchange_explicit(&_snapshotExchange, _snapshotWriteIndex | kSnapshotFresh, memory_order_acq_rel);
+    _snapshotWriteIndex = previous & kSnapshotIndexMask;
+}
+
+
+- (const TUCTouchSnapshot *)acquireTouchSnapshot {
+    if (atomic_load_explicit(&_snapshotExchange, memory_order_relaxed) & kSnapshotFresh) {
+        uint32_t previous = atomic_exchange_explicit(&_snapshotExchange, _snapshotReadIndex, memory_order_acq_rel);
+        _snapshotReadIndex = previous & kSnapshotIndexMask;
+    }
+    return &_snapshots[_snapshotReadIndex];
+}
+
+
+/**
+ Tells the delegate on the main thread what changed, at most once per frame.
+ */
+- (void)notifyTouchesDidChange:(TUCTouchChanges *)changes {
+    __weak typeof(self) weakSelf = self;
+    dispatch_async(dispatch_get_main_queue(), ^{
+        [weakSelf.delegate touchesDidChange:changes];
+    });
+}
+
+
+/**
+ Compatibility view of the latest snapshot, rebuilt on the first access after a new frame was published.
+ */
+- (NSSet<TUCTouch *> *)touchSet {
+    const TUCTouchSnapshot *snapshot = [self acquireTouchSnapshot];
+    if (_touchSet && snapshot->frameID == _touchSetFrameID) {
+        return _touchSet;
+    }
     
-    return [self.touchSet filteredSetUsingPredicate:predicate];
+    NSMutableDictionary<NSNumber *, TUCTouch *> *touches = [NSMutableDictionary dictionaryWithCapacity:snapshot->count];
+    for (NSUInteger i = 0; i < snapshot->count; i++) {
+        const TUCTouchRecord *record = &snapshot->touches[i];
+        NSNumber *serial = @(record->serial);
+        
+        TUCTouch *touch = _compatibilityTouches[serial] ?: [[TUCTouch alloc] initWithContactID:record->contactID];
+        [touch updateWithTouchRecord:record];
+        touches[serial] = touch;
+    }
+    
+    _compatibilityTouches = touches;
+    _touchSet = [NSSet setWithArray:touches.allValues];
+    _touchSetFrameID = snapshot->frameID;
+    return _touchSet;
 }
 
 
@@ -576,118 +792,143 @@
 /**
  maxDistance in mm
  */
-- (NSSet<TUCTouch *> *)touchesInProximityTo:(CGPoint)point maxDistance:(CGFloat)mmDistance {
+- (TUCTouchMask)touchesInProximityTo:(CGPoint)point maxDistance:(CGFloat)mmDistance {
     
     CGFloat screenDistance = mmDistance * [[self touchscreen] pixelsPerMM];
     CGPoint distance = CGPointMake(screenDistance /  [self touchscreen].frame.size.width,
                                    screenDistance /  [self touchscreen].frame.size.height);
     
-    NSPredicate * predicate = [NSPredicate predicateWithBlock: ^BOOL(TUCTouch *t, NSDictionary *bind) {
+    TUCTouchMask result = 0;
+    for (TUCTouchMask mask = TUCTouchTableUsedMask(&_touchTable); mask != 0; mask &= mask - 1) {
+        NSInteger slot = TUCTouchMaskFirst(mask);
         
-        CGFloat dx = [t location].x - point.x;
-        CGFloat dy = [t location].y - point.y;
+        CGFloat dx = _touchTable.location[slot].x - point.x;
+        CGFloat dy = _touchTable.location[slot].y - point.y;
         
-        return sqrt( pow(dx, 2) + pow(dy, 2) ) < distance.x;
-    }];
+        if (sqrt( pow(dx, 2) + pow(dy, 2) ) < distance.x) {
+            result |= 1ull << slot;
+        }
+    }
     
-    return [self.touchSet filteredSetUsingPredicate:predicate];
+    return result;
 }
 
 
 /**
- Removes a touch from the touch set. As a previous touch might be important for gesture evaluation, it is removed after half a second
+ Frees a slot of the touch table, the cursor and gesture touches forget it.
  */
-- (void)removeTouch:(TUCTouch *)touch now:(BOOL)instantDeletion{
-//    if (touch.uuid == self.touchUsedForCursor.uuid) {
-//        [self processTouchesForCursorInput];
-//        self.touchUsedForCursor = nil;
-//    }
-    
-    if (instantDeletion) {
-        [[self touchSet] removeObject:touch];
-        [[self delegate] touchesDidChange];
-        return;
-    }
+- (void)releaseSlot:(NSInteger)slot {
+    TUCTouchTableRemove(&_touchTable, slot);
     
-    __weak id weakSelf = self;
-    NSUUID *uuid = touch.uuid;
-    // CRITICAL FIX: 0.1s statt 0.5s - bei vielen Fingern (10+) war 0.5s zu lang
-    dispatch_after(dispatch_time(DISPATCH_TIME_NOW, NSEC_PER_SEC / 10), dispatch_get_main_queue(), ^{
-        for(TUCTouch *touch in [weakSelf touchSet]) {
-            if (touch.uuid == uuid && [[weakSelf touchSet] containsObject:touch]) {
-                printf("[DELAYED CLEANUP] contactID=%ld nach 0.1s entfernt\n", (long)touch.contactID);
-                [[weakSelf touchSet] removeObject:touch];
-                [[weakSelf delegate] touchesDidChange];
-                return;
+    TUCTouchMask keep = ~(1ull << slot);
+    _addedSlots &= keep;
+    _movedSlots &= keep;
+    _endedSlots &= keep;
+    
+    if (self.cursorSlot == slot) {
+        self.cursorSlot = kTUCTouchTableNoSlot;
+    }
+    if (self.gestureAdditionalSlot == slot) {
+        self.gestureAdditionalSlot = kTUCTouchTableNoSlot;
+    }
+}
+
+
+/**
+ Ended touches are not removed right away, a previous touch might be important for gesture evaluation.
+ The slot is freed by the sweep kEndedTouchRetireFrames frames later.
+ */
+- (void)retireTouchInSlot:(NSInteger)slot {
+    _touchTable.retireFrame[slot] = self.currentFrameID + kEndedTouchRetireFrames;
+}
+
+
+/**
+ Frees the slots of all ended touches that are due, once per frame. There are no timers, removal happens only here.
+ Returns YES if touches were removed.
+ */
+- (BOOL)sweepRetiredTouches {
+    TUCTouchTable *table = &_touchTable;
+    TUCTouchMask retired = 0;
+    
+    NSInteger touchSetSize = TUCTouchMaskCount(TUCTouchTableUsedMask(table));
+    NSInteger activeCount = TUCTouchMaskCount(table->activeMask);
+    
+    if (activeCount == 0 || touchSetSize > 10 || touchSetSize > activeCount + 3) {
+        // Keine aktiven Touches mehr → alles leeren, verhindert Ghost-Touches und garantiert sauberen Neustart
+        // Bei vielen Fingern nicht auf die Frist warten, damit das Set nicht auf 20+ Touches wächst
+        retired = table->endedMask;
+    } else {
+        for (TUCTouchMask mask = table->endedMask; mask != 0; mask &= mask - 1) {
+            NSInteger slot = TUCTouchMaskFirst(mask);
+            if (table->retireFrame[slot] <= self.currentFrameID) {
+                retired |= 1ull << slot;
             }
         }
-    });
+    }
+    
+    if (retired == 0) {
+        return NO;
+    }
+    
+    TUCLogDebug(Touch, "[RETIRE] %ld ENDED/CANC Touches entfernt (%ld total, %ld active)",
+                (long)TUCTouchMaskCount(retired), (long)touchSetSize, (long)activeCount);
+    for (TUCTouchMask mask = retired; mask != 0; mask &= mask - 1) {
+        NSInteger slot = TUCTouchMaskFirst(mask);
+        TUCLogTrace(Touch, "[RETIRE]   ID=%ld", (long)table->contactID[slot]);
+        [self releaseSlot:slot];
+    }
+    return YES;
 }
 
 
 /**
- Checks the touch set if a touch exists
+ Checks the touch set if a touch exists, returns its slot or kTUCTouchTableNoSlot
  */
-- (TUCTouch *)findTouchWithID:(NSInteger)contactID includingPastTouches:(BOOL)includePastTouches {
-    NSSet *set = includePastTouches ? self.touchSet : [self activeTouches];
+- (NSInteger)findTouchWithID:(NSInteger)contactID includingPastTouches:(BOOL)includePastTouches {
+    NSInteger slot = TUCTouchTableFind(&_touchTable, contactID);
     
-    NSPredicate *predicate = [NSPredicate predicateWithFormat:@"contactID == %d", contactID];
-    TUCTouch *touch = [[set filteredSetUsingPredicate:predicate] anyObject];
-    return touch;
+    if (!includePastTouches && !TUCTouchTableIsActive(&_touchTable, slot)) {
+        return kTUCTouchTableNoSlot;
+    }
+    return slot;
 }
 
 /**
- Returns the existing touch object or a new one if this ID does not exist in the set yet.
+ Returns the slot of the existing touch or of a new one if this ID does not exist in the set yet, kTUCTouchTableNoSlot if the table is full.
  CRITICAL: Wenn wir einen alten Touch mit der ID finden der ENDED/CANC ist, löschen wir ihn sofort
  */
-- (TUCTouch *)obtainTouchWithID:(NSInteger)contactID isNew:(BOOL*)isNew {
+- (NSInteger)obtainTouchWithID:(NSInteger)contactID isNew:(BOOL*)isNew {
     *isNew = NO;
+    TUCTouchTable *table = &_touchTable;
     
     // CRITICAL FIX: Suche nach vorhandenem Touch mit dieser ID
-    NSPredicate *predicate = [NSPredicate predicateWithFormat:@"contactID == %d", contactID];
-    TUCTouch *existingTouch = [[self.touchSet filteredSetUsingPredicate:predicate] anyObject];
+    NSInteger existingSlot = TUCTouchTableFind(table, contactID);
     
-    if (existingTouch) {
+    if (existingSlot != kTUCTouchTableNoSlot) {
         // Wenn der Touch ENDED oder CANCELLED ist → entfernen und neu erstellen
-        if (existingTouch.phase == NSTouchPhaseEnded || existingTouch.phase == NSTouchPhaseCancelled) {
-            printf("[CLEANUP OLD] Touch ID=%ld (phase=%ld) entfernt, wird neu erstellt\n", 
-                   (long)contactID, (long)existingTouch.phase);
-            [self.touchSet removeObject:existingTouch];
-            [[self delegate] touchesDidChange];
+        if (!TUCTouchTableIsActive(table, existingSlot)) {
+            TUCLogDebug(Touch, "[CLEANUP OLD] Touch ID=%ld (phase=%ld) entfernt, wird neu erstellt",
+                        (long)contactID, (long)table->phase[existingSlot]);
+            [self releaseSlot:existingSlot];
         } else {
             // Touch ist AKTIV (BEGAN/MOVED/STATIONARY) → wiederverwenden!
-            printf("[REUSE TOUCH] ID=%ld (phase=%ld) wird wiederverwendet\n", 
-                   (long)contactID, (long)existingTouch.phase);
-            return existingTouch;
+            TUCLogTrace(Touch, "[REUSE TOUCH] ID=%ld (phase=%ld) wird wiederverwendet",
+                        (long)contactID, (long)table->phase[existingSlot]);
+            return existingSlot;
         }
     }
     
-    // Bereinige auch ALLE anderen alten ENDED/CANC Touches (nicht die mit dieser ID - wurde schon erledigt)
-    NSMutableArray *touchesToRemove = [NSMutableArray array];
-    for (TUCTouch *t in self.touchSet) {
-        if ((t.phase == NSTouchPhaseEnded || t.phase == NSTouchPhaseCancelled) && t.contactID != contactID) {
-            [touchesToRemove addObject:t];
-        }
-    }
-    
-    if ([touchesToRemove count] > 0) {
-        printf("[CLEANUP ALL] %ld andere alte ENDED/CANC Touches entfernt: ", (long)[touchesToRemove count]);
-        for (TUCTouch *t in touchesToRemove) {
-            printf("ID=%ld ", (long)t.contactID);
-            [self.touchSet removeObject:t];
-        }
-        printf("\n");
-        [[self delegate] touchesDidChange];
-    }
-    
     // Jetzt neuen Touch erstellen
-    TUCTouch *touch = [[TUCTouch alloc] initWithContactID:contactID];
-    [self.touchSet addObject:touch];
-    *isNew = YES;
-    printf("[NEW TOUCH] ContactID=%ld erstellt (touchSet size=%ld)\n", 
-           (long)contactID, (long)[self.touchSet count]);
+    NSInteger slot = TUCTouchTableAdd(table, contactID);
+    if (slot != kTUCTouchTableNoSlot) {
+        TUCMotionPredictorReset(&_motionPredictor, (int)slot);
+        *isNew = YES;
+        TUCLogDebug(Touch, "[NEW TOUCH] ContactID=%ld erstellt (touchSet size=%ld)",
+                    (long)contactID, (long)TUCTouchMaskCount(TUCTouchTableUsedMask(table)));
+    }
     
-    return touch;
+    return slot;
 }
 
 
@@ -726,24 +967,51 @@
 
 
 
+/**
+ The copy of the touchscreen the inputQueue works with, see reloadConfiguration.
+ */
 - (TUCScreen *)touchscreen {
-    if (self.delegate != nil) {
-        return [self.delegate touchscreen];
+    return _screen;
+}
+
+
+
+- (void)setDelegate:(id<TUCTouchDelegate>)delegate {
+    _delegate = delegate;
+    [self reloadConfiguration];
+}
+
+
+- (void)reloadConfiguration {
+    NSAssert([NSThread isMainThread], @"the delegate and AppKit are only asked on the main thread");
+    
+    id<TUCTouchDelegate> delegate = self.delegate;
+    
+    TUCScreen *screen = delegate != nil ? [delegate touchscreen] : [[TUCScreen allScreens] firstObject];
+    screen = [screen copy];
+    CGFloat menuBarHeight = [[[NSApplication sharedApplication] mainMenu] menuBarHeight];
+    
+    TUCGestureActionMap gestureActions;
+    for (NSUInteger i = 0; i < kGestureActionCount; i++) {
+        TUCCursorGesture gesture = GestureOfActionIndex(i);
+        gestureActions.actions[i] = delegate != nil ? [delegate actionForGesture:gesture] : [self defaultActionForGesture:gesture];
     }
     
-    return [[TUCScreen allScreens] firstObject];
+    dispatch_async(self.inputQueue, ^{
+        self->_screen = screen;
+        self->_menuBarHeight = menuBarHeight;
+        self->_gestureActions = gestureActions;
+    });
 }
 
 
 
 - (BOOL)isPointInMenuBar:(CGPoint)point {
-    CGFloat menuBarHeight = [[[NSApplication sharedApplication] mainMenu] menuBarHeight];
-
     CGRect screenFrame = [self touchscreen].frame;
     CGRect menuBarFrame = CGRectMake(screenFrame.origin.x,
                                      screenFrame.origin.y * -1,
                                      screenFrame.size.width,
-                                     menuBarHeight);
+                                     _menuBarHeight);
     
     if (CGRectContainsPoint(menuBarFrame, point)) {
         return YES;
@@ -752,11 +1020,30 @@
 }
 
 
-- (BOOL)isLocationOutsideFrontmostWindow:(CGPoint)point {
+/**
+ The frontmost application is only known on the main thread: the check hops there, the click comes back to the inputQueue,
+ one main thread turn after the move.
+ */
+- (void)clickIfOutsideFrontmostWindow:(CGPoint)point {
+    NSTimeInterval timestamp = self.frameTimestamp;
     
-    if ([self isPointInMenuBar:point]) {
-        return NO;
-    }
+    dispatch_async(dispatch_get_main_queue(), ^{
+        if (![self isLocationOutsideFrontmostWindow:point]) {
+            return;
+        }
+        dispatch_async(self.inputQueue, ^{
+            TUCCursorUtilities *utils = [TUCCursorUtilities sharedInstance];
+            utils.inputTimestamp = timestamp;
+            [utils performClickAt:point];
+        });
+    });
+}
+
+
+/**
+ Main thread only.
+ */
+- (BOOL)isLocationOutsideFrontmostWindow:(CGPoint)point {
     
     pid_t frontmostPID = [[[NSWorkspace sharedWorkspace] frontmostApplication] processIdentifier];
     
@@ -819,17 +1106,36 @@
 
 - (instancetype)init {
     if(self = [super init]) {
-        self.touchSet = [NSMutableSet new];
+        TUCTouchTableInit(&_touchTable);
+        _snapshotWriteIndex = 0;
+        atomic_init(&_snapshotExchange, 1);
+        _snapshotReadIndex = 2;
+        for (int i = 0; i < 3; i++) {
+            _snapshots[i].frameID = -1;     // nothing published yet
+        }
+        TUCMotionPredictorInit(&_motionPredictor);
+        self.cursorSlot = kTUCTouchTableNoSlot;
+        self.gestureAdditionalSlot = kTUCTouchTableNoSlot;
+        
+        dispatch_queue_attr_t attributes = dispatch_queue_attr_make_with_qos_class(DISPATCH_QUEUE_SERIAL, QOS_CLASS_USER_INTERACTIVE, 0);
+        _inputQueue = dispatch_queue_create("de.schafe.TouchUp.input", attributes);
+        
+        _menuBarHeight = 0;
+        for (NSUInteger i = 0; i < kGestureActionCount; i++) {
+            _gestureActions.actions[i] = [self defaultActionForGesture:GestureOfActionIndex(i)];
+        }
+        
         self.postMouseEvents = YES;
         
         self.cursorTouchQualifiedForTap = NO;
-        self.cursorTouchStationarySinceDate = nil;
+        self.cursorTouchStationarySince = 0;
         
         self.currentFrameID = 0;
         self.identifiedMultitouchGesture = _TUCCursorGestureNone;
         
         self.doubleClickTolerance = 5;
         self.holdDuration = 0.08;
+        self.predictionHorizon = 0;
         self.errorResistance = 5;  // 5 frames minimal timeout
         
         self.ignoreOriginTouches = NO;
@@ -846,11 +1152,21 @@
 
 
 - (NSString *)debugDescription {
-    NSMutableString *str = [[NSString stringWithFormat:@"Touch Set contains %ld touches:{\n", [self.touchSet count]] mutableCopy];
+    NSMutableArray<TUCTouch *> *touches = [NSMutableArray array];
+    for (TUCTouchMask mask = TUCTouchTableUsedMask(&_touchTable); mask != 0; mask &= mask - 1) {
+        TUCTouchRecord record;
+        TUCTouchTableGetRecord(&_touchTable, TUCTouchMaskFirst(mask), &record);
+        
+        TUCTouch *touch = [[TUCTouch alloc] initWithContactID:record.contactID];
+        [touch updateWithTouchRecord:&record];
+        [touches addObject:touch];
+    }
+    
+    NSMutableString *str = [[NSString stringWithFormat:@"Touch Set contains %ld touches:{\n", [touches count]] mutableCopy];
     
-    for (TUCTouch *touch in [[self.touchSet allObjects] sortedArrayUsingSelector:@selector(compareWithAnotherTouch:)] ) {
+    for (TUCTouch *touch in [touches sortedArrayUsingSelector:@selector(compareWithAnotherTouch:)] ) {
         [str appendString: [NSString stringWithFormat:@"  %@", [touch debugDescription]] ];
-        if (touch.contactID == self.cursorTouch.contactID) {
+        if (self.cursorSlot != kTUCTouchTableNoSlot && touch.contactID == _touchTable.contactID[self.cursorSlot]) {
             [str appendString: @" <<<CURSOR>>>\n" ];
         } else {
             [str appendString: @"\n" ];
@@ -862,17 +1178,54 @@
 }
 
 - (void)triggerSystemAccessibilityAccessAlert {
-    CGPoint loc = [[TUCCursorUtilities sharedInstance] currentCursorLocation];
-    [[TUCCursorUtilities sharedInstance] moveCursorTo:loc];
+    [[TUCCursorUtilities sharedInstance] postCursorLocation];
+}
+
+
+
+#pragma mark - Input Pipeline
+
+- (id<TUCEventSink>)eventSink {
+    return [[TUCCursorUtilities sharedInstance] eventSink];
+}
+
+
+- (void)setEventSink:(id<TUCEventSink>)eventSink {
+    [[TUCCursorUtilities sharedInstance] setEventSink:eventSink];
+}
+
+
+- (void)setInputDropPolicy:(TUCInputDropPolicy)inputDropPolicy {
+    HIDInterpreterSetDropPolicy(inputDropPolicy == TUCInputDropPolicyDropOldest ? HIDDropPolicyDropOldest : HIDDropPolicyPreserveAll);
+}
+
+- (TUCInputDropPolicy)inputDropPolicy {
+    return HIDInterpreterGetDropPolicy() == HIDDropPolicyDropOldest ? TUCInputDropPolicyDropOldest : TUCInputDropPolicyPreserveAll;
+}
+
+- (TUCInputStatistics)inputStatistics {
+    HIDInputStatistics statistics;
+    HIDInterpreterGetStatistics(&statistics);
+    
+    return (TUCInputStatistics) {
+        .queueDepth               = statistics.queueDepth,
+        .numQueueOverflows        = (NSUInteger)statistics.numQueueOverflows,
+        .numStaleReports          = (NSUInteger)statistics.numStaleReports,
+        .numDroppedFrames         = (NSUInteger)statistics.numDroppedFrames,
+        .numStalls                = (NSUInteger)statistics.numStalls,
+        .numSuppressedMoves       = (NSUInteger)statistics.numSuppressedMoves,
+        .numRejectedOversized     = (NSUInteger)statistics.numRejectedOversized,
+        .numRejectedLowConfidence = (NSUInteger)statistics.numRejectedLowConfidence,
+    };
 }
 
 
 
 #pragma mark - Bridge calls of C Header to Objective-C
 
-void TouchInputManagerUpdateTouchPosition(void *self, CFIndex contactID, CGFloat x, CGFloat y, Boolean onSurface, Boolean isValid) {
+void TouchInputManagerUpdateTouchPosition(void *self, CFIndex contactID, CGFloat x, CGFloat y, Boolean onSurface, Boolean isValid, uint64_t timestamp) {
     CGPoint point = CGPointMake(x, y);
-    [(__bridge id)self updateTouch:(NSInteger)contactID withLocation:point onSurface:onSurface tooLargeForFinger:isValid];
+    [(__bridge id)self updateTouch:(NSInteger)contactID withLocation:point onSurface:onSurface tooLargeForFinger:isValid timestamp:(NSTimeInterval)timestamp / NSEC_PER_SEC];
 }
 
 void TouchInputManagerUpdateTouchSize(void *self, CFIndex contactID, CGFloat width, CGFloat height, CGFloat azimuth) {
@@ -881,7 +1234,13 @@ void TouchInputManagerUpdateTouchSize(void *self, CFIndex contactID, CGFloat wid
 }
 
 void TouchInputManagerDidProcessReport(void *self) {
-    [(__bridge id)self didProcessReport];
+    TUCTouchInputManager *manager = (__bridge TUCTouchInputManager *)self;
+    manager.frameTimestamp = (NSTimeInterval)clock_gettime_nsec_np(CLOCK_UPTIME_RAW) / NSEC_PER_SEC;
+    [manager didProcessReport];
+}
+
+void TouchInputManagerProcessFrame(void *self, CFIndex device, const TouchInputManagerContact *contacts, CFIndex count, uint64_t timestamp) {
+    [(__bridge id)self processFrame:contacts count:(NSInteger)count device:(NSInteger)device timestamp:(NSTimeInterval)timestamp / NSEC_PER_SEC];
 }
 
 void TouchInputManagerDidConnectTouchscreen(void *self) {
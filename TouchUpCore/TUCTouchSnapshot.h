@@ -0,0 +1,50 @@
+//
+//  TUCTouchSnapshot.h
+//  Touch Up Core
+//
+//  Created by Touch Up contributors on 16.10.26.
+//
+
+#import <AppKit/AppKit.h>
+
+NS_ASSUME_NONNULL_BEGIN
+
+/*
+ Immutable picture of the touches after one frame, see `-[TUCTouchInputManager acquireTouchSnapshot]`.
+
+ The input manager publishes a snapshot once per frame into a triple buffer: it writes the next one while the reader still looks at
+ the previous one, so neither side ever waits or copies the other's data. Unlike `touchSet` there are no objects, only plain records.
+ */
+
+
+#define kTUCTouchSnapshotCapacity   64      // kTUCTouchTableCapacity
+
+
+typedef struct {
+    NSInteger       contactID;
+    NSUInteger      serial;             // counts up with every new touch, tells apart touches that reuse a contact ID
+
+    NSTouchPhase    phase;
+    NSTouchPhase    previousPhase;
+    CGPoint         location;           // relative screen coordinates
+    CGPoint         previousLocation;
+    NSTimeInterval  timestamp;          // when the digitizer sampled the touch, in seconds on the mach_absolute_time timeline
+    NSTimeInterval  previousTimestamp;
+    CGVector        velocity;           // per second
+
+    CGSize          size;               // relative to the screen, zero if the touchscreen does not report it
+    CGFloat         azimuth;
+    BOOL            isOnSurface;
+    BOOL            confidenceFlag;
+    NSInteger       lastUpdated;        // frame of the last update
+} TUCTouchRecord;
+
+
+typedef struct {
+    NSInteger       frameID;            // frame of the input manager the snapshot was taken after
+    NSTimeInterval  timestamp;          // when the digitizer sampled the frame, same timeline as the touches
+    NSUInteger      count;
+    TUCTouchRecord  touches[kTUCTouchSnapshotCapacity];     // active touches and ended ones that were not removed yet
+} TUCTouchSnapshot;
+
+NS_ASSUME_NONNULL_END
@@ -0,0 +1,123 @@
+//
+//  TUCTouchTable.h
+//  Touch Up Core
+//
+//  Created by Touch Up contributors on 16.10.26.
+//
+
+#import <AppKit/AppKit.h>
+
+#import "TUCTouch.h"
+#import "TUCTouchSnapshot.h"
+
+NS_ASSUME_NONNULL_BEGIN
+
+/*
+ Fixed-capacity table of the touches the input manager tracks, one slot per touch and one array per property.
+
+ A touch is found by its contact ID in O(1), the active and the ended touches are bitmasks over the slots. The gesture code works on
+ slot indices. Touches leave the table as plain records of a `TUCTouchSnapshot`.
+ */
+
+
+#define kTUCTouchTableCapacity      64      // active touches of all screens plus ended ones waiting for removal
+#define kTUCTouchTableMaxDirectID   512     // contact IDs below are looked up directly (4 screens × 100 IDs), others by a scan
+#define kTUCTouchTableNoSlot        (-1)
+
+
+typedef uint64_t TUCTouchMask;      // one bit per slot
+
+
+typedef struct {
+    TUCTouchMask activeMask;        // phase began, moved or stationary
+    TUCTouchMask endedMask;         // phase ended or cancelled, waiting for removal
+
+    int8_t slotForContactID[kTUCTouchTableMaxDirectID];
+    NSUInteger lastSerial;
+
+    // one entry per slot
+    NSInteger       contactID[kTUCTouchTableCapacity];
+    NSUInteger      serial[kTUCTouchTableCapacity];
+    CGPoint         location[kTUCTouchTableCapacity];
+    CGPoint         previousLocation[kTUCTouchTableCapacity];
+    NSTouchPhase    phase[kTUCTouchTableCapacity];
+    NSTouchPhase    previousPhase[kTUCTouchTableCapacity];
+    NSTimeInterval  timestamp[kTUCTouchTableCapacity];
+    NSTimeInterval  previousTimestamp[kTUCTouchTableCapacity];
+    CGVector        velocity[kTUCTouchTableCapacity];
+    NSInteger       lastUpdated[kTUCTouchTableCapacity];
+    NSInteger       device[kTUCTouchTableCapacity];         // touchscreen that reports the touch
+    NSInteger       deviceFrame[kTUCTouchTableCapacity];    // frame of that touchscreen at the last update, for the timeout
+    NSInteger       retireFrame[kTUCTouchTableCapacity];    // ended touches are freed by the sweep of this frame
+    CGSize          size[kTUCTouchTableCapacity];
+    CGFloat         azimuth[kTUCTouchTableCapacity];
+    BOOL            isOnSurface[kTUCTouchTableCapacity];
+    BOOL            confidenceFlag[kTUCTouchTableCapacity];
+} TUCTouchTable;
+
+
+
+static inline TUCTouchMask TUCTouchTableUsedMask(const TUCTouchTable *table) {
+    return table->activeMask | table->endedMask;
+}
+
+static inline BOOL TUCTouchTableIsActive(const TUCTouchTable *table, NSInteger slot) {
+    return slot >= 0 && (table->activeMask >> slot) & 1;
+}
+
+static inline NSInteger TUCTouchMaskCount(TUCTouchMask mask) {
+    return __builtin_popcountll(mask);
+}
+
+/**
+ Lowest slot of a non-empty mask. Iterate with `for (TUCTouchMask m = mask; m != 0; m &= m - 1) { NSInteger slot = TUCTouchMaskFirst(m); … }`
+ */
+static inline NSInteger TUCTouchMaskFirst(TUCTouchMask mask) {
+    return __builtin_ctzll(mask);
+}
+
+
+
+void TUCTouchTableInit(TUCTouchTable *table);
+
+/**
+ Slot of the touch with this contact ID, kTUCTouchTableNoSlot if there is none.
+ */
+NSInteger TUCTouchTableFind(const TUCTouchTable *table, NSInteger contactID);
+
+/**
+ Adds a touch in phase began, kTUCTouchTableNoSlot if the table is full. The contact ID must not be in the table yet.
+ */
+NSInteger TUCTouchTableAdd(TUCTouchTable *table, NSInteger contactID);
+
+void TUCTouchTableRemove(TUCTouchTable *table, NSInteger slot);
+
+void TUCTouchTableRemoveAll(TUCTouchTable *table);
+
+/**
+ Same as `-[TUCTouch setPhase:]`: remembers the previous phase and moves the slot between the active and ended masks.
+ */
+void TUCTouchTableSetPhase(TUCTouchTable *table, NSInteger slot, NSTouchPhase phase);
+
+/**
+ Same as `-[TUCTouch setLocation:timestamp:]`: remembers the previous sample and updates the velocity.
+ */
+void TUCTouchTableSetLocation(TUCTouchTable *table, NSInteger slot, CGPoint location, NSTimeInterval timestamp);
+
+/**
+ Copies the state of a slot into a snapshot record.
+ */
+void TUCTouchTableGetRecord(const TUCTouchTable *table, NSInteger slot, TUCTouchRecord *record);
+
+
+
+@interface TUCTouch (TUCTouchRecord)
+
+/**
+ Copies the state of a record into the touch object. The contact ID and UUID stay the object's own.
+ */
+- (void)updateWithTouchRecord:(const TUCTouchRecord *)record;
+
+@end
+
+NS_ASSUME_NONNULL_END
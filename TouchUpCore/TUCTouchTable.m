@@ -0,0 +1,148 @@
+//
+//  TUCTouchTable.m
+//  Touch Up Core
+//
+//  Created by Touch Up contributors on 16.10.26.
+//
+
+#import "TUCTouchTable.h"
+
+
+void TUCTouchTableInit(TUCTouchTable *table) {
+    memset(table, 0, sizeof(TUCTouchTable));
+    memset(table->slotForContactID, kTUCTouchTableNoSlot, sizeof(table->slotForContactID));
+}
+
+
+static BOOL IsDirectID(NSInteger contactID) {
+    return contactID >= 0 && contactID < kTUCTouchTableMaxDirectID;
+}
+
+
+NSInteger TUCTouchTableFind(const TUCTouchTable *table, NSInteger contactID) {
+    if (IsDirectID(contactID)) {
+        return table->slotForContactID[contactID];
+    }
+
+    // IDs outside the direct range only come from the hardware ID fallback of the HID layer
+    for (TUCTouchMask mask = TUCTouchTableUsedMask(table); mask != 0; mask &= mask - 1) {
+        NSInteger slot = TUCTouchMaskFirst(mask);
+        if (table->contactID[slot] == contactID) {
+            return slot;
+        }
+    }
+    return kTUCTouchTableNoSlot;
+}
+
+
+NSInteger TUCTouchTableAdd(TUCTouchTable *table, NSInteger contactID) {
+    TUCTouchMask freeMask = ~TUCTouchTableUsedMask(table);
+    if (freeMask == 0) {
+        return kTUCTouchTableNoSlot;
+    }
+
+    NSInteger slot = TUCTouchMaskFirst(freeMask);
+
+    // same initial state as -[TUCTouch initWithContactID:]
+    table->contactID[slot] = contactID;
+    table->serial[slot] = ++table->lastSerial;
+    table->location[slot] = CGPointZero;
+    table->previousLocation[slot] = CGPointZero;
+    table->phase[slot] = NSTouchPhaseBegan;
+    table->previousPhase[slot] = NSTouchPhaseBegan;
+    table->timestamp[slot] = 0;
+    table->previousTimestamp[slot] = 0;
+    table->velocity[slot] = CGVectorMake(0, 0);
+    table->lastUpdated[slot] = 0;
+    table->device[slot] = 0;
+    table->deviceFrame[slot] = 0;
+    table->retireFrame[slot] = 0;
+    table->size[slot] = CGSizeZero;
+    table->azimuth[slot] = 0;
+    table->isOnSurface[slot] = YES;
+    table->confidenceFlag[slot] = NO;
+
+    table->activeMask |= 1ull << slot;
+    if (IsDirectID(contactID)) {
+        table->slotForContactID[contactID] = (int8_t)slot;
+    }
+
+    return slot;
+}
+
+
+void TUCTouchTableRemove(TUCTouchTable *table, NSInteger slot) {
+    TUCTouchMask bit = 1ull << slot;
+    if (!(TUCTouchTableUsedMask(table) & bit)) {
+        return;
+    }
+
+    table->activeMask &= ~bit;
+    table->endedMask &= ~bit;
+
+    NSInteger contactID = table->contactID[slot];
+    if (IsDirectID(contactID) && table->slotForContactID[contactID] == slot) {
+        table->slotForContactID[contactID] = kTUCTouchTableNoSlot;
+    }
+}
+
+
+void TUCTouchTableRemoveAll(TUCTouchTable *table) {
+    for (TUCTouchMask mask = TUCTouchTableUsedMask(table); mask != 0; mask &= mask - 1) {
+        TUCTouchTableRemove(table, TUCTouchMaskFirst(mask));
+    }
+}
+
+
+
+void TUCTouchTableSetPhase(TUCTouchTable *table, NSInteger slot, NSTouchPhase phase) {
+    table->previousPhase[slot] = table->phase[slot];
+    table->phase[slot] = phase;
+
+    TUCTouchMask bit = 1ull << slot;
+    if (phase == NSTouchPhaseEnded || phase == NSTouchPhaseCancelled) {
+        table->activeMask &= ~bit;
+        table->endedMask |= bit;
+    } else {
+        table->activeMask |= bit;
+        table->endedMask &= ~bit;
+    }
+}
+
+
+void TUCTouchTableSetLocation(TUCTouchTable *table, NSInteger slot, CGPoint location, NSTimeInterval timestamp) {
+    BOOL hasPreviousSample = table->timestamp[slot] > 0;
+
+    table->previousLocation[slot] = table->location[slot];
+    table->location[slot] = location;
+    table->previousTimestamp[slot] = table->timestamp[slot];
+    table->timestamp[slot] = timestamp;
+
+    // the first sample has no velocity, neither has a repeated sample of the same frame
+    NSTimeInterval dt = timestamp - table->previousTimestamp[slot];
+    if (hasPreviousSample && dt > 0) {
+        table->velocity[slot] = CGVectorMake((location.x - table->previousLocation[slot].x) / dt,
+                                             (location.y - table->previousLocation[slot].y) / dt);
+    }
+}
+
+
+
+void TUCTouchTableGetRecord(const TUCTouchTable *table, NSInteger slot, TUCTouchRecord *record) {
+    record->contactID = table->contactID[slot];
+    record->serial = table->serial[slot];
+
+    record->phase = table->phase[slot];
+    record->previousPhase = table->previousPhase[slot];
+    record->location = table->location[slot];
+    record->previousLocation = table->previousLocation[slot];
+    record->timestamp = table->timestamp[slot];
+    record->previousTimestamp = table->previousTimestamp[slot];
+    record->velocity = table->velocity[slot];
+
+    record->size = table->size[slot];
+    record->azimuth = table->azimuth[slot];
+    record->isOnSurface = table->isOnSurface[slot];
+    record->confidenceFlag = table->confidenceFlag[slot];
+    record->lastUpdated = table->lastUpdated[slot];
+}
@@ -17,5 +17,8 @@ FOUNDATION_EXPORT const unsigned char TouchUpCoreVersionString[];
 #import<TouchUpCore/TUCTouchInputManager.h>
 #import<TouchUpCore/TUCTouchDelegate.h>
 #import<TouchUpCore/TUCTouch.h>
+#import<TouchUpCore/TUCTouchChanges.h>
+#import<TouchUpCore/TUCTouchSnapshot.h>
+#import<TouchUpCore/TUCEventSink.h>
 #import<TouchUpCore/TUCScreen.h>
 